@@ -0,0 +1,710 @@
+/**
+ * @file
+ * Binary session cache of the \e ExperimentReader class.
+ * The native session model (topics per section and contribution tables
+ * per speaker) is written to a cache file in the user's cache directory
+ * after a session has been read. Later instances map the cache file into
+ * memory instead of parsing the XML file again, as long as the cache file
+ * was built from the same file contents.
+ * The file contents are only hashed if the file's size or modification
+ * time differs from the cache file's.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "experiment-reader.h"
+#include "experiment-reader-private.h"
+
+/** @private */
+#define CACHE_DIRECTORY		"libexperiment-reader"
+/** @private */
+#define CACHE_MAGIC		"EXPRDRC"
+/**
+ * @private
+ * Version of the cache file format.
+ * Must be incremented whenever the file format or the semantics of the
+ * native session model change.
+ */
+#define CACHE_VERSION		3
+/** @private */
+#define CACHE_BYTE_ORDER	0x01020304
+
+/** @private */
+#define CACHE_NULL_STRING	G_MAXUINT32
+
+/**
+ * @private
+ * Cache files not used for this long are removed when writing a cache file
+ */
+#define CACHE_MAX_AGE		(30*24*60*60)	/* seconds */
+/**
+ * @private
+ * Maximum number of cache files, the least recently used ones are removed
+ * when writing a cache file
+ */
+#define CACHE_MAX_FILES		256
+
+/** @private */
+#define CACHE_ALIGN(OFFSET) \
+	(((OFFSET) + 7) & ~(guint64)7)
+
+/**
+ * @private
+ * Cache file header. All offsets are relative to the beginning of the
+ * file and aligned to 8 bytes. All numbers are in host byte order.
+ */
+typedef struct _CacheHeader {
+	gchar	magic[8];
+	guint32	version;
+	guint32	byte_order;
+
+	guint64	xml_size;
+	gint64	xml_mtime;
+	guint8	xml_digest[24];		/**< SHA1 digest (padded) */
+
+	guint64	strings_offset;		/**< Blob of null-terminated strings */
+	guint64	strings_size;
+
+	guint64	topics_offset;		/**< Array of \ref CacheTopic */
+	guint32	n_topics[EXPERIMENT_READER_SECTION_COUNT];
+
+	guint32	n_speakers;
+	guint64	speakers_offset;	/**< Array of \ref CacheSpeaker */
+} CacheHeader;
+
+/** @private */
+typedef struct _CacheTopic {
+	guint32	id;			/**< Offset into strings blob */
+	guint32	pad;
+	gint64	start_time;
+	gint64	end_time;
+} CacheTopic;
+
+/** @private */
+typedef struct _CacheSpeaker {
+	guint32	name;			/**< Offset into strings blob */
+	guint32	n_contribs;
+	guint64	start_times_offset;	/**< Array of gint64 */
+	guint64	end_times_offset;	/**< Array of gint64 */
+	guint64	max_end_tree_offset;	/**< Array of gint64 */
+	guint64	text_offsets_offset;	/**< Array of guint32 */
+	guint64	text_offset;		/**< Contribution text blob */
+	guint64	text_size;
+} CacheSpeaker;
+
+/** @private */
+typedef struct _CacheWriter {
+	GByteArray	*buffer;
+	GString		*strings;
+	/** Strings mapped to their offsets in \e strings (plus 1) */
+	GHashTable	*string_offsets;
+} CacheWriter;
+
+static gchar *get_cache_filename(const gchar *filename);
+static gboolean compute_key(const gchar *filename,
+			    ExperimentReaderCacheKey *key);
+static gboolean compute_digest(const gchar *filename,
+			       ExperimentReaderCacheKey *key);
+static gboolean check_key(const gchar *data, const gchar *filename,
+			  ExperimentReaderCacheKey *key);
+static inline gboolean check_range(gsize length, guint64 offset,
+				   guint64 size);
+static gboolean validate_cache(const gchar *data, gsize length);
+static gint cache_file_cmp(gconstpointer a, gconstpointer b);
+static void prune_cache(const gchar *dirname);
+
+static guint64 writer_append(CacheWriter *writer, gconstpointer data,
+			     guint64 size);
+static guint32 writer_add_string(CacheWriter *writer, const gchar *str);
+
+/**
+ * @brief Get name of cache file for a session file
+ *
+ * Cache files are named after the SHA1 digest of the session file's
+ * absolute path.
+ *
+ * @param filename Session filename
+ * @return Newly allocated cache filename
+ */
+static gchar *
+get_cache_filename(const gchar *filename)
+{
+	gchar *abs_filename, *digest, *basename, *ret;
+
+	if (g_path_is_absolute(filename)) {
+		abs_filename = g_strdup(filename);
+	} else {
+		gchar *cwd = g_get_current_dir();
+
+		abs_filename = g_build_filename(cwd, filename, NULL);
+		g_free(cwd);
+	}
+
+	digest = g_compute_checksum_for_string(G_CHECKSUM_SHA1,
+					       abs_filename, -1);
+	basename = g_strconcat(digest, ".cache", NULL);
+	ret = g_build_filename(g_get_user_cache_dir(), CACHE_DIRECTORY,
+			       basename, NULL);
+
+	g_free(basename);
+	g_free(digest);
+	g_free(abs_filename);
+
+	return ret;
+}
+
+/**
+ * @brief Compute cache key of a session file
+ *
+ * Only the file's size and modification time are determined,
+ * its digest is computed by \ref compute_digest when necessary.
+ *
+ * @param filename Session filename
+ * @param key      Cache key to initialize
+ * @return \c TRUE on success, else \c FALSE (\e key is invalid)
+ */
+static gboolean
+compute_key(const gchar *filename, ExperimentReaderCacheKey *key)
+{
+	struct stat buf;
+
+	memset(key, 0, sizeof(*key));
+
+	if (g_stat(filename, &buf))
+		return FALSE;
+	key->size = buf.st_size;
+	key->mtime = buf.st_mtime;
+
+	key->valid = TRUE;
+	return TRUE;
+}
+
+/**
+ * @brief Compute digest of a session file's contents for its cache key
+ *
+ * @param filename Session filename
+ * @param key      Valid cache key of session file
+ * @return \c TRUE on success, else \c FALSE
+ */
+static gboolean
+compute_digest(const gchar *filename, ExperimentReaderCacheKey *key)
+{
+	GMappedFile *file;
+	GChecksum *checksum;
+	gsize digest_len = sizeof(key->digest);
+
+	if (key->has_digest)
+		return TRUE;
+
+	file = g_mapped_file_new(filename, FALSE, NULL);
+	if (file == NULL)
+		return FALSE;
+
+	checksum = g_checksum_new(G_CHECKSUM_SHA1);
+	if (g_mapped_file_get_length(file) > 0)
+		g_checksum_update(checksum,
+				  (const guchar *)g_mapped_file_get_contents(file),
+				  g_mapped_file_get_length(file));
+	g_checksum_get_digest(checksum, key->digest, &digest_len);
+	g_checksum_free(checksum);
+
+	g_mapped_file_unref(file);
+
+	key->has_digest = TRUE;
+	return TRUE;
+}
+
+/**
+ * @brief Check whether a cache file was built from a session file
+ *
+ * If the session file's size and modification time are unchanged,
+ * its contents are not hashed.
+ * The size is compared first, since files of different size cannot
+ * have the same contents.
+ *
+ * @param data     Valid cache file contents
+ * @param filename Session filename
+ * @param key      Cache key of session file, its digest may be computed
+ * @return \c TRUE if the cache file is up to date, else \c FALSE
+ */
+static gboolean
+check_key(const gchar *data, const gchar *filename,
+	  ExperimentReaderCacheKey *key)
+{
+	const CacheHeader *header = (const CacheHeader *)data;
+
+	if (header->xml_size != key->size)
+		return FALSE;
+	if (header->xml_mtime == key->mtime)
+		return TRUE;
+
+	/* e.g. touched or copied without preserving times */
+	return compute_digest(filename, key) &&
+	       !memcmp(header->xml_digest, key->digest, sizeof(key->digest));
+}
+
+static inline gboolean
+check_range(gsize length, guint64 offset, guint64 size)
+{
+	return offset <= length && size <= length - offset;
+}
+
+/**
+ * @brief Check cache file contents for consistency
+ *
+ * Since cache files are never trusted, all offsets are checked to lie
+ * within the file and all strings are checked to be null-terminated.
+ *
+ * @param data   Cache file contents
+ * @param length Length of \e data in bytes
+ * @return \c TRUE if the cache file is valid, else \c FALSE
+ */
+static gboolean
+validate_cache(const gchar *data, gsize length)
+{
+	const CacheHeader *header = (const CacheHeader *)data;
+	const CacheTopic *topics;
+	const CacheSpeaker *speakers;
+	const gchar *strings;
+	guint64 n_topics = 0;
+
+	if (length < sizeof(CacheHeader) ||
+	    memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) ||
+	    header->version != CACHE_VERSION ||
+	    header->byte_order != CACHE_BYTE_ORDER)
+		return FALSE;
+
+	if (!check_range(length, header->strings_offset,
+			 header->strings_size) ||
+	    !header->strings_size)
+		return FALSE;
+	strings = data + header->strings_offset;
+	if (strings[header->strings_size - 1] != '\0')
+		return FALSE;
+
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+		n_topics += header->n_topics[i];
+	if (header->topics_offset % 8 ||
+	    !check_range(length, header->topics_offset,
+			 n_topics*sizeof(CacheTopic)))
+		return FALSE;
+	topics = (const CacheTopic *)(data + header->topics_offset);
+	for (guint64 i = 0; i < n_topics; i++)
+		if (topics[i].id != CACHE_NULL_STRING &&
+		    topics[i].id >= header->strings_size)
+			return FALSE;
+
+	if (header->speakers_offset % 8 ||
+	    !check_range(length, header->speakers_offset,
+			 (guint64)header->n_speakers*sizeof(CacheSpeaker)))
+		return FALSE;
+	speakers = (const CacheSpeaker *)(data + header->speakers_offset);
+	for (guint i = 0; i < header->n_speakers; i++) {
+		const CacheSpeaker *speaker = speakers + i;
+		const guint32 *text_offsets;
+
+		if (speaker->name >= header->strings_size ||
+		    speaker->start_times_offset % 8 ||
+		    !check_range(length, speaker->start_times_offset,
+				 (guint64)speaker->n_contribs*sizeof(gint64)) ||
+		    speaker->end_times_offset % 8 ||
+		    !check_range(length, speaker->end_times_offset,
+				 (guint64)speaker->n_contribs*sizeof(gint64)) ||
+		    speaker->max_end_tree_offset % 8 ||
+		    !check_range(length, speaker->max_end_tree_offset,
+				 (guint64)experiment_reader_interval_tree_size(speaker->n_contribs)*
+				 sizeof(gint64)) ||
+		    speaker->text_offsets_offset % 8 ||
+		    !check_range(length, speaker->text_offsets_offset,
+				 (guint64)speaker->n_contribs*sizeof(guint32)) ||
+		    !check_range(length, speaker->text_offset,
+				 speaker->text_size))
+			return FALSE;
+
+		if (!speaker->n_contribs)
+			continue;
+		if (data[speaker->text_offset + speaker->text_size - 1] != '\0')
+			return FALSE;
+
+		text_offsets = (const guint32 *)(data +
+						 speaker->text_offsets_offset);
+		for (guint j = 0; j < speaker->n_contribs; j++)
+			if (text_offsets[j] >= speaker->text_size)
+				return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * @private
+ * @brief Load native session model from cache file
+ *
+ * The cache file is mapped into memory. Topic Ids, speaker names and
+ * contribution tables point into the mapping, so loading does not
+ * depend on the number of contributions.
+ *
+ * If the cache file was built from the same contents but the session
+ * file's modification time changed, the cache file is rewritten, so
+ * the contents do not have to be hashed again.
+ * Using a cache file updates its modification time, which is used for
+ * removing unused cache files.
+ *
+ * @param reader   \e ExperimentReader instance without document
+ * @param filename Session filename
+ * @param key      Cache key to initialize for the session file
+ *                 (for \ref experiment_reader_cache_save).
+ *                 Its digest is computed if the session is not loaded.
+ * @return \c TRUE if the session was loaded from an up to date cache file,
+ *         else \c FALSE (\e reader is unchanged)
+ */
+G_GNUC_INTERNAL gboolean
+experiment_reader_cache_load(ExperimentReader *reader, const gchar *filename,
+			     ExperimentReaderCacheKey *key)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
+
+	gchar *cache_filename;
+	GMappedFile *cache;
+	const gchar *data, *strings;
+	const CacheHeader *header;
+	const CacheTopic *topic;
+	const CacheSpeaker *speakers;
+
+	if (!compute_key(filename, key))
+		return FALSE;
+
+	cache_filename = get_cache_filename(filename);
+	cache = g_mapped_file_new(cache_filename, FALSE, NULL);
+	if (cache == NULL) {
+		g_free(cache_filename);
+		/* the cache file will be written */
+		compute_digest(filename, key);
+		return FALSE;
+	}
+
+	data = g_mapped_file_get_contents(cache);
+	if (data == NULL ||
+	    !validate_cache(data, g_mapped_file_get_length(cache)) ||
+	    !check_key(data, filename, key)) {
+		g_mapped_file_unref(cache);
+		g_free(cache_filename);
+		compute_digest(filename, key);
+		return FALSE;
+	}
+
+	/* mark cache file as recently used */
+	g_utime(cache_filename, NULL);
+	g_free(cache_filename);
+
+	header = (const CacheHeader *)data;
+	strings = data + header->strings_offset;
+
+	experiment_reader_native_init(reader);
+	priv->cache = cache;
+
+	topic = (const CacheTopic *)(data + header->topics_offset);
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++) {
+		g_array_set_size(priv->topics[i], header->n_topics[i]);
+
+		for (guint j = 0; j < header->n_topics[i]; j++, topic++) {
+			ExperimentReaderTopic *entry = &g_array_index(priv->topics[i],
+							   ExperimentReaderTopic, j);
+
+			entry->id = topic->id != CACHE_NULL_STRING
+					? strings + topic->id : NULL;
+			entry->start_time = topic->start_time;
+			entry->end_time = topic->end_time;
+		}
+	}
+
+	speakers = (const CacheSpeaker *)(data + header->speakers_offset);
+	for (guint i = 0; i < header->n_speakers; i++) {
+		const CacheSpeaker *speaker = speakers + i;
+		ExperimentReaderContribTable *table;
+
+		table = g_new(ExperimentReaderContribTable, 1);
+		table->n_contribs = speaker->n_contribs;
+		table->start_times = (gint64 *)(data +
+						speaker->start_times_offset);
+		table->end_times = (gint64 *)(data +
+					      speaker->end_times_offset);
+		table->max_end_tree = (gint64 *)(data +
+						 speaker->max_end_tree_offset);
+		table->text_offsets = (guint *)(data +
+						speaker->text_offsets_offset);
+		table->text = (gchar *)(data + speaker->text_offset);
+		table->ref_count = 1;
+		table->mapping = g_mapped_file_ref(cache);
+
+		g_hash_table_insert(priv->contrib_tables,
+				    (gpointer)(strings + speaker->name), table);
+	}
+
+	/* digest was computed and matched, avoid computing it again */
+	if (header->xml_mtime != key->mtime)
+		experiment_reader_cache_save(reader, filename, key);
+
+	return TRUE;
+}
+
+static guint64
+writer_append(CacheWriter *writer, gconstpointer data, guint64 size)
+{
+	static const guint8 padding[8] = {0};
+	guint64 offset = CACHE_ALIGN(writer->buffer->len);
+
+	g_byte_array_append(writer->buffer, padding,
+			    offset - writer->buffer->len);
+	if (size)
+		g_byte_array_append(writer->buffer, data, size);
+
+	return offset;
+}
+
+static guint32
+writer_add_string(CacheWriter *writer, const gchar *str)
+{
+	guint32 offset;
+
+	if (str == NULL)
+		return CACHE_NULL_STRING;
+
+	offset = GPOINTER_TO_UINT(g_hash_table_lookup(writer->string_offsets,
+						      str));
+	if (offset)
+		return offset - 1;
+
+	offset = writer->strings->len;
+	g_string_append_len(writer->strings, str, strlen(str) + 1);
+	g_hash_table_insert(writer->string_offsets, (gpointer)str,
+			    GUINT_TO_POINTER(offset + 1));
+
+	return offset;
+}
+
+/**
+ * @private
+ * @brief Write native session model to cache file
+ *
+ * The cache file is replaced atomically. Failing to write the cache file
+ * is not an error, it will simply be rewritten the next time.
+ *
+ * @param reader   \e ExperimentReader instance with native session model
+ * @param filename Session filename
+ * @param key      Cache key computed \b before reading the session file
+ * @return \c TRUE on success, else \c FALSE
+ */
+G_GNUC_INTERNAL gboolean
+experiment_reader_cache_save(ExperimentReader *reader, const gchar *filename,
+			     const ExperimentReaderCacheKey *key)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
+
+	CacheWriter writer;
+	CacheHeader header;
+	GArray *speakers;
+	GHashTableIter iter;
+	gpointer name, value;
+
+	gchar *cache_filename, *cache_dirname;
+	gboolean ret = FALSE;
+
+	if (!key->valid || !key->has_digest)
+		return FALSE;
+
+	writer.buffer = g_byte_array_new();
+	writer.strings = g_string_new(NULL);
+	writer.string_offsets = g_hash_table_new(g_str_hash, g_str_equal);
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.byte_order = CACHE_BYTE_ORDER;
+	header.xml_size = key->size;
+	header.xml_mtime = key->mtime;
+	memcpy(header.xml_digest, key->digest, sizeof(key->digest));
+
+	/* header is filled in later */
+	writer_append(&writer, &header, sizeof(header));
+
+	speakers = g_array_new(FALSE, FALSE, sizeof(CacheSpeaker));
+	g_hash_table_iter_init(&iter, priv->contrib_tables);
+	while (g_hash_table_iter_next(&iter, &name, &value)) {
+		ExperimentReaderContribTable *table = value;
+		CacheSpeaker speaker;
+		const gchar *text_end;
+
+		speaker.name = writer_add_string(&writer, name);
+		speaker.n_contribs = table->n_contribs;
+		speaker.start_times_offset =
+			writer_append(&writer, table->start_times,
+				      table->n_contribs*sizeof(gint64));
+		speaker.end_times_offset =
+			writer_append(&writer, table->end_times,
+				      table->n_contribs*sizeof(gint64));
+		speaker.max_end_tree_offset =
+			writer_append(&writer, table->max_end_tree,
+				      experiment_reader_interval_tree_size(table->n_contribs)*
+				      sizeof(gint64));
+		speaker.text_offsets_offset =
+			writer_append(&writer, table->text_offsets,
+				      table->n_contribs*sizeof(guint32));
+
+		/* text blob ends after the last contribution's text */
+		speaker.text_size = 0;
+		for (guint i = 0; i < table->n_contribs; i++) {
+			text_end = experiment_reader_contrib_table_get_text(table, i);
+			text_end += strlen(text_end) + 1;
+			speaker.text_size = MAX(speaker.text_size,
+						(guint64)(text_end - table->text));
+		}
+		speaker.text_offset = writer_append(&writer, table->text,
+						    speaker.text_size);
+
+		g_array_append_val(speakers, speaker);
+	}
+
+	header.topics_offset = writer_append(&writer, NULL, 0);
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++) {
+		header.n_topics[i] = priv->topics[i]->len;
+
+		for (guint j = 0; j < priv->topics[i]->len; j++) {
+			ExperimentReaderTopic *entry = &g_array_index(priv->topics[i],
+							   ExperimentReaderTopic, j);
+			CacheTopic topic;
+
+			topic.id = writer_add_string(&writer, entry->id);
+			topic.pad = 0;
+			topic.start_time = entry->start_time;
+			topic.end_time = entry->end_time;
+
+			g_byte_array_append(writer.buffer,
+					    (const guint8 *)&topic,
+					    sizeof(topic));
+		}
+	}
+
+	header.n_speakers = speakers->len;
+	header.speakers_offset = writer_append(&writer, speakers->data,
+					       speakers->len*sizeof(CacheSpeaker));
+
+	/* blob must not be empty */
+	g_string_append_c(writer.strings, '\0');
+	header.strings_size = writer.strings->len;
+	header.strings_offset = writer_append(&writer, writer.strings->str,
+					      writer.strings->len);
+
+	memcpy(writer.buffer->data, &header, sizeof(header));
+
+	cache_filename = get_cache_filename(filename);
+	cache_dirname = g_path_get_dirname(cache_filename);
+	if (!g_mkdir_with_parents(cache_dirname, 0700)) {
+		ret = g_file_set_contents(cache_filename,
+					  (const gchar *)writer.buffer->data,
+					  writer.buffer->len, NULL);
+		prune_cache(cache_dirname);
+	}
+	g_free(cache_dirname);
+	g_free(cache_filename);
+
+	g_array_free(speakers, TRUE);
+	g_hash_table_destroy(writer.string_offsets);
+	g_string_free(writer.strings, TRUE);
+	g_byte_array_free(writer.buffer, TRUE);
+
+	return ret;
+}
+
+/** @private Cache file found by \ref prune_cache */
+typedef struct _CacheFile {
+	gchar	*filename;
+	gint64	mtime;
+} CacheFile;
+
+static gint
+cache_file_cmp(gconstpointer a, gconstpointer b)
+{
+	const CacheFile *file_a = a, *file_b = b;
+
+	/* most recently used first */
+	return file_a->mtime < file_b->mtime ? 1
+					     : file_a->mtime > file_b->mtime ? -1 : 0;
+}
+
+/**
+ * @brief Remove unused cache files
+ *
+ * Cache files not used for \ref CACHE_MAX_AGE are removed, as well as
+ * the least recently used ones exceeding \ref CACHE_MAX_FILES.
+ * Errors are ignored.
+ *
+ * @param dirname Cache directory
+ */
+static void
+prune_cache(const gchar *dirname)
+{
+	GDir *dir;
+	const gchar *name;
+	GArray *files;
+	gint64 now = g_get_real_time()/G_USEC_PER_SEC;
+
+	dir = g_dir_open(dirname, 0, NULL);
+	if (dir == NULL)
+		return;
+
+	files = g_array_new(FALSE, FALSE, sizeof(CacheFile));
+	while ((name = g_dir_read_name(dir)) != NULL) {
+		CacheFile file;
+		struct stat buf;
+
+		if (!g_str_has_suffix(name, ".cache"))
+			continue;
+
+		file.filename = g_build_filename(dirname, name, NULL);
+		if (g_stat(file.filename, &buf)) {
+			g_free(file.filename);
+			continue;
+		}
+		file.mtime = buf.st_mtime;
+
+		g_array_append_val(files, file);
+	}
+	g_dir_close(dir);
+
+	g_array_sort(files, cache_file_cmp);
+
+	for (guint i = 0; i < files->len; i++) {
+		CacheFile *file = &g_array_index(files, CacheFile, i);
+
+		if (i >= CACHE_MAX_FILES || now - file->mtime > CACHE_MAX_AGE)
+			g_unlink(file->filename);
+		g_free(file->filename);
+	}
+
+	g_array_free(files, TRUE);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file
+ * Private header for the \e ExperimentReader class
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EXPERIMENT_READER_PRIVATE_H
+#define __EXPERIMENT_READER_PRIVATE_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libxml/tree.h>
+
+#include "experiment-reader.h"
+
+/** @private */
+#define XML_CHAR(STR) \
+	((const xmlChar *)(STR))
+
+/** @private */
+#define EXPERIMENT_READER_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE((obj), EXPERIMENT_TYPE_READER, ExperimentReaderPrivate))
+
+/** @private */
+typedef struct _ContribEntry {
+	gint64	start_time;	/**< Contribution's start time in milliseconds */
+	gint64	end_time;	/**< Contribution's end time in milliseconds */
+	guint	text_offset;	/**< Offset of contribution text in text blob */
+	guint	index;		/**< Position in document order */
+} ContribEntry;
+
+/** @private */
+typedef struct _TopicIndexEntry {
+	const ExperimentReaderTopic	*topic;
+	ExperimentReaderSection		section;
+} TopicIndexEntry;
+
+/**
+ * @private
+ * Interval index over all topics of a session structure with a valid
+ * time range. Topics are sorted by start time and a tree of maximum end
+ * times is kept over them, so that intervals containing a point or
+ * overlapping a range can be found in O(log n).
+ *
+ * @sa experiment_reader_interval_tree_size
+ */
+struct _ExperimentReaderTopicIndex {
+	guint				n_topics;
+	gint64				*start_times;
+	gint64				*end_times;
+	gint64				*max_end_tree;
+	const ExperimentReaderTopic	**topics;
+	ExperimentReaderSection		*sections;
+};
+
+/**
+ * @private
+ * Builds the contributions of one speaker. The text of the current
+ * contribution is assembled at the end of the text blob.
+ */
+typedef struct _ContribCollector {
+	GArray	*entries;	/**< Array of \ref ContribEntry */
+	GString	*text;		/**< Blob of null-terminated contribution texts */
+	gssize	text_start;	/**< Start of current contribution's text in blob or -1 */
+} ContribCollector;
+
+/**
+ * @private
+ * Identifies the contents of a session file a cache file was built from
+ */
+typedef struct _ExperimentReaderCacheKey {
+	gboolean	valid;		/**< Whether the key could be computed */
+	guint64		size;		/**< File size in bytes */
+	gint64		mtime;		/**< Modification time */
+	gboolean	has_digest;	/**< Whether \e digest was computed */
+	guint8		digest[20];	/**< SHA1 digest of file contents */
+} ExperimentReaderCacheKey;
+
+/**
+ * @private
+ * Private instance attribute structure.
+ * You can access these attributes using \c klass->priv->attribute.
+ */
+struct _ExperimentReaderPrivate {
+	/*
+	 * Parsed document, queried using XPath.
+	 * NULL if the session was loaded into the native model
+	 * (EXPERIMENT_READER_FLAG_STREAMING).
+	 */
+	xmlDoc		*doc;
+
+	/*
+	 * Timeline index, mapping timepoint Ids to absolute times
+	 * in milliseconds. Keys are owned by timeline_ids, values
+	 * are indexes into timeline_times (plus 1).
+	 */
+	GHashTable	*timeline;
+	GStringChunk	*timeline_ids;
+	GArray		*timeline_times;
+
+	/*
+	 * Native session model
+	 */
+	GStringChunk	*strings;
+	/**
+	 * Arrays of \ref ExperimentReaderTopic per \ref ExperimentReaderSection.
+	 * Topic Ids are owned by the string chunk or cache file.
+	 */
+	GArray		*topics[EXPERIMENT_READER_SECTION_COUNT];
+	/** Session structure pointing into \e topics (built on demand) */
+	ExperimentReaderStructure *structure;
+	/** Speaker names mapped to \ref ExperimentReaderContribTable */
+	GHashTable	*contrib_tables;
+	/*
+	 * Cache file the native model was loaded from or NULL.
+	 * Strings and contribution tables may point into it.
+	 */
+	GMappedFile	*cache;
+};
+
+/**
+ * @private
+ * Convert value of \b absolute-time attribute (seconds) to milliseconds
+ */
+static inline gint64
+experiment_reader_parse_time(const gchar *absolute_time)
+{
+	return absolute_time != NULL
+		? (gint64)(g_ascii_strtod(absolute_time, NULL)*1000.)
+		: -1;
+}
+
+/**
+ * @private
+ * Get number of elements of a tree of maximum end times over \e n
+ * intervals.
+ *
+ * The tree is a complete binary tree stored as an array (the first
+ * element is unused). Node \e v has the children \e 2v and \e 2v+1.
+ * Its leaves are the intervals' end times, so only the inner nodes are
+ * stored, each one the maximum of its children.
+ */
+static inline guint
+experiment_reader_interval_tree_size(guint n)
+{
+	guint size = 1;
+
+	while (size < n)
+		size <<= 1;
+
+	return size;
+}
+
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_timeline_init(ExperimentReader *reader);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_timeline_add(ExperimentReader *reader,
+				    const gchar *id, gint64 time);
+/** @private */
+G_GNUC_INTERNAL
+gint64 experiment_reader_timeline_lookup(ExperimentReader *reader,
+					 const gchar *ref);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_timeline_free(ExperimentReader *reader);
+
+/** @private */
+G_GNUC_INTERNAL
+ContribCollector *experiment_reader_contrib_collector_new(void);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_contrib_collector_append_text(ContribCollector *collector,
+						     const gchar *content);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_contrib_collector_append_pause(ContribCollector *collector,
+						      const gchar *duration);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_contrib_collector_add(ContribCollector *collector,
+					     gint64 start_time,
+					     gint64 end_time);
+/** @private */
+G_GNUC_INTERNAL
+ExperimentReaderContribTable *experiment_reader_contrib_collector_finish(ContribCollector *collector);
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_contrib_collector_free(ContribCollector *collector);
+
+/** @private */
+G_GNUC_INTERNAL
+void experiment_reader_native_init(ExperimentReader *reader);
+
+/** @private */
+G_GNUC_INTERNAL
+gboolean experiment_reader_stream_load(ExperimentReader *reader,
+				       const gchar *filename,
+				       GCancellable *cancellable);
+
+/** @private */
+G_GNUC_INTERNAL
+gboolean experiment_reader_cache_load(ExperimentReader *reader,
+				      const gchar *filename,
+				      ExperimentReaderCacheKey *key);
+/** @private */
+G_GNUC_INTERNAL
+gboolean experiment_reader_cache_save(ExperimentReader *reader,
+				      const gchar *filename,
+				      const ExperimentReaderCacheKey *key);
+
+#endif
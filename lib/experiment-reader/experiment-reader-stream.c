@@ -0,0 +1,466 @@
+/**
+ * @file
+ * Streaming session loader of the \e ExperimentReader class.
+ * Reads a session in a single pass using libxml's \e xmlTextReader
+ * and extracts all information required by the \e ExperimentReader API
+ * into compact native structures, without keeping a document tree.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libxml/xmlreader.h>
+
+#include "experiment-reader.h"
+#include "experiment-reader-private.h"
+
+/**
+ * @private
+ * Number of element names kept on the path stack. Deeper elements are
+ * only relevant within contributions.
+ */
+#define STREAM_PATH_DEPTH	5
+
+/**
+ * @private
+ * Number of nodes read between checks for cancellation
+ */
+#define STREAM_CANCEL_INTERVAL	4096
+
+/** @private */
+typedef struct _StreamState {
+	ExperimentReader	*reader;
+	xmlTextReader		*xml;
+
+	/** Names of currently open elements (interned by the reader) */
+	const xmlChar		*path[STREAM_PATH_DEPTH];
+
+	/** Speaker names mapped to speaker Ids (owned by string chunk) */
+	GHashTable		*speakers;
+	const gchar		*speaker_id;
+	/** Speaker Ids mapped to \ref ContribCollector */
+	GHashTable		*collectors;
+
+	/* current topic */
+	ExperimentReaderSection	phase_section;
+	gint			topic_depth;
+	ExperimentReaderSection	topic_section;
+	ExperimentReaderTopic		topic;
+	gboolean		topic_has_contrib;
+
+	/* current contribution */
+	gint			contrib_depth;
+	ContribCollector	*contrib_collector;
+	gint64			contrib_start_time;
+	gint64			contrib_end_time;
+} StreamState;
+
+static inline gboolean path_is(StreamState *state, gint depth, ...);
+static inline const gchar *get_attribute(StreamState *state,
+					 const gchar *name);
+static inline gint64 get_time_attribute(StreamState *state, const gchar *name);
+
+static void element_open(StreamState *state, const xmlChar *name, gint depth);
+static void element_close(StreamState *state, gint depth);
+static void contrib_element_open(StreamState *state, const xmlChar *name);
+
+static void finish_topic(StreamState *state);
+static void finish_contribution(StreamState *state);
+static void build_contrib_tables(StreamState *state);
+
+/**
+ * @brief Check element path of the current node
+ *
+ * @param state Stream state
+ * @param depth Depth of current node
+ * @param ...   \c NULL-terminated list of element names, beginning with
+ *              the root element, that must match the path
+ * @return \c TRUE if the path of the current node matches, else \c FALSE
+ */
+static inline gboolean
+path_is(StreamState *state, gint depth, ...)
+{
+	va_list ap;
+	const gchar *name;
+	gint i = 0;
+
+	va_start(ap, depth);
+	while ((name = va_arg(ap, const gchar *)) != NULL) {
+		if (i > depth || xmlStrcmp(state->path[i], XML_CHAR(name))) {
+			va_end(ap);
+			return FALSE;
+		}
+		i++;
+	}
+	va_end(ap);
+
+	return i == depth + 1;
+}
+
+/**
+ * @brief Get attribute value of the current element
+ *
+ * The value is not copied, so it is only valid until the next attribute
+ * is retrieved or the reader advances.
+ *
+ * @param state Stream state
+ * @param name  Attribute name
+ * @return Attribute value or \c NULL if the attribute does not exist
+ */
+static inline const gchar *
+get_attribute(StreamState *state, const gchar *name)
+{
+	const gchar *value;
+
+	if (xmlTextReaderMoveToAttribute(state->xml, XML_CHAR(name)) != 1)
+		return NULL;
+	value = (const gchar *)xmlTextReaderConstValue(state->xml);
+	xmlTextReaderMoveToElement(state->xml);
+
+	return value;
+}
+
+static inline gint64
+get_time_attribute(StreamState *state, const gchar *name)
+{
+	return experiment_reader_timeline_lookup(state->reader,
+						 get_attribute(state, name));
+}
+
+static void
+element_open(StreamState *state, const xmlChar *name, gint depth)
+{
+	ExperimentReaderPrivate *priv = state->reader->priv;
+
+	if (depth < STREAM_PATH_DEPTH)
+		state->path[depth] = name;
+
+	if (state->contrib_depth >= 0) {
+		/* only direct children of contributions are relevant */
+		if (depth == state->contrib_depth + 1)
+			contrib_element_open(state, name);
+		return;
+	}
+
+	if (!xmlStrcmp(name, XML_CHAR("contribution"))) {
+		const gchar *speaker_ref;
+
+		if (state->topic_depth >= 0 &&
+		    depth == state->topic_depth + 1) {
+			if (!state->topic_has_contrib)
+				state->topic.start_time =
+					get_time_attribute(state,
+							   "start-reference");
+			state->topic.end_time =
+				get_time_attribute(state, "end-reference");
+			state->topic_has_contrib = TRUE;
+		}
+
+		speaker_ref = get_attribute(state, "speaker-reference");
+		if (speaker_ref == NULL)
+			return;
+
+		state->contrib_collector =
+			g_hash_table_lookup(state->collectors, speaker_ref);
+		if (state->contrib_collector == NULL) {
+			state->contrib_collector =
+				experiment_reader_contrib_collector_new();
+			g_hash_table_insert(state->collectors,
+					    g_string_chunk_insert_const(priv->strings,
+									speaker_ref),
+					    state->contrib_collector);
+		}
+
+		state->contrib_start_time =
+			get_time_attribute(state, "start-reference");
+		state->contrib_end_time =
+			get_time_attribute(state, "end-reference");
+		state->contrib_depth = depth;
+
+		if (xmlTextReaderIsEmptyElement(state->xml))
+			finish_contribution(state);
+	} else if (!xmlStrcmp(name, XML_CHAR("topic"))) {
+		ExperimentReaderSection section;
+		const gchar *id;
+
+		if (path_is(state, depth, "session", "greeting", "topic", NULL))
+			section = EXPERIMENT_READER_SECTION_GREETING;
+		else if (path_is(state, depth, "session", "experiment",
+				 "initial-narrative", "topic", NULL))
+			section = EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE;
+		else if (path_is(state, depth, "session", "experiment",
+				 "last-minute", "phase", "topic", NULL) &&
+			 state->phase_section != EXPERIMENT_READER_SECTION_COUNT)
+			section = state->phase_section;
+		else if (path_is(state, depth, "session", "farewell", "topic",
+				 NULL))
+			section = EXPERIMENT_READER_SECTION_FAREWELL;
+		else
+			return;
+
+		id = get_attribute(state, "id");
+		state->topic.id = id != NULL
+				? g_string_chunk_insert_const(priv->strings, id)
+				: NULL;
+		state->topic.start_time = state->topic.end_time = -1;
+		state->topic_has_contrib = FALSE;
+		state->topic_section = section;
+		state->topic_depth = depth;
+
+		if (xmlTextReaderIsEmptyElement(state->xml))
+			finish_topic(state);
+	} else if (path_is(state, depth,
+			   "session", "timeline", "timepoint", NULL)) {
+		const gchar *id;
+		gint64 time;
+
+		/* attribute values are only valid until the next one is retrieved */
+		time = experiment_reader_parse_time(get_attribute(state,
+								  "absolute-time"));
+		id = get_attribute(state, "timepoint-id");
+		if (id == NULL)
+			return;
+
+		experiment_reader_timeline_add(state->reader, id, time);
+	} else if (path_is(state, depth, "session", "experiment",
+			   "last-minute", "phase", NULL)) {
+		const gchar *id = get_attribute(state, "id");
+
+		/* phases are identified by their number (1 to 6) */
+		if (id != NULL && id[0] >= '1' && id[0] <= '6' && id[1] == '\0')
+			state->phase_section =
+				EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE +
+				id[0] - '1';
+		else
+			state->phase_section = EXPERIMENT_READER_SECTION_COUNT;
+	} else if (path_is(state, depth, "session", "speakers", "speaker",
+			   NULL)) {
+		const gchar *id = get_attribute(state, "speaker-id");
+
+		state->speaker_id = id != NULL
+				? g_string_chunk_insert_const(priv->strings, id)
+				: NULL;
+	} else if (path_is(state, depth, "session", "speakers", "speaker",
+			   "name", NULL) &&
+		   state->speaker_id != NULL) {
+		gchar *speaker = (gchar *)xmlTextReaderReadString(state->xml);
+
+		/*
+		 * If there are multiple speakers with the same name,
+		 * the first one wins
+		 */
+		if (speaker != NULL &&
+		    !g_hash_table_lookup(state->speakers, speaker))
+			g_hash_table_insert(state->speakers,
+					    g_string_chunk_insert_const(priv->strings,
+									speaker),
+					    (gpointer)state->speaker_id);
+		xmlFree(speaker);
+	}
+}
+
+static void
+contrib_element_open(StreamState *state, const xmlChar *name)
+{
+	if (!xmlStrcmp(name, XML_CHAR("pause"))) {
+		const gchar *duration = get_attribute(state, "duration");
+
+		if (duration == NULL)
+			return;
+
+		experiment_reader_contrib_collector_append_pause(state->contrib_collector,
+								 duration);
+	} else if (!xmlStrcmp(name, XML_CHAR("time"))) {
+		gint64 time = get_time_attribute(state, "timepoint-reference");
+
+		/* current fragment ends where the next one begins */
+		experiment_reader_contrib_collector_add(state->contrib_collector,
+							state->contrib_start_time,
+							time);
+		state->contrib_start_time = time;
+	}
+}
+
+static void
+element_close(StreamState *state, gint depth)
+{
+	if (depth == state->contrib_depth)
+		finish_contribution(state);
+	else if (depth == state->topic_depth)
+		finish_topic(state);
+}
+
+static void
+finish_topic(StreamState *state)
+{
+	ExperimentReaderPrivate *priv = state->reader->priv;
+
+	g_array_append_val(priv->topics[state->topic_section], state->topic);
+	state->topic_depth = -1;
+}
+
+static void
+finish_contribution(StreamState *state)
+{
+	experiment_reader_contrib_collector_add(state->contrib_collector,
+						state->contrib_start_time,
+						state->contrib_end_time);
+
+	state->contrib_collector = NULL;
+	state->contrib_depth = -1;
+}
+
+/**
+ * @brief Build contribution tables of all speakers
+ *
+ * Contributions are collected per speaker Id while streaming, but
+ * looked up by speaker name.
+ * Collectors of all speakers are freed.
+ *
+ * @param state Stream state
+ */
+static void
+build_contrib_tables(StreamState *state)
+{
+	ExperimentReaderPrivate *priv = state->reader->priv;
+
+	GHashTable *tables_by_id;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	tables_by_id = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+					     (GDestroyNotify)experiment_reader_contrib_table_unref);
+
+	g_hash_table_iter_init(&iter, state->collectors);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		g_hash_table_insert(tables_by_id, key,
+				    experiment_reader_contrib_collector_finish(value));
+		g_hash_table_iter_steal(&iter);
+	}
+
+	g_hash_table_iter_init(&iter, state->speakers);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		ExperimentReaderContribTable *table;
+
+		table = g_hash_table_lookup(tables_by_id, value);
+		if (table != NULL)
+			g_hash_table_insert(priv->contrib_tables, key,
+					    experiment_reader_contrib_table_ref(table));
+	}
+
+	g_hash_table_destroy(tables_by_id);
+}
+
+/**
+ * @private
+ * @brief Load session into native structures using a streaming parser
+ *
+ * The timeline is only required while loading since all timepoint
+ * references are resolved immediately. The session's timeline must
+ * therefore precede its sections, as required by the DTD.
+ * Timepoint references of a session without timeline are unresolved.
+ *
+ * @param reader      \e ExperimentReader instance without document
+ * @param filename    Filename of XML file to read
+ * @param cancellable \e GCancellable to abort loading or \c NULL
+ * @return \c TRUE on success, else \c FALSE (parser error or cancelled)
+ */
+G_GNUC_INTERNAL gboolean
+experiment_reader_stream_load(ExperimentReader *reader, const gchar *filename,
+			      GCancellable *cancellable)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
+
+	StreamState state;
+	guint n_nodes = 0;
+	gint ret;
+
+	state.xml = xmlReaderForFile(filename, NULL, 0);
+	if (state.xml == NULL)
+		return FALSE;
+
+	state.reader = reader;
+	memset(state.path, 0, sizeof(state.path));
+	state.speakers = g_hash_table_new(g_str_hash, g_str_equal);
+	state.speaker_id = NULL;
+	state.collectors = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+						 (GDestroyNotify)experiment_reader_contrib_collector_free);
+	state.phase_section = EXPERIMENT_READER_SECTION_COUNT;
+	state.topic_depth = -1;
+	state.contrib_depth = -1;
+	state.contrib_collector = NULL;
+
+	priv->strings = g_string_chunk_new(4096);
+	experiment_reader_native_init(reader);
+	experiment_reader_timeline_init(reader);
+
+	while ((ret = xmlTextReaderRead(state.xml)) == 1) {
+		gint depth = xmlTextReaderDepth(state.xml);
+
+		if (cancellable != NULL &&
+		    ++n_nodes % STREAM_CANCEL_INTERVAL == 0 &&
+		    g_cancellable_is_cancelled(cancellable)) {
+			ret = -1;
+			break;
+		}
+
+		switch (xmlTextReaderNodeType(state.xml)) {
+		case XML_READER_TYPE_ELEMENT:
+			element_open(&state, xmlTextReaderConstName(state.xml),
+				     depth);
+			break;
+
+		case XML_READER_TYPE_END_ELEMENT:
+			element_close(&state, depth);
+			break;
+
+		case XML_READER_TYPE_TEXT:
+		case XML_READER_TYPE_WHITESPACE:
+		case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+			if (state.contrib_depth >= 0 &&
+			    depth == state.contrib_depth + 1)
+				experiment_reader_contrib_collector_append_text(state.contrib_collector,
+					(const gchar *)xmlTextReaderConstValue(state.xml));
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	xmlFreeTextReader(state.xml);
+
+	if (ret == 0)
+		build_contrib_tables(&state);
+
+	g_hash_table_destroy(state.collectors);
+	g_hash_table_destroy(state.speakers);
+
+	/* all timepoint references have been resolved */
+	experiment_reader_timeline_free(reader);
+
+	return ret == 0;
+}
@@ -31,51 +31,78 @@
 #include <glib-object.h>
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
-#include "cclosure-marshallers.h"
 #include "experiment-reader.h"
+#include "experiment-reader-private.h"
 
 static void experiment_reader_class_init(ExperimentReaderClass *klass);
 static void experiment_reader_init(ExperimentReader *klass);
 static void experiment_reader_finalize(GObject *gobject);
 
-static gint64 get_timepoint_by_ref(xmlDoc *doc, xmlChar *ref);
+static ExperimentReader *reader_new(const gchar *filename,
+				    ExperimentReaderFlags flags,
+				    GCancellable *cancellable);
+static void new_async_data_free(gpointer data);
+static void new_async_thread(GSimpleAsyncResult *res, GObject *object,
+			     GCancellable *cancellable);
+
+static gboolean build_timeline_index(ExperimentReader *reader);
 static xmlNode *get_first_element(xmlNode *children, const gchar *name);
 static xmlNode *get_last_element(xmlNode *children, const gchar *name);
 
-static GClosure *experiment_reader_topic_callback_new(ExperimentReaderTopicCallback,
-						      gpointer);
-static void experiment_reader_topic_callback_invoke(ExperimentReader *reader,
-						    GClosure *closure,
-						    const gchar *topic_id,
-						    gint64 start_time,
-						    gint64 end_time);
-static gboolean generic_foreach_topic(ExperimentReader *reader, xmlNodeSet *nodes,
-				      GClosure *closure);
-
-static gint experiment_reader_contrib_cmp(const ExperimentReaderContrib *a,
-					  const ExperimentReaderContrib *b);
-static void insert_contribution(gint64 start_time, gchar *text, GList **list);
-static inline void process_contribution(xmlDoc *doc, xmlNode *contrib,
-					GList **list);
+static void add_section_topics(ExperimentReader *reader, xmlNode *section,
+			       ExperimentReaderSection section_id);
+static void build_topics(ExperimentReader *reader);
+static void foreach_topic(ExperimentReader *reader,
+			  ExperimentReaderSection section,
+			  ExperimentReaderTopicCallback callback,
+			  gpointer userdata);
+static ExperimentReaderTopicIndex *topic_index_new(const ExperimentReaderStructure *structure);
+static void topic_index_free(ExperimentReaderTopicIndex *index);
+static gint topic_index_entry_cmp(gconstpointer a, gconstpointer b);
+
+static inline gint64 max_end_tree_node(const gint64 *max_end_tree,
+					const gint64 *end_times, guint n,
+					guint size, guint v);
+static void compute_max_end_tree(const gint64 *end_times,
+				 gint64 *max_end_tree, guint n);
+static inline guint interval_upper_bound(const gint64 *start_times, guint n,
+					 gint64 timept);
+static guint interval_lower_bound(const gint64 *end_times,
+				  const gint64 *max_end_tree, guint n,
+				  gint64 timept);
+static gint interval_lookup(const gint64 *start_times, const gint64 *end_times,
+			    const gint64 *max_end_tree, guint n,
+			    gint64 timept);
+static gboolean interval_lookup_range(const gint64 *start_times,
+				      const gint64 *end_times,
+				      const gint64 *max_end_tree, guint n,
+				      gint64 start, gint64 end,
+				      guint *first, guint *last);
 
-/** @private */
-#define XML_CHAR(STR) \
-	((const xmlChar *)(STR))
+/**
+ * @private
+ * Operation data of \ref experiment_reader_new_async
+ */
+typedef struct _NewAsyncData {
+	gchar			*filename;
+	ExperimentReaderFlags	flags;
+	GCancellable		*cancellable;
 
-/** @private */
-#define EXPERIMENT_READER_GET_PRIVATE(obj) \
-	(G_TYPE_INSTANCE_GET_PRIVATE((obj), EXPERIMENT_TYPE_READER, ExperimentReaderPrivate))
+	ExperimentReader	*reader;	/**< Result or \c NULL */
+} NewAsyncData;
 
-/** @private */
-struct _ExperimentReaderPrivate {
-	xmlDoc *doc;
-};
+static gint contrib_entry_cmp(gconstpointer a, gconstpointer b,
+			      gpointer user_data);
+static inline void process_contribution(ExperimentReader *reader,
+					xmlNode *contrib,
+					ContribCollector *collector);
 
 /**
  * @private
@@ -101,6 +128,17 @@ experiment_reader_init(ExperimentReader *klass)
 	klass->priv = EXPERIMENT_READER_GET_PRIVATE(klass);
 
 	klass->priv->doc = NULL;
+
+	klass->priv->timeline = NULL;
+	klass->priv->timeline_ids = NULL;
+	klass->priv->timeline_times = NULL;
+
+	klass->priv->strings = NULL;
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+		klass->priv->topics[i] = NULL;
+	klass->priv->structure = NULL;
+	klass->priv->contrib_tables = NULL;
+	klass->priv->cache = NULL;
 }
 
 static void
@@ -111,38 +149,166 @@ experiment_reader_finalize(GObject *gobject)
 	if (reader->priv->doc != NULL)
 		xmlFreeDoc(reader->priv->doc);
 
+	experiment_reader_timeline_free(reader);
+
+	if (reader->priv->strings != NULL)
+		g_string_chunk_free(reader->priv->strings);
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+		if (reader->priv->topics[i] != NULL)
+			g_array_free(reader->priv->topics[i], TRUE);
+	if (reader->priv->structure != NULL) {
+		topic_index_free(reader->priv->structure->index);
+		g_free(reader->priv->structure);
+	}
+	if (reader->priv->contrib_tables != NULL)
+		g_hash_table_destroy(reader->priv->contrib_tables);
+	if (reader->priv->cache != NULL)
+		g_mapped_file_unref(reader->priv->cache);
+
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS(experiment_reader_parent_class)->finalize(gobject);
 }
 
-static gint64
-get_timepoint_by_ref(xmlDoc *doc, xmlChar *ref)
+/** @private */
+G_GNUC_INTERNAL void
+experiment_reader_timeline_init(ExperimentReader *reader)
 {
-	xmlChar expr[255];
+	ExperimentReaderPrivate *priv = reader->priv;
 
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
+	priv->timeline = g_hash_table_new(g_str_hash, g_str_equal);
+	priv->timeline_ids = g_string_chunk_new(4096);
+	priv->timeline_times = g_array_new(FALSE, FALSE, sizeof(gint64));
+}
 
-	double value;
+/**
+ * @private
+ * @brief Add timepoint to the timeline index
+ *
+ * @param reader \e ExperimentReader instance
+ * @param id     Timepoint Id
+ * @param time   Absolute time of timepoint in milliseconds
+ */
+G_GNUC_INTERNAL void
+experiment_reader_timeline_add(ExperimentReader *reader,
+			       const gchar *id, gint64 time)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
 
-	xpathCtx = xmlXPathNewContext(doc);
-	assert(xpathCtx != NULL);
+	g_array_append_val(priv->timeline_times, time);
+	g_hash_table_insert(priv->timeline,
+			    g_string_chunk_insert(priv->timeline_ids, id),
+			    GUINT_TO_POINTER(priv->timeline_times->len));
+}
 
-	/** @todo precompile XPath expression */
-	xmlStrPrintf(expr, sizeof(expr),
-		     XML_CHAR("/session/timeline/"
-			      "timepoint[@timepoint-id = '%s']/"
-			      "@absolute-time"), ref);
+/**
+ * @private
+ * @brief Resolve timepoint reference using the timeline index
+ *
+ * @param reader \e ExperimentReader instance
+ * @param ref    Timepoint Id
+ * @return Absolute time of timepoint in milliseconds or -1 if the
+ *         timepoint does not exist
+ */
+G_GNUC_INTERNAL gint64
+experiment_reader_timeline_lookup(ExperimentReader *reader, const gchar *ref)
+{
+	guint index;
 
-	xpathObj = xmlXPathEvalExpression(expr, xpathCtx);
-	assert(xpathObj != NULL);
+	if (ref == NULL)
+		return -1;
+
+	index = GPOINTER_TO_UINT(g_hash_table_lookup(reader->priv->timeline,
+						     ref));
+	return index ? g_array_index(reader->priv->timeline_times,
+				     gint64, index - 1)
+		     : -1;
+}
 
-	value = xmlXPathCastToNumber(xpathObj);
+/** @private */
+G_GNUC_INTERNAL void
+experiment_reader_timeline_free(ExperimentReader *reader)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
+
+	if (priv->timeline != NULL)
+		g_hash_table_destroy(priv->timeline);
+	priv->timeline = NULL;
+	if (priv->timeline_ids != NULL)
+		g_string_chunk_free(priv->timeline_ids);
+	priv->timeline_ids = NULL;
+	if (priv->timeline_times != NULL)
+		g_array_free(priv->timeline_times, TRUE);
+	priv->timeline_times = NULL;
+}
 
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+/**
+ * @brief Build timeline index of the session
+ *
+ * Walks all \b timepoint elements of the \b timeline once, so that
+ * timepoint references can afterwards be resolved in constant time.
+ * A session without timeline gets an empty index, i.e. none of its
+ * timepoint references can be resolved.
+ *
+ * @sa experiment_reader_timeline_lookup
+ *
+ * @param reader \e ExperimentReader instance with parsed document
+ * @return \c TRUE on success, else \c FALSE (no root element)
+ */
+static gboolean
+build_timeline_index(ExperimentReader *reader)
+{
+	xmlNode *session, *timeline;
+
+	session = xmlDocGetRootElement(reader->priv->doc);
+	if (session == NULL)
+		return FALSE;
+
+	experiment_reader_timeline_init(reader);
+
+	timeline = get_first_element(session->children, "timeline");
+	if (timeline == NULL)
+		return TRUE;
+
+	for (xmlNode *cur = timeline->children; cur != NULL; cur = cur->next) {
+		xmlChar *id, *value;
+
+		if (cur->type != XML_ELEMENT_NODE ||
+		    xmlStrcmp(cur->name, XML_CHAR("timepoint")))
+			continue;
+
+		id = xmlGetProp(cur, XML_CHAR("timepoint-id"));
+		if (id == NULL)
+			continue;
+		value = xmlGetProp(cur, XML_CHAR("absolute-time"));
+
+		experiment_reader_timeline_add(reader, (const gchar *)id,
+				experiment_reader_parse_time((const gchar *)value));
+
+		xmlFree(value);
+		xmlFree(id);
+	}
+
+	return TRUE;
+}
+
+/**
+ * @private
+ * @brief Initialize native session model
+ *
+ * Allocates the (empty) topic arrays and contribution table index.
+ * Strings referenced by the model must be managed by the caller.
+ *
+ * @param reader \e ExperimentReader instance without document
+ */
+G_GNUC_INTERNAL void
+experiment_reader_native_init(ExperimentReader *reader)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
 
-	return (gint64)(value*1000.);
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+		priv->topics[i] = g_array_new(FALSE, FALSE, sizeof(ExperimentReaderTopic));
+	priv->contrib_tables = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+						     (GDestroyNotify)experiment_reader_contrib_table_unref);
 }
 
 static xmlNode *
@@ -169,147 +335,430 @@ get_last_element(xmlNode *children, const gchar *name)
 	return ret;
 }
 
-static GClosure *
-experiment_reader_topic_callback_new(ExperimentReaderTopicCallback callback,
-				     gpointer data)
+/**
+ * @private
+ * Append topics of a section element to the native model.
+ * A topic's time range spans from the start of its first contribution
+ * to the end of its last contribution.
+ */
+static void
+add_section_topics(ExperimentReader *reader, xmlNode *section,
+		   ExperimentReaderSection section_id)
 {
-	GClosure *closure = g_cclosure_new(G_CALLBACK(callback), data, NULL);
+	ExperimentReaderPrivate *priv = reader->priv;
+
+	for (xmlNode *cur = section->children; cur != NULL; cur = cur->next) {
+		ExperimentReaderTopic topic;
+		xmlNode *first_contrib, *last_contrib;
+		xmlChar *topic_id;
+
+		if (cur->type != XML_ELEMENT_NODE ||
+		    xmlStrcmp(cur->name, XML_CHAR("topic")))
+			continue;
+
+		first_contrib = get_first_element(cur->children,
+						  "contribution");
+		last_contrib = get_last_element(cur->children,
+						"contribution");
+
+		topic_id = xmlGetProp(cur, XML_CHAR("id"));
+		topic.id = topic_id != NULL
+				? g_string_chunk_insert_const(priv->strings,
+							      (const gchar *)topic_id)
+				: NULL;
+		xmlFree(topic_id);
+		topic.start_time = -1;
+		topic.end_time = -1;
+
+		if (first_contrib != NULL) {
+			xmlChar *contrib_start_ref;
 
-	g_closure_set_marshal(closure,
-			      experiment_reader_marshal_VOID__STRING_INT64_INT64);
-	g_closure_ref(closure);
-	g_closure_sink(closure);
+			contrib_start_ref = xmlGetProp(first_contrib,
+						       XML_CHAR("start-reference"));
+			topic.start_time = experiment_reader_timeline_lookup(reader,
+						(const gchar *)contrib_start_ref);
+			xmlFree(contrib_start_ref);
+		}
+		if (last_contrib != NULL) {
+			xmlChar *contrib_end_ref;
+
+			contrib_end_ref = xmlGetProp(last_contrib,
+						     XML_CHAR("end-reference"));
+			topic.end_time = experiment_reader_timeline_lookup(reader,
+						(const gchar *)contrib_end_ref);
+			xmlFree(contrib_end_ref);
+		}
 
-	return closure;
+		g_array_append_val(priv->topics[section_id], topic);
+	}
 }
 
+/**
+ * @private
+ * @brief Extract the topics of all sections from the document
+ *
+ * The document is traversed once, so that topics do not have to be
+ * queried per section.
+ *
+ * @param reader \e ExperimentReader instance with document
+ */
 static void
-experiment_reader_topic_callback_invoke(ExperimentReader *reader,
-					GClosure *closure,
-					const gchar *topic_id,
-					gint64 start_time, gint64 end_time)
+build_topics(ExperimentReader *reader)
 {
-	GValue params[4];
+	ExperimentReaderPrivate *priv = reader->priv;
+	xmlNode *session = xmlDocGetRootElement(priv->doc);
 
-	memset(params, 0, sizeof(params));
-	g_value_init(params + 0, G_TYPE_OBJECT);
-	g_value_set_object(params + 0, reader);
-	g_value_init(params + 1, G_TYPE_STRING);
-	g_value_set_string(params + 1, topic_id);
-	g_value_init(params + 2, G_TYPE_INT64);
-	g_value_set_int64(params + 2, start_time);
-	g_value_init(params + 3, G_TYPE_INT64);
-	g_value_set_int64(params + 3, end_time);
+	if (priv->strings == NULL)
+		priv->strings = g_string_chunk_new(4096);
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+		priv->topics[i] = g_array_new(FALSE, FALSE,
+					      sizeof(ExperimentReaderTopic));
 
-	g_closure_invoke(closure, NULL, G_N_ELEMENTS(params), params, NULL);
+	if (session == NULL)
+		return;
 
-	for (gint i = 0; i < G_N_ELEMENTS(params); i++)
-		g_value_unset(params + i);
+	for (xmlNode *cur = session->children; cur != NULL; cur = cur->next) {
+		if (cur->type != XML_ELEMENT_NODE)
+			continue;
+
+		if (!xmlStrcmp(cur->name, XML_CHAR("greeting"))) {
+			add_section_topics(reader, cur,
+					   EXPERIMENT_READER_SECTION_GREETING);
+		} else if (!xmlStrcmp(cur->name, XML_CHAR("farewell"))) {
+			add_section_topics(reader, cur,
+					   EXPERIMENT_READER_SECTION_FAREWELL);
+		} else if (!xmlStrcmp(cur->name, XML_CHAR("experiment"))) {
+			for (xmlNode *sub = cur->children; sub != NULL; sub = sub->next) {
+				if (sub->type != XML_ELEMENT_NODE)
+					continue;
+
+				if (!xmlStrcmp(sub->name, XML_CHAR("initial-narrative"))) {
+					add_section_topics(reader, sub,
+							   EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE);
+					continue;
+				}
+				if (xmlStrcmp(sub->name, XML_CHAR("last-minute")))
+					continue;
+
+				for (xmlNode *phase = sub->children;
+				     phase != NULL; phase = phase->next) {
+					xmlChar *id;
+
+					if (phase->type != XML_ELEMENT_NODE ||
+					    xmlStrcmp(phase->name, XML_CHAR("phase")))
+						continue;
+
+					/* phases are identified by their number (1 to 6) */
+					id = xmlGetProp(phase, XML_CHAR("id"));
+					if (id != NULL && id[0] >= '1' && id[0] <= '6' &&
+					    id[1] == '\0')
+						add_section_topics(reader, phase,
+								   EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE +
+								   id[0] - '1');
+					xmlFree(id);
+				}
+			}
+		}
+	}
 }
 
-static gboolean
-generic_foreach_topic(ExperimentReader *reader, xmlNodeSet *nodes,
-		      GClosure *closure)
+/** @private */
+static void
+foreach_topic(ExperimentReader *reader, ExperimentReaderSection section,
+	      ExperimentReaderTopicCallback callback, gpointer userdata)
 {
-	if (nodes == NULL)
-		return TRUE;
+	const ExperimentReaderSectionInfo *info;
 
-	for (int i = 0; i < nodes->nodeNr; i++) {
-		xmlNode *cur = nodes->nodeTab[i];
-		assert(cur != NULL && cur->type == XML_ELEMENT_NODE);
+	info = &experiment_reader_get_structure(reader)->sections[section];
 
-		xmlNode *first_contrib = get_first_element(cur->children,
-							   "contribution");
-		xmlNode *last_contrib = get_last_element(cur->children,
-							 "contribution");
+	for (guint i = 0; i < info->n_topics; i++)
+		callback(reader, info->topics[i].id,
+			 info->topics[i].start_time, info->topics[i].end_time,
+			 userdata);
+}
 
-		xmlChar	*topic_id = xmlGetProp(cur, XML_CHAR("id"));
-		gint64	start_time = -1;
-		gint64	end_time = -1;
+static gint
+contrib_entry_cmp(gconstpointer a, gconstpointer b,
+		  gpointer user_data __attribute__((unused)))
+{
+	const ContribEntry *entry_a = a;
+	const ContribEntry *entry_b = b;
 
-		if (first_contrib != NULL) {
-			xmlChar *contrib_start_ref;
+	if (entry_a->start_time != entry_b->start_time)
+		return entry_a->start_time < entry_b->start_time ? -1 : 1;
 
-			contrib_start_ref = xmlGetProp(first_contrib,
-						       XML_CHAR("start-reference"));
-			start_time = get_timepoint_by_ref(reader->priv->doc,
-							  contrib_start_ref);
-			xmlFree(contrib_start_ref);
-		}
-		if (last_contrib != NULL) {
-			xmlChar *contrib_end_ref;
+	/* keep contributions with equal start times in document order */
+	return entry_a->index < entry_b->index ? -1 : 1;
+}
 
-			contrib_end_ref = xmlGetProp(last_contrib,
-						     XML_CHAR("end-reference"));
-			end_time = get_timepoint_by_ref(reader->priv->doc,
-							contrib_end_ref);
-			xmlFree(contrib_end_ref);
-		}
+/**
+ * @private
+ * Get node \e v of a tree of maximum end times over \e n intervals.
+ * Leaves beyond the last interval are smaller than any end time.
+ *
+ * @sa experiment_reader_interval_tree_size
+ */
+static inline gint64
+max_end_tree_node(const gint64 *max_end_tree, const gint64 *end_times,
+		  guint n, guint size, guint v)
+{
+	if (v < size)
+		return max_end_tree[v];
+
+	return v - size < n ? end_times[v - size] : G_MININT64;
+}
 
-		experiment_reader_topic_callback_invoke(reader, closure,
-							(const gchar *)topic_id,
-							start_time, end_time);
+/**
+ * @private
+ * Build tree of maximum end times, so that the intervals ending at or
+ * after a point in time can be found in O(log n) even if intervals
+ * overlap.
+ * \e max_end_tree must have room for
+ * \ref experiment_reader_interval_tree_size elements.
+ */
+static void
+compute_max_end_tree(const gint64 *end_times, gint64 *max_end_tree, guint n)
+{
+	guint size = experiment_reader_interval_tree_size(n);
 
-		xmlFree(topic_id);
+	for (guint v = size - 1; v > 0; v--)
+		max_end_tree[v] = MAX(max_end_tree_node(max_end_tree, end_times,
+							n, size, 2*v),
+				      max_end_tree_node(max_end_tree, end_times,
+							n, size, 2*v + 1));
+}
+
+/**
+ * @private
+ * Get number of intervals (sorted by start time) starting at or before
+ * \e timept
+ */
+static inline guint
+interval_upper_bound(const gint64 *start_times, guint n, gint64 timept)
+{
+	guint low = 0, high = n;
+
+	while (low < high) {
+		guint mid = low + (high - low)/2;
+
+		if (start_times[mid] > timept)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return low;
+}
+
+/**
+ * @private
+ * Get index of first interval ending at or after \e timept, or \e n
+ * if there is none
+ */
+static guint
+interval_lower_bound(const gint64 *end_times, const gint64 *max_end_tree,
+		     guint n, gint64 timept)
+{
+	guint size = experiment_reader_interval_tree_size(n);
+	guint v = 1;
+
+	if (!n || max_end_tree_node(max_end_tree, end_times,
+				    n, size, v) < timept)
+		return n;
+
+	/* descend into the leftmost subtree ending late enough */
+	while (v < size) {
+		v *= 2;
+		if (max_end_tree_node(max_end_tree, end_times,
+				      n, size, v) < timept)
+			v++;
 	}
 
-	return FALSE;
+	return v - size;
 }
 
+/**
+ * @private
+ * @brief Find interval containing a point in time
+ *
+ * If several intervals contain \e timept, the one starting last is
+ * returned. That is the last one ending at or after \e timept among
+ * the intervals starting at or before it, which is found by climbing
+ * the tree of maximum end times from that interval and descending
+ * into the rightmost subtree ending late enough, in O(log n).
+ *
+ * @return Index of interval or -1
+ */
 static gint
-experiment_reader_contrib_cmp(const ExperimentReaderContrib *a,
-			      const ExperimentReaderContrib *b)
+interval_lookup(const gint64 *start_times, const gint64 *end_times,
+		const gint64 *max_end_tree, guint n, gint64 timept)
 {
-	if (a->start_time < b->start_time)
+	guint size = experiment_reader_interval_tree_size(n);
+	guint count = interval_upper_bound(start_times, n, timept);
+	guint v;
+
+	if (!count)
 		return -1;
-	if (a->start_time > b->start_time)
-		return 1;
-	return 0;
+
+	v = size + count - 1;
+	while (max_end_tree_node(max_end_tree, end_times,
+				 n, size, v) < timept) {
+		/* move to the subtree just left of the subtrees inspected */
+		while (!(v & 1))
+			v /= 2;
+		if (v == 1)
+			return -1;
+		v--;
+	}
+
+	while (v < size) {
+		v = 2*v + 1;
+		if (max_end_tree_node(max_end_tree, end_times,
+				      n, size, v) < timept)
+			v--;
+	}
+
+	return (gint)(v - size);
 }
 
-static void
-insert_contribution(gint64 start_time, gchar *text, GList **list)
+/**
+ * @private
+ * @brief Find intervals overlapping a range of time
+ *
+ * All intervals overlapping the range [\e start, \e end] lie
+ * between \e first and \e last (inclusive).
+ * If no intervals overlap each other, no other intervals do.
+ *
+ * @return \c TRUE if the index range is not empty, else \c FALSE
+ */
+static gboolean
+interval_lookup_range(const gint64 *start_times, const gint64 *end_times,
+		      const gint64 *max_end_tree, guint n,
+		      gint64 start, gint64 end, guint *first, guint *last)
 {
-	ExperimentReaderContrib *contrib;
+	guint low = interval_lower_bound(end_times, max_end_tree, n, start);
+	guint high = interval_upper_bound(start_times, n, end);
 
-	if (text == NULL)
-		return;
+	if (low >= high)
+		return FALSE;
+
+	*first = low;
+	*last = high - 1;
+	return TRUE;
+}
+
+/** @private */
+static gint
+topic_index_entry_cmp(gconstpointer a, gconstpointer b)
+{
+	const TopicIndexEntry *entry_a = a;
+	const TopicIndexEntry *entry_b = b;
+
+	if (entry_a->topic->start_time != entry_b->topic->start_time)
+		return entry_a->topic->start_time < entry_b->topic->start_time
+			? -1 : 1;
+	if (entry_a->section != entry_b->section)
+		return entry_a->section < entry_b->section ? -1 : 1;
+
+	/* topics of a section are stored in document order */
+	return entry_a->topic < entry_b->topic ? -1 :
+	       entry_a->topic > entry_b->topic ? 1 : 0;
+}
+
+/**
+ * @private
+ * @brief Build interval index over all topics with a valid time range
+ *
+ * @param structure Session structure
+ * @return Newly allocated topic index
+ */
+static ExperimentReaderTopicIndex *
+topic_index_new(const ExperimentReaderStructure *structure)
+{
+	ExperimentReaderTopicIndex *index;
+	GArray *entries = g_array_new(FALSE, FALSE, sizeof(TopicIndexEntry));
+	guint n;
+
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++) {
+		const ExperimentReaderSectionInfo *info = structure->sections + i;
 
-	contrib = g_malloc(sizeof(ExperimentReaderContrib) + strlen(text) + 1);
-	contrib->start_time = start_time;
-	g_stpcpy(contrib->text, g_strchomp(text));
+		for (guint j = 0; j < info->n_topics; j++) {
+			TopicIndexEntry entry;
 
-	*list = g_list_insert_sorted(*list, contrib,
-				     (GCompareFunc)experiment_reader_contrib_cmp);
+			entry.topic = info->topics + j;
+			entry.section = (ExperimentReaderSection)i;
+
+			if (entry.topic->start_time < 0 ||
+			    entry.topic->end_time < entry.topic->start_time)
+				continue;
+
+			g_array_append_val(entries, entry);
+		}
+	}
+	g_array_sort(entries, topic_index_entry_cmp);
+	n = entries->len;
+
+	index = g_new(ExperimentReaderTopicIndex, 1);
+	index->n_topics = n;
+	/* all time columns are allocated in one block */
+	index->start_times = g_new(gint64, 2*n +
+				   experiment_reader_interval_tree_size(n));
+	index->end_times = index->start_times + n;
+	index->max_end_tree = index->end_times + n;
+	index->topics = g_new(const ExperimentReaderTopic *, n);
+	index->sections = g_new(ExperimentReaderSection, n);
+
+	for (guint i = 0; i < n; i++) {
+		const TopicIndexEntry *entry = &g_array_index(entries,
+							      TopicIndexEntry, i);
+
+		index->start_times[i] = entry->topic->start_time;
+		index->end_times[i] = entry->topic->end_time;
+		index->topics[i] = entry->topic;
+		index->sections[i] = entry->section;
+	}
+	compute_max_end_tree(index->end_times, index->max_end_tree, n);
+
+	g_array_free(entries, TRUE);
+
+	return index;
+}
+
+/** @private */
+static void
+topic_index_free(ExperimentReaderTopicIndex *index)
+{
+	if (index == NULL)
+		return;
+
+	g_free(index->start_times);
+	g_free(index->sections);
+	g_free(index->topics);
+	g_free(index);
 }
 
 static inline void
-process_contribution(xmlDoc *doc, xmlNode *contrib, GList **list)
+process_contribution(ExperimentReader *reader, xmlNode *contrib,
+		     ContribCollector *collector)
 {
 	xmlChar *ref;
-	gint64 start_time;
-
-	gchar *text = NULL;
+	gint64 start_time, end_time;
 
 	ref = xmlGetProp(contrib, XML_CHAR("start-reference"));
-	start_time = get_timepoint_by_ref(doc, ref);
+	start_time = experiment_reader_timeline_lookup(reader,
+						(const gchar *)ref);
+	xmlFree(ref);
+	ref = xmlGetProp(contrib, XML_CHAR("end-reference"));
+	end_time = experiment_reader_timeline_lookup(reader,
+						(const gchar *)ref);
 	xmlFree(ref);
 
 	for (xmlNode *cur = contrib->children; cur != NULL; cur = cur->next) {
-		xmlChar *content;
-		gchar *new;
-
 		switch (cur->type) {
 		case XML_TEXT_NODE:
-			content = xmlNodeGetContent(cur);
-
-			new = g_strconcat(text != NULL ? text : "",
-					  g_strstrip((gchar *)content),
-					  " ", NULL);
-			g_free(text);
-			text = new;
-
-			xmlFree(content);
+			if (cur->content != NULL)
+				experiment_reader_contrib_collector_append_text(collector,
+						(const gchar *)cur->content);
 			break;
 
 		case XML_ELEMENT_NODE:
@@ -320,28 +769,24 @@ process_contribution(xmlDoc *doc, xmlNode *contrib, GList **list)
 				if (duration == NULL)
 					break;
 
-				if (!xmlStrcmp(duration, XML_CHAR("micro")) ||
-				    !xmlStrcmp(duration, XML_CHAR("short")))
-					new = g_strconcat(text != NULL ? text : "",
-							  "... ", NULL);
-				else if (text == NULL)
-					new = g_strdup("...\n");
-				else
-					new = g_strconcat(g_strchomp(text),
-							  "\n", NULL);
-				g_free(text);
-				text = new;
+				experiment_reader_contrib_collector_append_pause(collector,
+						(const gchar *)duration);
 
 				xmlFree(duration);
 			} else if (!xmlStrcmp(cur->name, XML_CHAR("time"))) {
-				insert_contribution(start_time, text, list);
-				g_free(text);
-				text = NULL;
+				gint64 time;
 
 				ref = xmlGetProp(cur,
 						 XML_CHAR("timepoint-reference"));
-				start_time = get_timepoint_by_ref(doc, ref);
+				time = experiment_reader_timeline_lookup(reader,
+						(const gchar *)ref);
 				xmlFree(ref);
+
+				/* current fragment ends where the next one begins */
+				experiment_reader_contrib_collector_add(collector,
+									start_time,
+									time);
+				start_time = time;
 			}
 			break;
 
@@ -350,83 +795,447 @@ process_contribution(xmlDoc *doc, xmlNode *contrib, GList **list)
 		}
 	}
 
-	insert_contribution(start_time, text, list);
-	g_free(text);
+	experiment_reader_contrib_collector_add(collector, start_time,
+						end_time);
 }
 
-/*
- * API
- */
+/** @private */
+G_GNUC_INTERNAL ContribCollector *
+experiment_reader_contrib_collector_new(void)
+{
+	ContribCollector *collector = g_new(ContribCollector, 1);
+
+	collector->entries = g_array_new(FALSE, FALSE, sizeof(ContribEntry));
+	collector->text = g_string_new(NULL);
+	collector->text_start = -1;
+
+	return collector;
+}
+
+/** @private */
+static inline void
+collector_chomp(ContribCollector *collector)
+{
+	gsize len = collector->text->len;
+
+	while (len > (gsize)collector->text_start &&
+	       g_ascii_isspace(collector->text->str[len - 1]))
+		len--;
+	g_string_truncate(collector->text, len);
+}
 
 /**
- * @brief Constructs a new ExperimentReader object
+ * @private
+ * @brief Append text node content to current contribution's text
  *
- * @param filename Filename of XML file to open
- * @return A new \e ExperimentReader object. Free with \e g_object_unref.
+ * The content is stripped and separated from the following text by a
+ * single space.
+ * The text is appended to the collector's text blob directly, so
+ * assembling a contribution's text takes linear time.
+ *
+ * @param collector Contribution collector
+ * @param content   Content of text node
  */
-ExperimentReader *
-experiment_reader_new(const gchar *filename)
+G_GNUC_INTERNAL void
+experiment_reader_contrib_collector_append_text(ContribCollector *collector,
+						const gchar *content)
 {
-	ExperimentReader *reader;
+	const gchar *end;
 
-	reader = EXPERIMENT_READER(g_object_new(EXPERIMENT_TYPE_READER, NULL));
-	reader->priv->doc = xmlParseFile(filename);
-	if (reader->priv->doc == NULL) {
-		g_object_unref(G_OBJECT(reader));
-		return NULL;
-	}
+	while (g_ascii_isspace(*content))
+		content++;
+	end = content + strlen(content);
+	while (end > content && g_ascii_isspace(end[-1]))
+		end--;
 
-	/** @todo validate against session.dtd */
+	if (collector->text_start < 0)
+		collector->text_start = collector->text->len;
 
-	return reader;
+	g_string_append_len(collector->text, content, end - content);
+	g_string_append_c(collector->text, ' ');
 }
 
 /**
- * @brief Retrieve list of contributions by speaker
+ * @private
+ * @brief Append \b pause element to current contribution's text
  *
- * Returns a newly-allocated doubly-linked list of
- * \ref ExperimentReaderContrib structures representing all contributions
- * by a given speaker. Every text fragment with a \e timepoint reference is
- * considered a contribution.
- * The list is sorted by the contributions' start times, in ascending order.
+ * Micro and short pauses are represented by an ellipsis, longer pauses
+ * by a line break.
  *
- * @sa ExperimentReaderContrib
- * @sa experiment_reader_get_contribution_by_time
- * @sa experiment_reader_free_contributions
+ * @param collector Contribution collector
+ * @param duration  Value of \b duration attribute
+ */
+G_GNUC_INTERNAL void
+experiment_reader_contrib_collector_append_pause(ContribCollector *collector,
+						 const gchar *duration)
+{
+	if (!g_strcmp0(duration, "micro") || !g_strcmp0(duration, "short")) {
+		if (collector->text_start < 0)
+			collector->text_start = collector->text->len;
+		g_string_append(collector->text, "... ");
+	} else if (collector->text_start < 0) {
+		collector->text_start = collector->text->len;
+		g_string_append(collector->text, "...\n");
+	} else {
+		collector_chomp(collector);
+		g_string_append_c(collector->text, '\n');
+	}
+}
+
+/**
+ * @private
+ * @brief Add current contribution to collector
  *
- * @param reader  \e ExperimentReader instance
- * @param speaker Full name of the speaker (e.g. "Wizard")
- * @return Newly allocated list of contributions (must be freed with
- *         \ref experiment_reader_free_contributions)
+ * Trailing whitespace is removed from the current contribution's text.
+ * If no text has been appended since the last contribution was added,
+ * no contribution is added.
+ *
+ * @param collector  Contribution collector
+ * @param start_time Contribution's start time in milliseconds
+ * @param end_time   Contribution's end time in milliseconds. If it is
+ *                   unknown or before \e start_time, the contribution
+ *                   ends at \e start_time.
  */
-GList *
-experiment_reader_get_contributions_by_speaker(ExperimentReader *reader,
-					       const gchar *speaker)
+G_GNUC_INTERNAL void
+experiment_reader_contrib_collector_add(ContribCollector *collector,
+					gint64 start_time, gint64 end_time)
 {
-	GList		*list = NULL;
+	ContribEntry entry;
 
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
+	if (collector->text_start < 0)
+		return;
 
-	xmlChar expr[255];
+	collector_chomp(collector);
+	/* including the terminating null-byte */
+	g_string_append_c(collector->text, '\0');
 
-	xpathCtx = xmlXPathNewContext(reader->priv->doc);
+	entry.start_time = start_time;
+	entry.end_time = MAX(end_time, start_time);
+	entry.text_offset = collector->text_start;
+	entry.index = collector->entries->len;
+	g_array_append_val(collector->entries, entry);
 
-	/* Evaluate xpath expression */
-	xmlStrPrintf(expr, sizeof(expr),
-		     XML_CHAR("//contribution[@speaker-reference = "
-			      "/session/speakers/speaker[name = '%s']/@speaker-id]"),
-		     speaker);
-	xpathObj = xmlXPathEvalExpression(expr, xpathCtx);
+	collector->text_start = -1;
+}
 
-	for (int i = 0; i < xpathObj->nodesetval->nodeNr; i++) {
-		xmlNode *contrib = xpathObj->nodesetval->nodeTab[i];
+/**
+ * @private
+ * @brief Sort collected contributions and build contribution table
+ *
+ * The collector is freed, its resources are taken over by the table.
+ *
+ * @param collector Contribution collector
+ * @return New contribution table with a reference count of 1
+ */
+G_GNUC_INTERNAL ExperimentReaderContribTable *
+experiment_reader_contrib_collector_finish(ContribCollector *collector)
+{
+	ExperimentReaderContribTable *table;
+	guint n = collector->entries->len;
+	guint size;
+
+	g_array_sort_with_data(collector->entries, contrib_entry_cmp, NULL);
+
+	table = g_new(ExperimentReaderContribTable, 1);
+	table->n_contribs = n;
+	table->ref_count = 1;
+	table->mapping = NULL;
+
+	/* all columns are allocated in one block */
+	size = experiment_reader_interval_tree_size(n);
+	table->start_times = g_malloc((2*n + size)*sizeof(gint64) +
+				      n*sizeof(guint));
+	table->end_times = table->start_times + n;
+	table->max_end_tree = table->end_times + n;
+	table->text_offsets = (guint *)(table->max_end_tree + size);
+
+	for (guint i = 0; i < n; i++) {
+		ContribEntry *entry = &g_array_index(collector->entries,
+						     ContribEntry, i);
+
+		table->start_times[i] = entry->start_time;
+		table->end_times[i] = entry->end_time;
+		table->text_offsets[i] = entry->text_offset;
+	}
+	compute_max_end_tree(table->end_times, table->max_end_tree, n);
+
+	g_array_free(collector->entries, TRUE);
+	table->text = g_string_free(collector->text, FALSE);
+	g_free(collector);
+
+	return table;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+experiment_reader_contrib_collector_free(ContribCollector *collector)
+{
+	g_array_free(collector->entries, TRUE);
+	g_string_free(collector->text, TRUE);
+	g_free(collector);
+}
 
-		process_contribution(reader->priv->doc, contrib, &list);
+/** @private */
+static ExperimentReader *
+reader_new(const gchar *filename, ExperimentReaderFlags flags,
+	   GCancellable *cancellable)
+{
+	ExperimentReader *reader;
+	ExperimentReaderCacheKey key;
+
+	reader = EXPERIMENT_READER(g_object_new(EXPERIMENT_TYPE_READER, NULL));
+
+	if (flags & EXPERIMENT_READER_FLAG_CACHE) {
+		if (experiment_reader_cache_load(reader, filename, &key))
+			return reader;
+
+		/* cache file missing or stale */
+		flags |= EXPERIMENT_READER_FLAG_STREAMING;
 	}
 
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	if (flags & EXPERIMENT_READER_FLAG_STREAMING) {
+		if (!experiment_reader_stream_load(reader, filename,
+						   cancellable)) {
+			g_object_unref(G_OBJECT(reader));
+			return NULL;
+		}
+
+		if (flags & EXPERIMENT_READER_FLAG_CACHE)
+			experiment_reader_cache_save(reader, filename, &key);
+
+		return reader;
+	}
+
+	reader->priv->doc = xmlParseFile(filename);
+	if (reader->priv->doc == NULL ||
+	    g_cancellable_is_cancelled(cancellable) ||
+	    !build_timeline_index(reader)) {
+		g_object_unref(G_OBJECT(reader));
+		return NULL;
+	}
+
+	/** @todo validate against session.dtd */
+
+	return reader;
+}
+
+/** @private */
+static void
+new_async_data_free(gpointer data)
+{
+	NewAsyncData *new_data = data;
+
+	g_free(new_data->filename);
+	if (new_data->cancellable != NULL)
+		g_object_unref(new_data->cancellable);
+	if (new_data->reader != NULL)
+		g_object_unref(new_data->reader);
+	g_free(new_data);
+}
+
+/**
+ * @private
+ * Loads the session of an \ref experiment_reader_new_async operation.
+ * Executed in a worker thread.
+ */
+static void
+new_async_thread(GSimpleAsyncResult *res,
+		 GObject *object __attribute__((unused)),
+		 GCancellable *cancellable)
+{
+	NewAsyncData *data = g_simple_async_result_get_op_res_gpointer(res);
+	GError *error = NULL;
+
+	data->reader = reader_new(data->filename, data->flags, cancellable);
+	if (data->reader != NULL)
+		return;
+
+	if (!g_cancellable_set_error_if_cancelled(cancellable, &error))
+		g_set_error(&error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			    "Error loading session \"%s\"", data->filename);
+	g_simple_async_result_set_from_error(res, error);
+	g_error_free(error);
+}
+
+/*
+ * API
+ */
+
+/**
+ * @brief Constructs a new ExperimentReader object
+ *
+ * The XML document is kept in memory and queried on demand.
+ * This is equivalent to calling \ref experiment_reader_new_with_flags
+ * without flags.
+ *
+ * @param filename Filename of XML file to open
+ * @return A new \e ExperimentReader object. Free with \e g_object_unref.
+ */
+ExperimentReader *
+experiment_reader_new(const gchar *filename)
+{
+	return experiment_reader_new_with_flags(filename, 0);
+}
+
+/**
+ * @brief Constructs a new ExperimentReader object using the given flags
+ *
+ * If \ref EXPERIMENT_READER_FLAG_STREAMING is specified, the file is
+ * read in a single pass without building a document tree. All information
+ * required by the \e ExperimentReader API is extracted into compact
+ * structures, so that the reader's memory footprint is independent of the
+ * XML document size.
+ *
+ * If \ref EXPERIMENT_READER_FLAG_CACHE is specified, these structures are
+ * mapped from a binary cache file if it was built from the same file
+ * contents. Otherwise the file is read like in streaming mode and the
+ * cache file is (re)written.
+ *
+ * @param filename Filename of XML file to open
+ * @param flags    Bitmask of \ref ExperimentReaderFlags
+ * @return A new \e ExperimentReader object or \c NULL on error.
+ *         Free with \e g_object_unref.
+ */
+ExperimentReader *
+experiment_reader_new_with_flags(const gchar *filename,
+				 ExperimentReaderFlags flags)
+{
+	return reader_new(filename, flags, NULL);
+}
+
+/**
+ * @brief Asynchronously construct a new ExperimentReader object
+ *
+ * The session is loaded and indexed like in
+ * \ref experiment_reader_new_with_flags, but in a worker thread.
+ * When it is finished, \e callback is invoked in the main loop
+ * and must call \ref experiment_reader_new_finish to get the result.
+ *
+ * Loading may be aborted using \e cancellable. In streaming and
+ * cache mode, this stops parsing the file as soon as possible.
+ *
+ * @param filename    Filename of XML file to open
+ * @param flags       Bitmask of \ref ExperimentReaderFlags
+ * @param cancellable \e GCancellable to abort loading or \c NULL
+ * @param callback    Callback to invoke when the reader is ready
+ * @param user_data   Data to pass to \e callback
+ */
+void
+experiment_reader_new_async(const gchar *filename,
+			    ExperimentReaderFlags flags,
+			    GCancellable *cancellable,
+			    GAsyncReadyCallback callback,
+			    gpointer user_data)
+{
+	GSimpleAsyncResult *res;
+	NewAsyncData *data;
+
+	/* must be called in the main thread before parsing in other threads */
+	xmlInitParser();
+
+	data = g_new(NewAsyncData, 1);
+	data->filename = g_strdup(filename);
+	data->flags = flags;
+	data->cancellable = cancellable != NULL
+				? G_CANCELLABLE(g_object_ref(cancellable))
+				: NULL;
+	data->reader = NULL;
+
+	res = g_simple_async_result_new(NULL, callback, user_data,
+					experiment_reader_new_async);
+	g_simple_async_result_set_op_res_gpointer(res, data,
+						  new_async_data_free);
+
+	g_simple_async_result_run_in_thread(res, new_async_thread,
+					    G_PRIORITY_DEFAULT, cancellable);
+	g_object_unref(res);
+}
+
+/**
+ * @brief Finish constructing an ExperimentReader object asynchronously
+ *
+ * If the operation was cancelled, \c NULL is returned and \e error is
+ * set to \c G_IO_ERROR_CANCELLED, even if the reader was already loaded.
+ *
+ * @sa experiment_reader_new_async
+ *
+ * @param result \e GAsyncResult passed to the callback
+ * @param error  Location to store error or \c NULL
+ * @return A new \e ExperimentReader object or \c NULL on error.
+ *         Free with \e g_object_unref.
+ */
+ExperimentReader *
+experiment_reader_new_finish(GAsyncResult *result, GError **error)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT(result);
+	NewAsyncData *data;
+	ExperimentReader *reader;
+
+	g_return_val_if_fail(g_simple_async_result_is_valid(result, NULL,
+							    experiment_reader_new_async),
+			     NULL);
+
+	if (g_simple_async_result_propagate_error(res, error))
+		return NULL;
+
+	data = g_simple_async_result_get_op_res_gpointer(res);
+	/* the operation might have been cancelled after loading */
+	if (g_cancellable_set_error_if_cancelled(data->cancellable, error))
+		return NULL;
+
+	reader = data->reader;
+	data->reader = NULL;
+
+	return reader;
+}
+
+/**
+ * @brief Retrieve list of contributions by speaker
+ *
+ * Returns a newly-allocated doubly-linked list of
+ * \ref ExperimentReaderContrib structures representing all contributions
+ * by a given speaker. Every text fragment with a \e timepoint reference is
+ * considered a contribution.
+ * The list is sorted by the contributions' start times, in ascending order.
+ * Every list node and contribution is allocated separately, so the list
+ * may be modified by the caller.
+ * Use \ref experiment_reader_get_contrib_table_by_speaker to avoid
+ * allocating a copy of every contribution.
+ *
+ * @sa ExperimentReaderContrib
+ * @sa experiment_reader_get_contribution_by_time
+ * @sa experiment_reader_free_contributions
+ *
+ * @param reader  \e ExperimentReader instance
+ * @param speaker Full name of the speaker (e.g. "Wizard")
+ * @return Newly allocated list of contributions (must be freed with
+ *         \ref experiment_reader_free_contributions)
+ */
+GList *
+experiment_reader_get_contributions_by_speaker(ExperimentReader *reader,
+					       const gchar *speaker)
+{
+	ExperimentReaderContribTable *table;
+	GList *list = NULL;
+
+	table = experiment_reader_get_contrib_table_by_speaker(reader, speaker);
+
+	/* prepending in reverse order avoids traversing the list */
+	for (gint i = table->n_contribs - 1; i >= 0; i--) {
+		const gchar *text;
+		ExperimentReaderContrib *contrib;
+
+		text = experiment_reader_contrib_table_get_text(table, i);
+		contrib = g_malloc(sizeof(ExperimentReaderContrib) +
+				   strlen(text) + 1);
+		contrib->start_time =
+			experiment_reader_contrib_table_get_start_time(table, i);
+		g_stpcpy(contrib->text, text);
+
+		list = g_list_prepend(list, contrib);
+	}
+
+	experiment_reader_contrib_table_unref(table);
 
 	return list;
 }
@@ -439,6 +1248,10 @@ experiment_reader_get_contributions_by_speaker(ExperimentReader *reader,
  * The contribution is returned as a pointer into the contribution list
  * so that the list may be traversed by the caller.
  *
+ * This requires a linear search. Use
+ * \ref experiment_reader_contrib_table_lookup on contribution tables
+ * for frequent lookups.
+ *
  * @param contribs List of \ref ExperimentReaderContrib structures as returned
  *                 by \ref experiment_reader_get_contributions_by_speaker
  * @param timept   Time in milliseconds
@@ -470,39 +1283,513 @@ experiment_reader_get_contribution_by_time(GList *contribs, gint64 timept)
 void
 experiment_reader_free_contributions(GList *contribs)
 {
-	for (GList *cur = contribs; cur != NULL; cur = cur->next)
-		g_free(cur->data);
+	g_list_free_full(contribs, g_free);
+}
 
-	g_list_free(contribs);
+/**
+ * @brief Retrieve table of contributions by speaker
+ *
+ * Returns a \ref ExperimentReaderContribTable of all
+ * contributions by a given speaker. Every text fragment with a \e timepoint
+ * reference is considered a contribution.
+ * The table is sorted by the contributions' start times, in ascending order.
+ *
+ * @sa experiment_reader_contrib_table_lookup
+ * @sa experiment_reader_contrib_table_unref
+ *
+ * @param reader  \e ExperimentReader instance
+ * @param speaker Full name of the speaker (e.g. "Wizard")
+ * @return New reference to contribution table (must be unreferenced with
+ *         \ref experiment_reader_contrib_table_unref)
+ */
+ExperimentReaderContribTable *
+experiment_reader_get_contrib_table_by_speaker(ExperimentReader *reader,
+					       const gchar *speaker)
+{
+	ContribCollector *collector;
+
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+
+	xmlChar expr[255];
+
+	if (reader->priv->doc == NULL) {
+		ExperimentReaderContribTable *table;
+
+		table = g_hash_table_lookup(reader->priv->contrib_tables,
+					    speaker);
+		if (table != NULL)
+			return experiment_reader_contrib_table_ref(table);
+
+		/* empty table */
+		collector = experiment_reader_contrib_collector_new();
+		return experiment_reader_contrib_collector_finish(collector);
+	}
+
+	collector = experiment_reader_contrib_collector_new();
+
+	xpathCtx = xmlXPathNewContext(reader->priv->doc);
+
+	/* Evaluate xpath expression */
+	xmlStrPrintf(expr, sizeof(expr),
+		     XML_CHAR("//contribution[@speaker-reference = "
+			      "/session/speakers/speaker[name = '%s']/@speaker-id]"),
+		     speaker);
+	xpathObj = xmlXPathEvalExpression(expr, xpathCtx);
+
+	for (int i = 0; xpathObj->nodesetval != NULL &&
+			i < xpathObj->nodesetval->nodeNr; i++) {
+		xmlNode *contrib = xpathObj->nodesetval->nodeTab[i];
+
+		process_contribution(reader, contrib, collector);
+	}
+
+	xmlXPathFreeObject(xpathObj);
+	xmlXPathFreeContext(xpathCtx);
+
+	return experiment_reader_contrib_collector_finish(collector);
 }
 
 /**
- * Calls \e callback with \e userdata for each \b topic in the \b greeting
- * section of the experiment.
+ * @brief Retrieve tables of contributions of all speakers
  *
- * @param reader   \e ExperimentReader instance
- * @param callback Function to invoke
- * @param userdata User data to pass to \e callback
+ * Returns a hash table mapping speaker names, interned as \e GQuark,
+ * to \ref ExperimentReaderContribTable structures.
+ * All contributions of the session are traversed only once, so this is
+ * more efficient than calling
+ * \ref experiment_reader_get_contrib_table_by_speaker for every speaker.
+ * Speakers without contributions are not contained in the hash table.
+ *
+ * Tables may be looked up like this:
+ * \code
+ * table = g_hash_table_lookup(tables,
+ *                             GUINT_TO_POINTER(g_quark_from_string("Wizard")));
+ * \endcode
+ *
+ * @param reader \e ExperimentReader instance
+ * @return New reference to hash table with \e GQuark keys (converted
+ *         using \e GUINT_TO_POINTER) and contribution table values.
+ *         Must be unreferenced using \e g_hash_table_unref. The tables
+ *         are unreferenced along with the hash table, so take your own
+ *         reference using \ref experiment_reader_contrib_table_ref in
+ *         order to keep them.
  */
-void
-experiment_reader_foreach_greeting_topic(ExperimentReader *reader,
-					 ExperimentReaderTopicCallback callback,
-					 gpointer userdata)
+GHashTable *
+experiment_reader_get_contrib_tables(ExperimentReader *reader)
 {
+	GHashTable *tables;
+	GHashTable *collectors, *tables_by_id;
+	GHashTableIter iter;
+	gpointer speaker_ref, collector;
+
 	xmlXPathContext	*xpathCtx;
 	xmlXPathObject	*xpathObj;
-	GClosure	*closure;
+
+	tables = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+				       (GDestroyNotify)experiment_reader_contrib_table_unref);
+
+	if (reader->priv->doc == NULL) {
+		gpointer name, table;
+
+		g_hash_table_iter_init(&iter, reader->priv->contrib_tables);
+		while (g_hash_table_iter_next(&iter, &name, &table))
+			g_hash_table_insert(tables,
+					    GUINT_TO_POINTER(g_quark_from_string(name)),
+					    experiment_reader_contrib_table_ref(table));
+
+		return tables;
+	}
+
+	/* speaker Ids mapped to contribution collectors, later to tables */
+	collectors = g_hash_table_new_full(g_str_hash, g_str_equal, xmlFree,
+					   (GDestroyNotify)experiment_reader_contrib_collector_free);
+	tables_by_id = g_hash_table_new_full(g_str_hash, g_str_equal, xmlFree,
+					     (GDestroyNotify)experiment_reader_contrib_table_unref);
 
 	xpathCtx = xmlXPathNewContext(reader->priv->doc);
-	xpathObj = xmlXPathEvalExpression(XML_CHAR("/session/greeting/topic"),
+
+	xpathObj = xmlXPathEvalExpression(XML_CHAR("//contribution[@speaker-reference]"),
 					  xpathCtx);
+	for (int i = 0; xpathObj->nodesetval != NULL &&
+			i < xpathObj->nodesetval->nodeNr; i++) {
+		xmlNode *contrib = xpathObj->nodesetval->nodeTab[i];
+
+		speaker_ref = xmlGetProp(contrib, XML_CHAR("speaker-reference"));
+		collector = g_hash_table_lookup(collectors, speaker_ref);
+		if (collector == NULL) {
+			collector = experiment_reader_contrib_collector_new();
+			g_hash_table_insert(collectors, speaker_ref, collector);
+		} else {
+			xmlFree(speaker_ref);
+		}
+
+		process_contribution(reader, contrib, collector);
+	}
+	xmlXPathFreeObject(xpathObj);
 
-	closure = experiment_reader_topic_callback_new(callback, userdata);
-	generic_foreach_topic(reader, xpathObj->nodesetval, closure);
-	g_closure_unref(closure);
+	g_hash_table_iter_init(&iter, collectors);
+	while (g_hash_table_iter_next(&iter, &speaker_ref, &collector)) {
+		g_hash_table_insert(tables_by_id, speaker_ref,
+				    experiment_reader_contrib_collector_finish(collector));
+		g_hash_table_iter_steal(&iter);
+	}
+	g_hash_table_destroy(collectors);
 
+	xpathObj = xmlXPathEvalExpression(XML_CHAR("/session/speakers/speaker/name"),
+					  xpathCtx);
+	for (int i = 0; xpathObj->nodesetval != NULL &&
+			i < xpathObj->nodesetval->nodeNr; i++) {
+		xmlNode *name_node = xpathObj->nodesetval->nodeTab[i];
+		xmlChar *speaker_id, *name;
+		ExperimentReaderContribTable *table;
+		gpointer quark;
+
+		speaker_id = xmlGetProp(name_node->parent, XML_CHAR("speaker-id"));
+		table = speaker_id != NULL
+				? g_hash_table_lookup(tables_by_id, speaker_id)
+				: NULL;
+		xmlFree(speaker_id);
+		if (table == NULL)
+			continue;
+
+		name = xmlNodeGetContent(name_node);
+		quark = GUINT_TO_POINTER(g_quark_from_string((const gchar *)name));
+		xmlFree(name);
+
+		/*
+		 * If there are multiple speakers with the same name,
+		 * the first one wins
+		 */
+		if (!g_hash_table_lookup(tables, quark))
+			g_hash_table_insert(tables, quark,
+					    experiment_reader_contrib_table_ref(table));
+	}
 	xmlXPathFreeObject(xpathObj);
+
 	xmlXPathFreeContext(xpathCtx);
+	g_hash_table_destroy(tables_by_id);
+
+	return tables;
+}
+
+/**
+ * @brief Get a contribution of a contribution table by time
+ *
+ * Gets the closest contribution after the specified time or the last one
+ * if there is no contribution after the specified time.
+ * This is semantically equivalent to
+ * \ref experiment_reader_get_contribution_by_time but performs a binary
+ * search.
+ * The contribution is returned as an index into the table so that it may
+ * be traversed by the caller.
+ *
+ * @param table  \ref ExperimentReaderContribTable instance
+ * @param timept Time in milliseconds
+ * @return Index of contribution or -1 if the table is empty
+ */
+gint
+experiment_reader_contrib_table_lookup(const ExperimentReaderContribTable *table,
+				       gint64 timept)
+{
+	guint low = 0, high;
+
+	if (!table->n_contribs)
+		return -1;
+
+	/* find first contribution with start time > timept */
+	high = table->n_contribs - 1;
+	while (low < high) {
+		guint mid = low + (high - low)/2;
+
+		if (table->start_times[mid] > timept)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return (gint)low;
+}
+
+/**
+ * @brief Get the contribution of a contribution table active at a time
+ *
+ * In contrast to \ref experiment_reader_contrib_table_lookup, only a
+ * contribution whose time range contains \e timept is returned.
+ * If several contributions contain \e timept (e.g. at a shared
+ * boundary), the one starting last is returned.
+ * This is an O(log n) lookup.
+ *
+ * @param table  \ref ExperimentReaderContribTable instance
+ * @param timept Time in milliseconds
+ * @return Index of contribution or -1 if no contribution is active
+ */
+gint
+experiment_reader_contrib_table_lookup_active(const ExperimentReaderContribTable *table,
+					      gint64 timept)
+{
+	return interval_lookup(table->start_times, table->end_times,
+			       table->max_end_tree, table->n_contribs,
+			       timept);
+}
+
+/**
+ * @brief Get the contributions of a contribution table within a range of
+ *        time
+ *
+ * Determines the index range of contributions overlapping the time range
+ * [\e start, \e end] in O(log n), e.g. the contributions visible in
+ * a view.
+ * If the table's contributions overlap each other, the index range may
+ * also include contributions that end before \e start.
+ *
+ * @param table  \ref ExperimentReaderContribTable instance
+ * @param start  Start of range in milliseconds
+ * @param end    End of range in milliseconds
+ * @param first  Location to store index of first contribution
+ * @param last   Location to store index of last contribution
+ * @return \c TRUE if contributions overlap the range, else \c FALSE
+ *         (\e first and \e last are unchanged)
+ */
+gboolean
+experiment_reader_contrib_table_lookup_range(const ExperimentReaderContribTable *table,
+					     gint64 start, gint64 end,
+					     guint *first, guint *last)
+{
+	return interval_lookup_range(table->start_times, table->end_times,
+				     table->max_end_tree, table->n_contribs,
+				     start, end, first, last);
+}
+
+/**
+ * @brief Add reference to contribution table
+ *
+ * @param table \ref ExperimentReaderContribTable instance
+ * @return \e table
+ */
+ExperimentReaderContribTable *
+experiment_reader_contrib_table_ref(ExperimentReaderContribTable *table)
+{
+	g_atomic_int_inc(&table->ref_count);
+
+	return table;
+}
+
+/**
+ * @brief Remove reference from contribution table
+ *
+ * The table and all of its data is freed when the last reference is
+ * removed.
+ *
+ * @param table \ref ExperimentReaderContribTable instance
+ */
+void
+experiment_reader_contrib_table_unref(ExperimentReaderContribTable *table)
+{
+	if (!g_atomic_int_dec_and_test(&table->ref_count))
+		return;
+
+	if (table->mapping != NULL) {
+		/* columns point into cache file */
+		g_mapped_file_unref(table->mapping);
+	} else {
+		/* also frees text_offsets */
+		g_free(table->start_times);
+		g_free(table->text);
+	}
+	g_free(table);
+}
+
+/**
+ * @brief Get the structure of the session
+ *
+ * Returns all sections of the session and their topics, including
+ * precomputed start and end times. It is built only once, so
+ * enumerating the topics of all sections requires a single traversal
+ * of the session.
+ *
+ * @sa experiment_reader_structure_foreach_topic
+ *
+ * @param reader \e ExperimentReader instance
+ * @return Session structure, owned by \e reader and valid until it is
+ *         finalized
+ */
+const ExperimentReaderStructure *
+experiment_reader_get_structure(ExperimentReader *reader)
+{
+	ExperimentReaderPrivate *priv = reader->priv;
+	gint64 end_time = -1;
+
+	if (priv->structure != NULL)
+		return priv->structure;
+
+	/* the native model already contains all topics */
+	if (priv->topics[0] == NULL)
+		build_topics(reader);
+
+	priv->structure = g_new(ExperimentReaderStructure, 1);
+
+	for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++) {
+		ExperimentReaderSectionInfo *info = priv->structure->sections + i;
+		GArray *topics = priv->topics[i];
+
+		info->n_topics = topics->len;
+		info->topics = (const ExperimentReaderTopic *)topics->data;
+
+		info->start_time = -1;
+		for (guint j = 0; j < info->n_topics; j++) {
+			const ExperimentReaderTopic *topic = info->topics + j;
+
+			/* topics without contributions have no times */
+			if (topic->start_time < 0 || topic->end_time < 0)
+				continue;
+
+			if (info->start_time < 0)
+				info->start_time = topic->start_time;
+			/* topics may overlap, so the last one need not end last */
+			end_time = MAX(end_time, topic->end_time);
+		}
+
+		/* empty sections begin and end where the preceding one ends */
+		if (info->start_time < 0)
+			info->start_time = end_time;
+		info->end_time = end_time;
+	}
+
+	priv->structure->index = topic_index_new(priv->structure);
+
+	return priv->structure;
+}
+
+/**
+ * Calls \e func with \e data for each topic of a section in a
+ * session structure, in document order.
+ * In contrast to \ref experiment_reader_foreach_greeting_topic and
+ * related functions, \e func is called directly with the topic
+ * owned by the structure.
+ *
+ * @param structure Session structure
+ * @param section   Section to iterate
+ * @param func      Function to invoke
+ * @param data      User data to pass to \e func
+ */
+void
+experiment_reader_structure_foreach_topic(const ExperimentReaderStructure *structure,
+					  ExperimentReaderSection section,
+					  ExperimentReaderTopicFunc func,
+					  gpointer data)
+{
+	const ExperimentReaderSectionInfo *info = structure->sections + section;
+
+	for (guint i = 0; i < info->n_topics; i++)
+		func(section, info->topics + i, data);
+}
+
+/**
+ * @brief Get section of a session structure containing a point in time
+ *
+ * Sections are bounded by their \e start_time and \e end_time.
+ * If sections share a boundary, the later one is returned.
+ *
+ * @param structure Session structure
+ * @param timept    Time in milliseconds
+ * @return \ref ExperimentReaderSection or -1 if \e timept is not within
+ *         any section
+ */
+gint
+experiment_reader_structure_lookup_section(const ExperimentReaderStructure *structure,
+					   gint64 timept)
+{
+	/* constant number of sections */
+	for (gint i = EXPERIMENT_READER_SECTION_COUNT - 1; i >= 0; i--) {
+		const ExperimentReaderSectionInfo *info = structure->sections + i;
+
+		if (info->start_time >= 0 &&
+		    info->start_time <= timept && timept <= info->end_time)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Get topic of a session structure containing a point in time
+ *
+ * Topics span from the start of their first to the end of their last
+ * contribution. If several topics contain \e timept (e.g. at a shared
+ * boundary), the one starting last is returned.
+ * This is an O(log n) lookup in an interval index built along with the
+ * structure.
+ *
+ * @param structure Session structure
+ * @param timept    Time in milliseconds
+ * @param section   Location to store the topic's section or \c NULL
+ * @return Topic (owned by \e structure) or \c NULL if \e timept is not
+ *         within any topic
+ */
+const ExperimentReaderTopic *
+experiment_reader_structure_lookup_topic(const ExperimentReaderStructure *structure,
+					 gint64 timept,
+					 ExperimentReaderSection *section)
+{
+	const ExperimentReaderTopicIndex *index = structure->index;
+	gint i;
+
+	i = interval_lookup(index->start_times, index->end_times,
+			    index->max_end_tree, index->n_topics, timept);
+	if (i < 0)
+		return NULL;
+
+	if (section != NULL)
+		*section = index->sections[i];
+	return index->topics[i];
+}
+
+/**
+ * Calls \e func with \e data for each topic of a session structure
+ * overlapping the time range [\e start, \e end], in order of their
+ * start times.
+ * Topics without contributions are never reported.
+ *
+ * @param structure Session structure
+ * @param start     Start of range in milliseconds
+ * @param end       End of range in milliseconds
+ * @param func      Function to invoke
+ * @param data      User data to pass to \e func
+ */
+void
+experiment_reader_structure_foreach_topic_in_range(const ExperimentReaderStructure *structure,
+						   gint64 start, gint64 end,
+						   ExperimentReaderTopicFunc func,
+						   gpointer data)
+{
+	const ExperimentReaderTopicIndex *index = structure->index;
+	guint first, last;
+
+	if (!interval_lookup_range(index->start_times, index->end_times,
+				   index->max_end_tree, index->n_topics,
+				   start, end, &first, &last))
+		return;
+
+	for (guint i = first; i <= last; i++)
+		if (index->end_times[i] >= start)
+			func(index->sections[i], index->topics[i], data);
+}
+
+/**
+ * Calls \e callback with \e userdata for each \b topic in the \b greeting
+ * section of the experiment.
+ *
+ * @param reader   \e ExperimentReader instance
+ * @param callback Function to invoke
+ * @param userdata User data to pass to \e callback
+ */
+void
+experiment_reader_foreach_greeting_topic(ExperimentReader *reader,
+					 ExperimentReaderTopicCallback callback,
+					 gpointer userdata)
+{
+	foreach_topic(reader, EXPERIMENT_READER_SECTION_GREETING,
+		      callback, userdata);
 }
 
 /**
@@ -520,21 +1807,8 @@ experiment_reader_foreach_exp_initial_narrative_topic(reader, callback, userdata
 	ExperimentReaderTopicCallback	callback;
 	gpointer			userdata;
 {
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	GClosure	*closure;
-
-	xpathCtx = xmlXPathNewContext(reader->priv->doc);
-	xpathObj = xmlXPathEvalExpression(XML_CHAR("/session/experiment/"
-						   "initial-narrative/topic"),
-					  xpathCtx);
-
-	closure = experiment_reader_topic_callback_new(callback, userdata);
-	generic_foreach_topic(reader, xpathObj->nodesetval, closure);
-	g_closure_unref(closure);
-
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	foreach_topic(reader, EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE,
+		      callback, userdata);
 }
 
 /**
@@ -554,27 +1828,12 @@ experiment_reader_foreach_exp_last_minute_phase_topic(reader, phase, callback, u
 	ExperimentReaderTopicCallback	callback;
 	gpointer			userdata;
 {
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	GClosure	*closure;
-
-	xmlChar expr[255];
-
-	xpathCtx = xmlXPathNewContext(reader->priv->doc);
-
-	/* Evaluate xpath expression */
-	xmlStrPrintf(expr, sizeof(expr),
-		     XML_CHAR("/session/experiment/last-minute/"
-			      "phase[@id = '%d']/topic"),
-		     phase);
-	xpathObj = xmlXPathEvalExpression(expr, xpathCtx);
-
-	closure = experiment_reader_topic_callback_new(callback, userdata);
-	generic_foreach_topic(reader, xpathObj->nodesetval, closure);
-	g_closure_unref(closure);
+	if (phase < 1 || phase > 6)
+		return;
 
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	foreach_topic(reader,
+		      EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + phase - 1,
+		      callback, userdata);
 }
 
 /**
@@ -590,18 +1849,6 @@ experiment_reader_foreach_farewell_topic(ExperimentReader *reader,
 					 ExperimentReaderTopicCallback callback,
 					 gpointer userdata)
 {
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	GClosure	*closure;
-
-	xpathCtx = xmlXPathNewContext(reader->priv->doc);
-	xpathObj = xmlXPathEvalExpression(XML_CHAR("/session/farewell/topic"),
-					  xpathCtx);
-
-	closure = experiment_reader_topic_callback_new(callback, userdata);
-	generic_foreach_topic(reader, xpathObj->nodesetval, closure);
-	g_closure_unref(closure);
-
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	foreach_topic(reader, EXPERIMENT_READER_SECTION_FAREWELL,
+		      callback, userdata);
 }
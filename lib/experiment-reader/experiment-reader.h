@@ -25,6 +25,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -69,6 +70,97 @@ typedef struct _ExperimentReaderClass {
 /** @private */
 GType experiment_reader_get_type(void);
 
+/**
+ * Flags controlling how an \e ExperimentReader loads a session
+ *
+ * @sa experiment_reader_new_with_flags
+ */
+typedef enum {
+	/**
+	 * Read the session in a single streaming pass into compact
+	 * native structures instead of keeping the XML document in memory
+	 */
+	EXPERIMENT_READER_FLAG_STREAMING = 1 << 0,
+	/**
+	 * Load the session from a binary cache file in the user's cache
+	 * directory if it is up to date, else read it like
+	 * \ref EXPERIMENT_READER_FLAG_STREAMING and (re)write the cache file
+	 */
+	EXPERIMENT_READER_FLAG_CACHE = 1 << 1
+} ExperimentReaderFlags;
+
+/**
+ * Sections of a session containing \b topic elements, in document order
+ *
+ * @sa experiment_reader_get_structure
+ */
+typedef enum {
+	EXPERIMENT_READER_SECTION_GREETING = 0,	/**< \b greeting */
+	/** \b initial-narrative of \b experiment */
+	EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE,
+	/**
+	 * First \b phase of \b last-minute of \b experiment.
+	 * Phase \e n (1 to 6) has the value
+	 * <tt>EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + n - 1</tt>.
+	 */
+	EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE,
+	/** Last (sixth) \b phase of \b last-minute of \b experiment */
+	EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE_LAST =
+		EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + 5,
+	/** \b farewell */
+	EXPERIMENT_READER_SECTION_FAREWELL,
+
+	EXPERIMENT_READER_SECTION_COUNT	/**< Number of sections */
+} ExperimentReaderSection;
+
+/**
+ * Structure describing a \b topic
+ */
+typedef struct _ExperimentReaderTopic {
+	const gchar	*id;		/**< Symbolic identifier of topic or \c NULL */
+	gint64		start_time;	/**< Beginning of first \b contribution (milliseconds) or -1 */
+	gint64		end_time;	/**< End of last \b contribution (milliseconds) or -1 */
+} ExperimentReaderTopic;
+
+/**
+ * Structure describing a section of a session and its topics
+ */
+typedef struct _ExperimentReaderSectionInfo {
+	/**
+	 * Beginning of the section's first topic with contributions
+	 * (milliseconds). Sections without such topics begin at the end
+	 * of the preceding section, the first section at -1.
+	 */
+	gint64				start_time;
+	/**
+	 * Latest end of the section's topics with contributions
+	 * (milliseconds), but not before the end of the preceding section.
+	 * Sections without such topics end at the end of the preceding
+	 * section, the first section at -1.
+	 */
+	gint64				end_time;
+
+	guint				n_topics;	/**< Number of topics */
+	const ExperimentReaderTopic	*topics;	/**< Topics in document order */
+} ExperimentReaderSectionInfo;
+
+/** @private */
+typedef struct _ExperimentReaderTopicIndex ExperimentReaderTopicIndex;
+
+/**
+ * Materialized structure of a session, i.e. all its sections and topics.
+ * It is owned by the \e ExperimentReader instance and must not be modified.
+ *
+ * @sa experiment_reader_get_structure
+ * @sa experiment_reader_structure_lookup_topic
+ */
+typedef struct _ExperimentReaderStructure {
+	/** Sections indexed by \ref ExperimentReaderSection */
+	ExperimentReaderSectionInfo	sections[EXPERIMENT_READER_SECTION_COUNT];
+
+	ExperimentReaderTopicIndex	*index;	/**< @private */
+} ExperimentReaderStructure;
+
 /*
  * Callbacks
  */
@@ -87,6 +179,20 @@ typedef void (*ExperimentReaderTopicCallback)(ExperimentReader *reader,
 					      gint64 end_time,
 					      gpointer data);
 
+/**
+ * Type of function to use for iterating the topics of an
+ * \ref ExperimentReaderStructure.
+ *
+ * @sa experiment_reader_structure_foreach_topic
+ *
+ * @param section Section containing the topic
+ * @param topic   Topic (owned by the structure)
+ * @param data    Callback user data
+ */
+typedef void (*ExperimentReaderTopicFunc)(ExperimentReaderSection section,
+					  const ExperimentReaderTopic *topic,
+					  gpointer data);
+
 /**
  * Structure describing a contribution. Every text-fragment identified by
  * a distinct \e timepoint is considered a contribution.
@@ -96,10 +202,93 @@ typedef struct {
 	gchar	text[];		/**< Contribution's text content (part of the structure) */
 } ExperimentReaderContrib;
 
+/**
+ * Immutable table of contributions, sorted by their start times in
+ * ascending order.
+ * In contrast to lists of \ref ExperimentReaderContrib structures,
+ * it is stored as a structure of arrays, i.e. the contributions' start
+ * and end times are kept in contiguous arrays and all texts are kept
+ * in a single string blob.
+ *
+ * A contribution ends where the next text fragment of the same
+ * \b contribution element begins (at its \b time marker) or at the
+ * element's \b end-reference.
+ *
+ * @sa experiment_reader_get_contrib_table_by_speaker
+ * @sa experiment_reader_contrib_table_lookup
+ * @sa experiment_reader_contrib_table_lookup_active
+ */
+typedef struct _ExperimentReaderContribTable {
+	guint		n_contribs;	/**< Number of contributions in table */
+	gint64		*start_times;	/**< Contributions' start times in milliseconds */
+	gint64		*end_times;	/**< Contributions' end times in milliseconds */
+	guint		*text_offsets;	/**< Offsets of contributions' texts into \e text */
+	gchar		*text;		/**< Blob of null-terminated contribution texts */
+
+	/**
+	 * @private
+	 * Tree of maximum end times of contributions, for interval queries
+	 */
+	gint64		*max_end_tree;
+	gint		ref_count;	/**< @private */
+	GMappedFile	*mapping;	/**< @private */
+} ExperimentReaderContribTable;
+
+/**
+ * Get start time of a contribution in a table.
+ *
+ * @param table \ref ExperimentReaderContribTable instance
+ * @param i     Index of contribution (must be smaller than \e n_contribs)
+ * @return Start time in milliseconds
+ */
+static inline gint64
+experiment_reader_contrib_table_get_start_time(const ExperimentReaderContribTable *table,
+					       guint i)
+{
+	return table->start_times[i];
+}
+
+/**
+ * Get end time of a contribution in a table.
+ *
+ * @param table \ref ExperimentReaderContribTable instance
+ * @param i     Index of contribution (must be smaller than \e n_contribs)
+ * @return End time in milliseconds
+ */
+static inline gint64
+experiment_reader_contrib_table_get_end_time(const ExperimentReaderContribTable *table,
+					     guint i)
+{
+	return table->end_times[i];
+}
+
+/**
+ * Get text of a contribution in a table.
+ *
+ * @param table \ref ExperimentReaderContribTable instance
+ * @param i     Index of contribution (must be smaller than \e n_contribs)
+ * @return Null-terminated text, owned by \e table
+ */
+static inline const gchar *
+experiment_reader_contrib_table_get_text(const ExperimentReaderContribTable *table,
+					 guint i)
+{
+	return table->text + table->text_offsets[i];
+}
+
 /*
  * API
  */
 ExperimentReader *experiment_reader_new(const gchar *filename);
+ExperimentReader *experiment_reader_new_with_flags(const gchar *filename,
+						   ExperimentReaderFlags flags);
+void experiment_reader_new_async(const gchar *filename,
+				 ExperimentReaderFlags flags,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data);
+ExperimentReader *experiment_reader_new_finish(GAsyncResult *result,
+					       GError **error);
 
 GList *experiment_reader_get_contributions_by_speaker(
 	ExperimentReader		*reader,
@@ -110,6 +299,49 @@ GList *experiment_reader_get_contribution_by_time(
 void experiment_reader_free_contributions(
 	GList				*contribs);
 
+ExperimentReaderContribTable *experiment_reader_get_contrib_table_by_speaker(
+	ExperimentReader		*reader,
+	const gchar			*speaker);
+GHashTable *experiment_reader_get_contrib_tables(
+	ExperimentReader		*reader);
+gint experiment_reader_contrib_table_lookup(
+	const ExperimentReaderContribTable *table,
+	gint64				timept);
+gint experiment_reader_contrib_table_lookup_active(
+	const ExperimentReaderContribTable *table,
+	gint64				timept);
+gboolean experiment_reader_contrib_table_lookup_range(
+	const ExperimentReaderContribTable *table,
+	gint64				start,
+	gint64				end,
+	guint				*first,
+	guint				*last);
+ExperimentReaderContribTable *experiment_reader_contrib_table_ref(
+	ExperimentReaderContribTable	*table);
+void experiment_reader_contrib_table_unref(
+	ExperimentReaderContribTable	*table);
+
+const ExperimentReaderStructure *experiment_reader_get_structure(
+	ExperimentReader		*reader);
+void experiment_reader_structure_foreach_topic(
+	const ExperimentReaderStructure	*structure,
+	ExperimentReaderSection		section,
+	ExperimentReaderTopicFunc	func,
+	gpointer			data);
+gint experiment_reader_structure_lookup_section(
+	const ExperimentReaderStructure	*structure,
+	gint64				timept);
+const ExperimentReaderTopic *experiment_reader_structure_lookup_topic(
+	const ExperimentReaderStructure	*structure,
+	gint64				timept,
+	ExperimentReaderSection		*section);
+void experiment_reader_structure_foreach_topic_in_range(
+	const ExperimentReaderStructure	*structure,
+	gint64				start,
+	gint64				end,
+	ExperimentReaderTopicFunc	func,
+	gpointer			data);
+
 void experiment_reader_foreach_greeting_topic(
 	ExperimentReader		*reader,
 	ExperimentReaderTopicCallback	callback,
@@ -0,0 +1,384 @@
+/**
+ * @file
+ * libexperiment-reader benchmark suite.
+ *
+ * Generates sessions of increasing size and times loading, per-speaker
+ * contribution extraction, topic enumeration and time lookups for all
+ * loading modes. Results are written as tab-separated values, one line
+ * per measurement, so they can be compared across builds.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <experiment-reader.h>
+
+#include "session-generator.h"
+
+/** Number of random time lookups per measurement */
+#define BENCHMARK_LOOKUPS	100000
+
+/** Loading modes to benchmark */
+static const struct {
+	const gchar		*name;
+	ExperimentReaderFlags	flags;
+} modes[] = {
+	{"dom",		0},
+	{"streaming",	EXPERIMENT_READER_FLAG_STREAMING},
+	{"cache",	EXPERIMENT_READER_FLAG_CACHE}
+};
+
+static gchar *opt_scales = NULL;
+static gint opt_repeat = 3;
+static gchar *opt_output = NULL;
+static gboolean opt_keep = FALSE;
+
+static GOptionEntry entries[] = {
+	{"scales", 's', 0, G_OPTION_ARG_STRING, &opt_scales,
+	 "Comma-separated session scale factors (default: 1,10,100)", "LIST"},
+	{"repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+	 "Repeat each measurement N times, reporting the minimum (default: 3)",
+	 "N"},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	 "Write results to FILE instead of standard output", "FILE"},
+	{"keep", 'k', 0, G_OPTION_ARG_NONE, &opt_keep,
+	 "Keep generated session files", NULL},
+	{NULL}
+};
+
+/** Results of one measurement, i.e. the best of all repetitions */
+typedef struct _Measurement {
+	gdouble	seconds;
+	guint64	ops;
+} Measurement;
+
+static void report(FILE *out, gdouble scale, const gchar *mode,
+		   const gchar *benchmark, const Measurement *m);
+static void measure(Measurement *m, GTimer *timer, guint64 ops);
+
+static void count_topic_cb(ExperimentReader *reader, const gchar *topic_id,
+			   gint64 start_time, gint64 end_time, gpointer data);
+static void count_structure_topic_cb(ExperimentReaderSection section,
+				     const ExperimentReaderTopic *topic,
+				     gpointer data);
+
+static void benchmark_session(FILE *out, gdouble scale,
+			      const SessionGeneratorParams *params,
+			      const gchar *filename);
+
+static void
+report(FILE *out, gdouble scale, const gchar *mode, const gchar *benchmark,
+       const Measurement *m)
+{
+	gchar scale_buf[G_ASCII_DTOSTR_BUF_SIZE];
+	gchar seconds_buf[G_ASCII_DTOSTR_BUF_SIZE];
+	gchar op_buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	fprintf(out, "%s\t%s\t%s\t%" G_GUINT64_FORMAT "\t%s\t%s\n",
+		g_ascii_formatd(scale_buf, sizeof(scale_buf), "%g", scale),
+		mode, benchmark, m->ops,
+		g_ascii_formatd(seconds_buf, sizeof(seconds_buf), "%.6f",
+				m->seconds),
+		g_ascii_formatd(op_buf, sizeof(op_buf), "%.1f",
+				m->ops ? m->seconds*1e9/m->ops : 0.));
+	fflush(out);
+}
+
+/**
+ * Record elapsed time of \e timer as a repetition of a measurement
+ */
+static void
+measure(Measurement *m, GTimer *timer, guint64 ops)
+{
+	gdouble elapsed = g_timer_elapsed(timer, NULL);
+
+	if (m->ops == 0 || elapsed < m->seconds)
+		m->seconds = elapsed;
+	m->ops = ops;
+}
+
+static void
+count_topic_cb(ExperimentReader *reader __attribute__((unused)),
+	       const gchar *topic_id __attribute__((unused)),
+	       gint64 start_time __attribute__((unused)),
+	       gint64 end_time __attribute__((unused)),
+	       gpointer data)
+{
+	++*(guint64 *)data;
+}
+
+static void
+count_structure_topic_cb(ExperimentReaderSection section __attribute__((unused)),
+			 const ExperimentReaderTopic *topic __attribute__((unused)),
+			 gpointer data)
+{
+	++*(guint64 *)data;
+}
+
+/**
+ * Run all benchmarks on one session file
+ */
+static void
+benchmark_session(FILE *out, gdouble scale,
+		  const SessionGeneratorParams *params, const gchar *filename)
+{
+	GTimer *timer = g_timer_new();
+	GRand *rand = g_rand_new_with_seed(params->seed);
+	gint64 duration = (gint64)(params->duration*1000.);
+	gint64 *times = g_new(gint64, BENCHMARK_LOOKUPS);
+
+	for (guint i = 0; i < BENCHMARK_LOOKUPS; i++)
+		times[i] = g_rand_int_range(rand, 0, (gint32)MIN(duration,
+								  G_MAXINT32));
+
+	for (guint mode = 0; mode < G_N_ELEMENTS(modes); mode++) {
+		Measurement load = {0, 0}, tables = {0, 0};
+		Measurement lists = {0, 0}, topics = {0, 0};
+		Measurement structure_topics = {0, 0};
+		Measurement lookup = {0, 0}, lookup_active = {0, 0};
+		Measurement lookup_topic = {0, 0};
+
+		if (modes[mode].flags & EXPERIMENT_READER_FLAG_CACHE) {
+			/* write cache file, so it is only mapped below */
+			ExperimentReader *reader;
+
+			reader = experiment_reader_new_with_flags(filename,
+								  modes[mode].flags);
+			if (reader != NULL)
+				g_object_unref(reader);
+		}
+
+		for (gint r = 0; r < opt_repeat; r++) {
+			ExperimentReader *reader;
+			GHashTable *contrib_tables;
+			GHashTableIter iter;
+			gpointer value;
+			const ExperimentReaderStructure *structure;
+			guint64 n, n_contribs = 0;
+			volatile gint64 sink = 0;
+
+			g_timer_start(timer);
+			reader = experiment_reader_new_with_flags(filename,
+								  modes[mode].flags);
+			g_timer_stop(timer);
+			if (reader == NULL) {
+				g_printerr("Cannot load \"%s\"\n", filename);
+				exit(EXIT_FAILURE);
+			}
+			measure(&load, timer, 1);
+
+			/* per-speaker extraction: table API */
+			g_timer_start(timer);
+			contrib_tables = experiment_reader_get_contrib_tables(reader);
+			g_hash_table_iter_init(&iter, contrib_tables);
+			while (g_hash_table_iter_next(&iter, NULL, &value))
+				n_contribs += ((ExperimentReaderContribTable *)value)->n_contribs;
+			g_timer_stop(timer);
+			measure(&tables, timer, n_contribs);
+
+			/* per-speaker extraction: list API */
+			n = 0;
+			g_timer_start(timer);
+			for (guint i = 0; i < params->n_speakers; i++) {
+				const gchar *speaker = i == 0 ? "Wizard" :
+						       i == 1 ? "Proband" : NULL;
+				gchar *name = NULL;
+				GList *contribs;
+
+				if (speaker == NULL)
+					speaker = name = g_strdup_printf("Speaker %u", i);
+				contribs = experiment_reader_get_contributions_by_speaker(reader,
+											  speaker);
+				n += g_list_length(contribs);
+				experiment_reader_free_contributions(contribs);
+				g_free(name);
+			}
+			g_timer_stop(timer);
+			measure(&lists, timer, n);
+
+			/* topic enumeration: callback API */
+			n = 0;
+			g_timer_start(timer);
+			experiment_reader_foreach_greeting_topic(reader,
+								 count_topic_cb,
+								 &n);
+			experiment_reader_foreach_exp_initial_narrative_topic(reader,
+									      count_topic_cb,
+									      &n);
+			for (gint i = 1; i <= 6; i++)
+				experiment_reader_foreach_exp_last_minute_phase_topic(reader, i,
+										      count_topic_cb,
+										      &n);
+			experiment_reader_foreach_farewell_topic(reader,
+								 count_topic_cb,
+								 &n);
+			g_timer_stop(timer);
+			measure(&topics, timer, n);
+
+			/* topic enumeration: session structure */
+			n = 0;
+			g_timer_start(timer);
+			structure = experiment_reader_get_structure(reader);
+			for (gint i = 0; i < EXPERIMENT_READER_SECTION_COUNT; i++)
+				experiment_reader_structure_foreach_topic(structure, i,
+									  count_structure_topic_cb,
+									  &n);
+			g_timer_stop(timer);
+			measure(&structure_topics, timer, n);
+
+			/* time lookups in all speakers' tables */
+			g_timer_start(timer);
+			g_hash_table_iter_init(&iter, contrib_tables);
+			while (g_hash_table_iter_next(&iter, NULL, &value))
+				for (guint i = 0; i < BENCHMARK_LOOKUPS; i++)
+					sink += experiment_reader_contrib_table_lookup(value,
+										       times[i]);
+			g_timer_stop(timer);
+			measure(&lookup, timer, (guint64)BENCHMARK_LOOKUPS*
+						g_hash_table_size(contrib_tables));
+
+			g_timer_start(timer);
+			g_hash_table_iter_init(&iter, contrib_tables);
+			while (g_hash_table_iter_next(&iter, NULL, &value))
+				for (guint i = 0; i < BENCHMARK_LOOKUPS; i++)
+					sink += experiment_reader_contrib_table_lookup_active(value,
+											      times[i]);
+			g_timer_stop(timer);
+			measure(&lookup_active, timer,
+				(guint64)BENCHMARK_LOOKUPS*
+				g_hash_table_size(contrib_tables));
+
+			g_timer_start(timer);
+			for (guint i = 0; i < BENCHMARK_LOOKUPS; i++)
+				sink += experiment_reader_structure_lookup_topic(structure,
+										 times[i],
+										 NULL) != NULL;
+			g_timer_stop(timer);
+			measure(&lookup_topic, timer, BENCHMARK_LOOKUPS);
+
+			(void)sink;
+			g_hash_table_unref(contrib_tables);
+			g_object_unref(reader);
+		}
+
+		report(out, scale, modes[mode].name, "new", &load);
+		report(out, scale, modes[mode].name, "contrib_tables", &tables);
+		report(out, scale, modes[mode].name, "contributions_by_speaker",
+		       &lists);
+		report(out, scale, modes[mode].name, "foreach_topic", &topics);
+		report(out, scale, modes[mode].name, "structure_foreach_topic",
+		       &structure_topics);
+		report(out, scale, modes[mode].name, "contrib_table_lookup",
+		       &lookup);
+		report(out, scale, modes[mode].name,
+		       "contrib_table_lookup_active", &lookup_active);
+		report(out, scale, modes[mode].name, "structure_lookup_topic",
+		       &lookup_topic);
+	}
+
+	g_free(times);
+	g_rand_free(rand);
+	g_timer_destroy(timer);
+}
+
+/** @private */
+int
+main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar **scales;
+	gchar *cache_dir;
+	FILE *out = stdout;
+
+	g_thread_init(NULL);
+	g_type_init();
+
+	context = g_option_context_new("- benchmark libexperiment-reader");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	opt_repeat = MAX(opt_repeat, 1);
+
+	if (opt_output != NULL) {
+		out = g_fopen(opt_output, "w");
+		if (out == NULL) {
+			g_printerr("Cannot open \"%s\"\n", opt_output);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* don't pollute the user's cache directory */
+	cache_dir = g_build_filename(g_get_tmp_dir(),
+				     "experiment-reader-benchmark", NULL);
+	g_setenv("XDG_CACHE_HOME", cache_dir, TRUE);
+	g_free(cache_dir);
+
+#ifdef PACKAGE_STRING
+	fprintf(out, "# %s\n", PACKAGE_STRING);
+#endif
+	fputs("scale\tmode\tbenchmark\tops\tseconds\tns_per_op\n", out);
+
+	scales = g_strsplit(opt_scales != NULL ? opt_scales : "1,10,100",
+			    ",", 0);
+	for (gchar **p = scales; *p != NULL; p++) {
+		SessionGeneratorParams params;
+		gdouble scale = g_ascii_strtod(*p, NULL);
+		gchar *filename;
+
+		if (scale <= 0.) {
+			g_printerr("Invalid scale \"%s\"\n", *p);
+			return EXIT_FAILURE;
+		}
+
+		session_generator_params_init(&params);
+		session_generator_params_scale(&params, scale);
+		filename = session_generator_write_tmp(&params);
+		if (filename == NULL) {
+			g_printerr("Cannot generate session\n");
+			return EXIT_FAILURE;
+		}
+
+		benchmark_session(out, scale, &params, filename);
+
+		if (opt_keep)
+			g_printerr("Kept \"%s\"\n", filename);
+		else
+			g_unlink(filename);
+		g_free(filename);
+	}
+	g_strfreev(scales);
+
+	if (out != stdout)
+		fclose(out);
+
+	return EXIT_SUCCESS;
+}
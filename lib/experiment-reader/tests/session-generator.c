@@ -0,0 +1,305 @@
+/**
+ * @file
+ * Generator of synthetic session files for tests and benchmarks
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "session-generator.h"
+
+/** Number of sections that must contain topics */
+#define SECTIONS		9
+/** Fraction of a contribution's time slot without speech */
+#define CONTRIB_GAP		0.1
+
+/**
+ * Markup preceding the first topic of each section, and closing the
+ * last section (index \ref SECTIONS)
+ */
+static const gchar *section_markup[SECTIONS + 1] = {
+	"<greeting>\n",
+	"</greeting>\n<experiment>\n<initial-narrative>\n",
+	"</initial-narrative>\n<last-minute>\n<phase id=\"1\">\n",
+	"</phase>\n<phase id=\"2\">\n",
+	"</phase>\n<phase id=\"3\">\n",
+	"</phase>\n<phase id=\"4\">\n",
+	"</phase>\n<phase id=\"5\">\n",
+	"</phase>\n<phase id=\"6\">\n",
+	"</phase>\n</last-minute>\n</experiment>\n<farewell>\n",
+	"</farewell>\n"
+};
+
+/** Topic Ids permitted by \b session.dtd per section, cycled through */
+static const gchar *section_topics[SECTIONS][20] = {
+	{"bz_1", "bz_2", NULL},
+	{"i_1", "i_2", "i_3", "i_4", "i_5", "i_6", "i_7", "i_8", "i_10",
+	 "i_12", "i_14", "i_15", "i_16", "i_17", "i_19", "i_20", NULL},
+	{"lm_1_1", "lm_1_2", "lm_1_3", "lm_1_5", "lm_1_6", "lm_1_7",
+	 "lm_1_8", NULL},
+	{"lm_2_1", "lm_2_4", "lm_2_6", "lm_2_9", "lm_2_11", "lm_2_13",
+	 "lm_2_15", "lm_2_16", "lm_2_17", "lm_2_20", "lm_2_23", "lm_2_25",
+	 "lm_2_27", "lm_2_28", "lm_2_30", "lm_2_31", "lm_2_38", NULL},
+	{"lm_3_1", "lm_3_2", "lm_3_3", "lm_3_4", "lm_3_6", "lm_3_7",
+	 "lm_3_8", NULL},
+	{"lm_4_1", "lm_4_2", "lm_4_4", "lm_4_6", NULL},
+	{"lm_5_1", "lm_5_2", "lm_5_5", "lm_5_7", "lm_5_19", "lm_5_20",
+	 "lm_5_21", "lm_5_22", "lm_5_24", "lm_5_30", "lm_5_31", "lm_5_32",
+	 "lm_5_33", NULL},
+	{"a_6_1", "a_6_3", "a_6_5", NULL},
+	{"v_1", NULL}
+};
+
+static const gchar *pause_durations[] = {"micro", "short", "0.8", "1.5"};
+
+static const gchar *words[] = {
+	"Lorem", "ipsum", "dolor", "sit", "amet", "consetetur", "sadipscing",
+	"elitr", "sed", "diam", "nonumy", "eirmod", "tempor", "invidunt",
+	"ut", "labore", "et", "dolore", "magna", "aliquyam", "erat"
+};
+
+static guint density_count(GRand *rand, gdouble density);
+static void write_time(FILE *file, gdouble time);
+static guint write_words(FILE *file, guint word, guint n);
+
+/**
+ * Initialize session parameters with those of a session of typical
+ * size (about one hour).
+ *
+ * @param params Parameters to initialize
+ */
+void
+session_generator_params_init(SessionGeneratorParams *params)
+{
+	params->duration = 3600.;
+	params->n_speakers = 2;
+	params->n_contribs = 1500;
+	params->n_topics = 60;
+	params->time_density = 2.;
+	params->pause_density = 0.5;
+	params->words = 12;
+	params->seed = 1;
+}
+
+/**
+ * Scale size of a session, i.e. its duration, number of contributions
+ * and number of topics. Densities are not changed.
+ *
+ * @param params Parameters to modify
+ * @param factor Scale factor
+ */
+void
+session_generator_params_scale(SessionGeneratorParams *params,
+			       gdouble factor)
+{
+	params->duration *= factor;
+	params->n_contribs = (guint)(params->n_contribs*factor);
+	params->n_topics = (guint)(params->n_topics*factor);
+}
+
+/**
+ * Get number of elements for one contribution, so that the average
+ * number of elements per contribution is \e density
+ */
+static guint
+density_count(GRand *rand, gdouble density)
+{
+	guint count = (guint)density;
+
+	if (g_rand_double(rand) < density - count)
+		count++;
+
+	return count;
+}
+
+static void
+write_time(FILE *file, gdouble time)
+{
+	gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	fputs(g_ascii_formatd(buf, sizeof(buf), "%.3f", time), file);
+}
+
+static guint
+write_words(FILE *file, guint word, guint n)
+{
+	for (guint i = 0; i < n; i++, word++) {
+		fputs(words[word % G_N_ELEMENTS(words)], file);
+		fputc(' ', file);
+	}
+
+	return word;
+}
+
+/**
+ * @brief Write session file
+ *
+ * Contributions are spread evenly over the session's duration and
+ * do not overlap. Each one is delimited by its own timepoints, with its
+ * \b time elements referring to further timepoints in between.
+ * Speakers and the positions of \b time and \b pause elements are
+ * chosen randomly.
+ *
+ * @param params Session parameters
+ * @param file   File to write to
+ */
+void
+session_generator_write(const SessionGeneratorParams *params, FILE *file)
+{
+	GRand *rand = g_rand_new_with_seed(params->seed);
+	guint n_topics = MAX(params->n_topics, SECTIONS);
+	guint n_contribs = MAX(params->n_contribs, n_topics);
+	guint n_speakers = MAX(params->n_speakers, 1);
+	gdouble slot = params->duration/n_contribs;
+	guint8 *n_times = g_new(guint8, n_contribs);
+	guint timepoint = 0, word = 0;
+	gint section = -1;
+	guint topic = G_MAXUINT;
+
+	fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	      "<!DOCTYPE session SYSTEM \"session.dtd\">\n"
+	      "<session>\n<head/>\n<speakers>\n", file);
+	for (guint i = 0; i < n_speakers; i++) {
+		fprintf(file, "<speaker speaker-id=\"SPK%u\"><name>", i);
+		if (i == 0)
+			fputs("Wizard", file);
+		else if (i == 1)
+			fputs("Proband", file);
+		else
+			fprintf(file, "Speaker %u", i);
+		fputs("</name></speaker>\n", file);
+	}
+	fputs("</speakers>\n<recording/>\n<timeline>\n", file);
+
+	for (guint i = 0; i < n_contribs; i++) {
+		gdouble start = i*slot;
+		gdouble step;
+
+		n_times[i] = MIN(density_count(rand, params->time_density),
+				 G_MAXUINT8);
+		step = slot*(1. - CONTRIB_GAP)/(n_times[i] + 1);
+
+		/* start, time elements and end of contribution */
+		for (guint j = 0; j < n_times[i] + 2u; j++) {
+			fprintf(file, "<timepoint timepoint-id=\"TLI_%u\" "
+				      "absolute-time=\"", timepoint++);
+			write_time(file, start + j*step);
+			fputs("\"/>\n", file);
+		}
+	}
+	fputs("</timeline>\n", file);
+
+	timepoint = 0;
+	for (guint i = 0; i < n_contribs; i++) {
+		guint contrib_topic = (guint)((guint64)i*n_topics/n_contribs);
+		guint n_pauses = density_count(rand, params->pause_density);
+		guint n_elements = n_times[i] + n_pauses;
+		guint n_words = params->words/(n_elements + 1) + 1;
+		guint times = 0;
+
+		if (contrib_topic != topic) {
+			gint topic_section = (gint)((guint64)contrib_topic*SECTIONS/n_topics);
+			const gchar **ids;
+			guint n_ids;
+
+			if (topic != G_MAXUINT)
+				fputs("</topic>\n", file);
+			if (topic_section != section) {
+				section = topic_section;
+				fputs(section_markup[section], file);
+			}
+			topic = contrib_topic;
+
+			ids = section_topics[section];
+			for (n_ids = 0; ids[n_ids] != NULL; n_ids++);
+			fprintf(file, "<topic id=\"%s\">\n", ids[topic % n_ids]);
+		}
+
+		fprintf(file, "<contribution speaker-reference=\"SPK%u\" "
+			      "start-reference=\"TLI_%u\" "
+			      "end-reference=\"TLI_%u\">",
+			g_rand_int_range(rand, 0, n_speakers),
+			timepoint, timepoint + n_times[i] + 1);
+
+		for (guint j = 0; j < n_elements; j++) {
+			word = write_words(file, word, n_words);
+
+			/* choose remaining element type at random */
+			if (times < n_times[i] &&
+			    (guint)g_rand_int_range(rand, 0, n_elements - j) <
+			    n_times[i] - times) {
+				fprintf(file, "<time timepoint-reference=\"TLI_%u\"/>",
+					timepoint + ++times);
+			} else {
+				fprintf(file, "<pause duration=\"%s\"/>",
+					pause_durations[g_rand_int_range(rand, 0,
+									 G_N_ELEMENTS(pause_durations))]);
+			}
+		}
+		word = write_words(file, word, n_words);
+
+		fputs("</contribution>\n", file);
+		timepoint += n_times[i] + 2;
+	}
+	fputs("</topic>\n", file);
+	fputs(section_markup[SECTIONS], file);
+	fputs("</session>\n", file);
+
+	g_free(n_times);
+	g_rand_free(rand);
+}
+
+/**
+ * Write session file into a temporary file
+ *
+ * @param params Session parameters
+ * @return Name of temporary file (must be unlinked and freed) or
+ *         \c NULL on error
+ */
+gchar *
+session_generator_write_tmp(const SessionGeneratorParams *params)
+{
+	gchar *filename;
+	FILE *file;
+	gint fd;
+
+	fd = g_file_open_tmp("session-XXXXXX.xml", &filename, NULL);
+	if (fd < 0)
+		return NULL;
+	file = fdopen(fd, "w");
+	if (file == NULL) {
+		close(fd);
+		g_unlink(filename);
+		g_free(filename);
+		return NULL;
+	}
+
+	session_generator_write(params, file);
+
+	fclose(file);
+	return filename;
+}
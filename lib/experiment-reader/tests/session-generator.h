@@ -0,0 +1,54 @@
+/**
+ * @file
+ * Generator of synthetic session files for tests and benchmarks
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SESSION_GENERATOR_H
+#define __SESSION_GENERATOR_H
+
+#include <stdio.h>
+
+#include <glib.h>
+
+/**
+ * Parameters of a generated session.
+ * Sessions conform to \b session.dtd, so there is at least one topic per
+ * section (i.e. nine topics) and at least one contribution per topic.
+ */
+typedef struct _SessionGeneratorParams {
+	gdouble	duration;	/**< Session duration in seconds */
+	guint	n_speakers;	/**< Number of speakers (the first two are "Wizard" and "Proband") */
+	guint	n_contribs;	/**< Number of contributions */
+	guint	n_topics;	/**< Number of topics, distributed evenly on all sections */
+	gdouble	time_density;	/**< Average number of \b time elements per contribution */
+	gdouble	pause_density;	/**< Average number of \b pause elements per contribution */
+	guint	words;		/**< Average number of words per contribution */
+	guint32	seed;		/**< Random seed, equal parameters generate equal files */
+} SessionGeneratorParams;
+
+void session_generator_params_init(SessionGeneratorParams *params);
+void session_generator_params_scale(SessionGeneratorParams *params,
+				    gdouble factor);
+
+void session_generator_write(const SessionGeneratorParams *params,
+			     FILE *file);
+gchar *session_generator_write_tmp(const SessionGeneratorParams *params);
+
+#endif
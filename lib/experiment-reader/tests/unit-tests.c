@@ -24,16 +24,86 @@
 #include "config.h"
 #endif
 
+#include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
+#include <unistd.h>
+#include <utime.h>
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
 
 #include <experiment-reader.h>
 
+#include "session-generator.h"
+
 #define TEST_EXPERIMENT_VALID	"test-experiment-valid.xml"
 /* #define TEST_EXPERIMENT_INVALID "test-experiment-invalid.xml" */
 
+/** Number of timepoints in generated sessions used by performance tests */
+#define PERF_TIMEPOINTS		100000
+
+/**
+ * Generate a large session file for performance tests.
+ * There are \e timepoints timepoints, each contribution spanning
+ * three of them with one \b time marker. There is one topic per
+ * contribution.
+ *
+ * @param timepoints Number of timepoints to generate
+ * @return Name of temporary file (must be unlinked and freed)
+ */
+static gchar *
+generate_session(gint timepoints)
+{
+	SessionGeneratorParams params;
+	gchar *filename;
+
+	session_generator_params_init(&params);
+	params.duration = timepoints;
+	params.n_contribs = timepoints/3;
+	params.n_topics = params.n_contribs;
+	params.time_density = 1.;
+	params.pause_density = 0.;
+
+	filename = session_generator_write_tmp(&params);
+	g_assert(filename != NULL);
+	return filename;
+}
+
+/**
+ * Write a small session to a temporary file.
+ * Its speakers are "W" (Wizard) and "P" (Proband).
+ *
+ * @param body Timeline and sections of the session
+ * @return Name of temporary file (must be unlinked and freed)
+ */
+static gchar *
+write_session(const gchar *body)
+{
+	gchar *contents, *filename;
+	gint fd;
+
+	contents = g_strconcat("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			       "<session>\n"
+			       "  <head/>\n"
+			       "  <speakers>\n"
+			       "    <speaker speaker-id=\"W\"><name>Wizard</name></speaker>\n"
+			       "    <speaker speaker-id=\"P\"><name>Proband</name></speaker>\n"
+			       "  </speakers>\n",
+			       body,
+			       "</session>\n", NULL);
+
+	fd = g_file_open_tmp("test-session-XXXXXX.xml", &filename, NULL);
+	g_assert(fd >= 0);
+	close(fd);
+	g_assert(g_file_set_contents(filename, contents, -1, NULL));
+
+	g_free(contents);
+	return filename;
+}
+
 static void
 test_new_valid(void)
 {
@@ -45,6 +115,43 @@ test_new_valid(void)
 	g_object_unref(reader);
 }
 
+static void
+test_new_no_timeline(void)
+{
+	static const ExperimentReaderFlags flags[] = {
+		0, EXPERIMENT_READER_FLAG_STREAMING
+	};
+	gchar *filename;
+
+	/* timepoint references cannot be resolved without a timeline */
+	filename = write_session(
+		"  <greeting>\n"
+		"    <topic id=\"g_1\">\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T0\" end-reference=\"T1\">a</contribution>\n"
+		"    </topic>\n"
+		"  </greeting>\n");
+
+	for (gint i = 0; i < G_N_ELEMENTS(flags); i++) {
+		ExperimentReader *reader;
+		const ExperimentReaderStructure *structure;
+		const ExperimentReaderSectionInfo *info;
+
+		reader = experiment_reader_new_with_flags(filename, flags[i]);
+		g_assert(reader != NULL);
+		structure = experiment_reader_get_structure(reader);
+
+		info = structure->sections + EXPERIMENT_READER_SECTION_GREETING;
+		g_assert_cmpuint(info->n_topics, ==, 1);
+		g_assert_cmpint(info->topics[0].start_time, ==, -1);
+		g_assert_cmpint(info->topics[0].end_time, ==, -1);
+
+		g_object_unref(reader);
+	}
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
 static void
 test_foreach_greeting_topic_values_cb(ExperimentReader *reader,
 				      const gchar *topic_id,
@@ -86,19 +193,994 @@ test_foreach_greeting_topic_values(void)
 	g_object_unref(reader);
 }
 
+static void
+test_structure_topic_cb(ExperimentReaderSection section,
+			const ExperimentReaderTopic *topic, gpointer data)
+{
+	const ExperimentReaderStructure *structure = data;
+
+	g_assert(topic == structure->sections[section].topics);
+	g_assert_cmpstr(topic->id, ==, "v_1");
+}
+
+static void
+test_structure_reader(ExperimentReader *reader)
+{
+	const ExperimentReaderStructure *structure;
+	const ExperimentReaderSectionInfo *info;
+
+	structure = experiment_reader_get_structure(reader);
+	g_assert(structure != NULL);
+	g_assert(experiment_reader_get_structure(reader) == structure);
+
+	info = structure->sections + EXPERIMENT_READER_SECTION_GREETING;
+	g_assert_cmpuint(info->n_topics, ==, 1);
+	g_assert_cmpstr(info->topics[0].id, ==, "bz_2");
+	g_assert_cmpint(info->topics[0].start_time, ==, 13648);
+	g_assert_cmpint(info->topics[0].end_time, ==, 36908);
+	g_assert_cmpint(info->start_time, ==, 13648);
+	g_assert_cmpint(info->end_time, ==, 36908);
+
+	info = structure->sections + EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE;
+	g_assert_cmpuint(info->n_topics, ==, 1);
+	g_assert_cmpint(info->start_time, ==, 36908);
+	g_assert_cmpint(info->end_time, ==, 57868);
+
+	/* empty phases collapse to the end of the preceding section */
+	for (gint i = 0; i < 6; i++) {
+		info = structure->sections +
+		       EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + i;
+		g_assert_cmpuint(info->n_topics, ==, 0);
+		g_assert_cmpint(info->start_time, ==, 57868);
+		g_assert_cmpint(info->end_time, ==, 57868);
+	}
+
+	info = structure->sections + EXPERIMENT_READER_SECTION_FAREWELL;
+	g_assert_cmpuint(info->n_topics, ==, 1);
+	g_assert_cmpint(info->start_time, ==, 1444968);
+	g_assert_cmpint(info->end_time, ==, 1454975);
+
+	experiment_reader_structure_foreach_topic(structure,
+						  EXPERIMENT_READER_SECTION_FAREWELL,
+						  test_structure_topic_cb,
+						  (gpointer)structure);
+}
+
+static void
+test_structure_values(void)
+{
+	ExperimentReader *reader;
+
+	reader = experiment_reader_new(TEST_EXPERIMENT_VALID);
+	g_assert(reader != NULL);
+	test_structure_reader(reader);
+	g_object_unref(reader);
+
+	reader = experiment_reader_new_with_flags(TEST_EXPERIMENT_VALID,
+						  EXPERIMENT_READER_FLAG_STREAMING);
+	g_assert(reader != NULL);
+	test_structure_reader(reader);
+	g_object_unref(reader);
+}
+
+static void
+test_structure_empty_topics(void)
+{
+	static const ExperimentReaderFlags flags[] = {
+		0, EXPERIMENT_READER_FLAG_STREAMING
+	};
+	gchar *filename;
+
+	/*
+	 * greeting: g_2 is nested in g_1, g_3 has no contributions
+	 * initial narrative: only i_2 has contributions
+	 * farewell: no contributions at all
+	 */
+	filename = write_session(
+		"  <timeline>\n"
+		"    <timepoint timepoint-id=\"T0\" absolute-time=\"1\"/>\n"
+		"    <timepoint timepoint-id=\"T1\" absolute-time=\"2\"/>\n"
+		"    <timepoint timepoint-id=\"T2\" absolute-time=\"3\"/>\n"
+		"    <timepoint timepoint-id=\"T3\" absolute-time=\"4\"/>\n"
+		"    <timepoint timepoint-id=\"T4\" absolute-time=\"5\"/>\n"
+		"  </timeline>\n"
+		"  <greeting>\n"
+		"    <topic id=\"g_1\">\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T0\" end-reference=\"T3\">a</contribution>\n"
+		"    </topic>\n"
+		"    <topic id=\"g_2\">\n"
+		"      <contribution speaker-reference=\"P\" start-reference=\"T1\" end-reference=\"T2\">b</contribution>\n"
+		"    </topic>\n"
+		"    <topic id=\"g_3\"/>\n"
+		"  </greeting>\n"
+		"  <experiment>\n"
+		"    <initial-narrative>\n"
+		"      <topic id=\"i_1\"/>\n"
+		"      <topic id=\"i_2\">\n"
+		"        <contribution speaker-reference=\"W\" start-reference=\"T3\" end-reference=\"T4\">c</contribution>\n"
+		"      </topic>\n"
+		"      <topic id=\"i_3\"/>\n"
+		"    </initial-narrative>\n"
+		"  </experiment>\n"
+		"  <farewell>\n"
+		"    <topic id=\"f_1\"/>\n"
+		"  </farewell>\n");
+
+	for (gint i = 0; i < G_N_ELEMENTS(flags); i++) {
+		ExperimentReader *reader;
+		const ExperimentReaderStructure *structure;
+		const ExperimentReaderSectionInfo *info;
+
+		reader = experiment_reader_new_with_flags(filename, flags[i]);
+		g_assert(reader != NULL);
+		structure = experiment_reader_get_structure(reader);
+
+		info = structure->sections + EXPERIMENT_READER_SECTION_GREETING;
+		g_assert_cmpuint(info->n_topics, ==, 3);
+		g_assert_cmpint(info->topics[2].start_time, ==, -1);
+		g_assert_cmpint(info->topics[2].end_time, ==, -1);
+		g_assert_cmpint(info->start_time, ==, 1000);
+		g_assert_cmpint(info->end_time, ==, 4000);
+
+		info = structure->sections + EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE;
+		g_assert_cmpuint(info->n_topics, ==, 3);
+		g_assert_cmpint(info->start_time, ==, 4000);
+		g_assert_cmpint(info->end_time, ==, 5000);
+
+		for (gint j = 0; j < 6; j++) {
+			info = structure->sections +
+			       EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + j;
+			g_assert_cmpint(info->start_time, ==, 5000);
+			g_assert_cmpint(info->end_time, ==, 5000);
+		}
+
+		info = structure->sections + EXPERIMENT_READER_SECTION_FAREWELL;
+		g_assert_cmpuint(info->n_topics, ==, 1);
+		g_assert_cmpint(info->start_time, ==, 5000);
+		g_assert_cmpint(info->end_time, ==, 5000);
+
+		g_assert_cmpint(experiment_reader_structure_lookup_section(structure,
+									   4500),
+				==, EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE);
+
+		g_object_unref(reader);
+	}
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_contrib_table_speaker(ExperimentReader *reader, const gchar *speaker)
+{
+	GList *contribs, *cur;
+	ExperimentReaderContribTable *table;
+	guint i = 0;
+
+	contribs = experiment_reader_get_contributions_by_speaker(reader,
+								  speaker);
+	table = experiment_reader_get_contrib_table_by_speaker(reader, speaker);
+	g_assert(table != NULL);
+	g_assert_cmpuint(table->n_contribs, ==, g_list_length(contribs));
+
+	for (cur = contribs; cur != NULL; cur = cur->next, i++) {
+		ExperimentReaderContrib *contrib =
+				(ExperimentReaderContrib *)cur->data;
+		GList *found;
+
+		g_assert_cmpint(experiment_reader_contrib_table_get_start_time(table, i),
+				==, contrib->start_time);
+		g_assert_cmpstr(experiment_reader_contrib_table_get_text(table, i),
+				==, contrib->text);
+
+		found = experiment_reader_get_contribution_by_time(contribs,
+								   contrib->start_time);
+		g_assert_cmpint(experiment_reader_contrib_table_lookup(table,
+								       contrib->start_time),
+				==, g_list_position(contribs, found));
+	}
+
+	if (contribs != NULL) {
+		g_assert_cmpint(experiment_reader_contrib_table_lookup(table, -1),
+				==, 0);
+
+		/* the list belongs to the caller and may be modified */
+		g_free(contribs->data);
+		contribs = g_list_delete_link(contribs, contribs);
+	}
+
+	experiment_reader_contrib_table_unref(table);
+	experiment_reader_free_contributions(contribs);
+}
+
+static void
+test_contrib_table_values(void)
+{
+	ExperimentReader *reader;
+
+	reader = experiment_reader_new(TEST_EXPERIMENT_VALID);
+	g_assert(reader != NULL);
+
+	test_contrib_table_speaker(reader, "Wizard");
+	test_contrib_table_speaker(reader, "Proband");
+
+	g_object_unref(reader);
+}
+
+static void
+test_contrib_tables_reader(ExperimentReader *reader)
+{
+	static const gchar *speakers[] = {"Wizard", "Proband"};
+	GHashTable *tables;
+
+	tables = experiment_reader_get_contrib_tables(reader);
+	g_assert(tables != NULL);
+	g_assert_cmpuint(g_hash_table_size(tables), ==, G_N_ELEMENTS(speakers));
+
+	for (gint i = 0; i < G_N_ELEMENTS(speakers); i++) {
+		ExperimentReaderContribTable *table, *expected;
+
+		table = g_hash_table_lookup(tables,
+					    GUINT_TO_POINTER(g_quark_from_string(speakers[i])));
+		g_assert(table != NULL);
+		expected = experiment_reader_get_contrib_table_by_speaker(reader,
+									  speakers[i]);
+
+		g_assert_cmpuint(table->n_contribs, ==, expected->n_contribs);
+		for (guint j = 0; j < table->n_contribs; j++) {
+			g_assert_cmpint(experiment_reader_contrib_table_get_start_time(table, j),
+					==,
+					experiment_reader_contrib_table_get_start_time(expected, j));
+			g_assert_cmpstr(experiment_reader_contrib_table_get_text(table, j),
+					==,
+					experiment_reader_contrib_table_get_text(expected, j));
+		}
+
+		experiment_reader_contrib_table_unref(expected);
+	}
+
+	g_hash_table_unref(tables);
+}
+
+static void
+test_contrib_tables_values(void)
+{
+	ExperimentReader *reader;
+
+	reader = experiment_reader_new(TEST_EXPERIMENT_VALID);
+	g_assert(reader != NULL);
+	test_contrib_tables_reader(reader);
+	g_object_unref(reader);
+
+	reader = experiment_reader_new_with_flags(TEST_EXPERIMENT_VALID,
+						  EXPERIMENT_READER_FLAG_STREAMING);
+	g_assert(reader != NULL);
+	test_contrib_tables_reader(reader);
+	g_object_unref(reader);
+}
+
+/**
+ * Write session without contributions, e.g. a session that has not
+ * been transcribed yet.
+ *
+ * @return Name of temporary file (must be unlinked and freed)
+ */
+static gchar *
+write_empty_session(void)
+{
+	return write_session("  <timeline/>\n"
+			     "  <greeting/>\n");
+}
+
+static void
+test_contrib_tables_empty(void)
+{
+	static const ExperimentReaderFlags flags[] = {
+		0, EXPERIMENT_READER_FLAG_STREAMING
+	};
+	gchar *filename = write_empty_session();
+
+	for (gint i = 0; i < G_N_ELEMENTS(flags); i++) {
+		ExperimentReader *reader;
+		GHashTable *tables;
+		ExperimentReaderContribTable *table;
+		GHashTableIter iter;
+
+		reader = experiment_reader_new_with_flags(filename, flags[i]);
+		g_assert(reader != NULL);
+
+		tables = experiment_reader_get_contrib_tables(reader);
+		g_assert(tables != NULL);
+		g_hash_table_iter_init(&iter, tables);
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&table))
+			g_assert_cmpuint(table->n_contribs, ==, 0);
+		g_hash_table_unref(tables);
+
+		table = experiment_reader_get_contrib_table_by_speaker(reader,
+								       "Wizard");
+		g_assert(table != NULL);
+		g_assert_cmpuint(table->n_contribs, ==, 0);
+		experiment_reader_contrib_table_unref(table);
+
+		g_object_unref(reader);
+	}
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_interval_speaker(ExperimentReader *reader, const gchar *speaker)
+{
+	ExperimentReaderContribTable *table;
+	guint first, last;
+
+	table = experiment_reader_get_contrib_table_by_speaker(reader, speaker);
+	g_assert(table != NULL);
+	g_assert_cmpuint(table->n_contribs, >, 0);
+
+	for (guint i = 0; i < table->n_contribs; i++) {
+		gint64 start = experiment_reader_contrib_table_get_start_time(table, i);
+		gint64 end = experiment_reader_contrib_table_get_end_time(table, i);
+		gint64 mid = start + (end - start)/2;
+		gint active;
+
+		g_assert_cmpint(end, >=, start);
+
+		/* contributions of one speaker only share boundaries */
+		active = experiment_reader_contrib_table_lookup_active(table, mid);
+		g_assert_cmpint(active, >=, 0);
+		g_assert_cmpint(experiment_reader_contrib_table_get_start_time(table, active),
+				<=, mid);
+		g_assert_cmpint(experiment_reader_contrib_table_get_end_time(table, active),
+				>=, mid);
+
+		g_assert(experiment_reader_contrib_table_lookup_range(table,
+								      mid, mid,
+								      &first, &last));
+		g_assert_cmpuint(first, <=, (guint)active);
+		g_assert_cmpuint(last, >=, (guint)active);
+	}
+
+	g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, -1),
+			==, -1);
+	g_assert(!experiment_reader_contrib_table_lookup_range(table,
+							       G_MAXINT64 - 1,
+							       G_MAXINT64,
+							       &first, &last));
+
+	g_assert(experiment_reader_contrib_table_lookup_range(table,
+							      0, G_MAXINT64,
+							      &first, &last));
+	g_assert_cmpuint(first, ==, 0);
+	g_assert_cmpuint(last, ==, table->n_contribs - 1);
+
+	experiment_reader_contrib_table_unref(table);
+}
+
+static void
+test_interval_topic_cb(ExperimentReaderSection section,
+		       const ExperimentReaderTopic *topic, gpointer data)
+{
+	GString *str = (GString *)data;
+
+	g_string_append_printf(str, "%d:%s;", section, topic->id);
+}
+
+static void
+test_interval_reader(ExperimentReader *reader)
+{
+	const ExperimentReaderStructure *structure;
+	const ExperimentReaderTopic *topic;
+	ExperimentReaderSection section;
+	GString *str;
+
+	test_interval_speaker(reader, "Wizard");
+	test_interval_speaker(reader, "Proband");
+
+	structure = experiment_reader_get_structure(reader);
+	g_assert(structure != NULL);
+
+	topic = experiment_reader_structure_lookup_topic(structure, 20000,
+							 &section);
+	g_assert(topic != NULL);
+	g_assert_cmpstr(topic->id, ==, "bz_2");
+	g_assert_cmpint(section, ==, EXPERIMENT_READER_SECTION_GREETING);
+
+	/* shared boundary belongs to the later topic */
+	topic = experiment_reader_structure_lookup_topic(structure, 36908,
+							 &section);
+	g_assert(topic != NULL);
+	g_assert_cmpint(section, ==, EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE);
+
+	topic = experiment_reader_structure_lookup_topic(structure, 1450000,
+							 NULL);
+	g_assert(topic != NULL);
+	g_assert_cmpstr(topic->id, ==, "v_1");
+
+	g_assert(experiment_reader_structure_lookup_topic(structure, 1000000,
+							  NULL) == NULL);
+	g_assert(experiment_reader_structure_lookup_topic(structure, 0,
+							  NULL) == NULL);
+
+	g_assert_cmpint(experiment_reader_structure_lookup_section(structure,
+								   20000),
+			==, EXPERIMENT_READER_SECTION_GREETING);
+	g_assert_cmpint(experiment_reader_structure_lookup_section(structure,
+								   1000000),
+			==, -1);
+	g_assert_cmpint(experiment_reader_structure_lookup_section(structure,
+								   1454975),
+			==, EXPERIMENT_READER_SECTION_FAREWELL);
+
+	str = g_string_new(NULL);
+	experiment_reader_structure_foreach_topic_in_range(structure,
+							   30000, 1445000,
+							   test_interval_topic_cb,
+							   str);
+	g_assert_cmpstr(str->str, ==, "0:bz_2;1:i_1;8:v_1;");
+	g_string_truncate(str, 0);
+	experiment_reader_structure_foreach_topic_in_range(structure,
+							   60000, 1000000,
+							   test_interval_topic_cb,
+							   str);
+	g_assert_cmpstr(str->str, ==, "");
+	g_string_free(str, TRUE);
+}
+
+static void
+test_interval_values(void)
+{
+	ExperimentReader *reader;
+
+	reader = experiment_reader_new(TEST_EXPERIMENT_VALID);
+	g_assert(reader != NULL);
+	test_interval_reader(reader);
+	g_object_unref(reader);
+
+	reader = experiment_reader_new_with_flags(TEST_EXPERIMENT_VALID,
+						  EXPERIMENT_READER_FLAG_STREAMING);
+	g_assert(reader != NULL);
+	test_interval_reader(reader);
+	g_object_unref(reader);
+}
+
+static void
+test_interval_overlapping(void)
+{
+	/* loaded from the cache the second time */
+	static const ExperimentReaderFlags flags[] = {
+		0, EXPERIMENT_READER_FLAG_STREAMING,
+		EXPERIMENT_READER_FLAG_CACHE, EXPERIMENT_READER_FLAG_CACHE
+	};
+	gchar *filename;
+
+	/*
+	 * 0: [1000, 10000] contains all but the last one
+	 * 1: [2000, 4000] overlaps 2
+	 * 2: [3000, 6000]
+	 * 3: [7000, 8000]
+	 * 4: [9000, 10000] shares its end with 0
+	 * 5: [11000, 12000]
+	 */
+	filename = write_session(
+		"  <timeline>\n"
+		"    <timepoint timepoint-id=\"T0\" absolute-time=\"1\"/>\n"
+		"    <timepoint timepoint-id=\"T1\" absolute-time=\"2\"/>\n"
+		"    <timepoint timepoint-id=\"T2\" absolute-time=\"3\"/>\n"
+		"    <timepoint timepoint-id=\"T3\" absolute-time=\"4\"/>\n"
+		"    <timepoint timepoint-id=\"T5\" absolute-time=\"6\"/>\n"
+		"    <timepoint timepoint-id=\"T6\" absolute-time=\"7\"/>\n"
+		"    <timepoint timepoint-id=\"T7\" absolute-time=\"8\"/>\n"
+		"    <timepoint timepoint-id=\"T8\" absolute-time=\"9\"/>\n"
+		"    <timepoint timepoint-id=\"T9\" absolute-time=\"10\"/>\n"
+		"    <timepoint timepoint-id=\"T10\" absolute-time=\"11\"/>\n"
+		"    <timepoint timepoint-id=\"T11\" absolute-time=\"12\"/>\n"
+		"  </timeline>\n"
+		"  <greeting>\n"
+		"    <topic id=\"g_1\">\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T0\" end-reference=\"T9\">a</contribution>\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T2\" end-reference=\"T5\">c</contribution>\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T1\" end-reference=\"T3\">b</contribution>\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T8\" end-reference=\"T9\">e</contribution>\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T6\" end-reference=\"T7\">d</contribution>\n"
+		"      <contribution speaker-reference=\"W\" start-reference=\"T10\" end-reference=\"T11\">f</contribution>\n"
+		"    </topic>\n"
+		"  </greeting>\n");
+
+	for (gint i = 0; i < G_N_ELEMENTS(flags); i++) {
+		ExperimentReader *reader;
+		ExperimentReaderContribTable *table;
+		guint first, last;
+
+		reader = experiment_reader_new_with_flags(filename, flags[i]);
+		g_assert(reader != NULL);
+		table = experiment_reader_get_contrib_table_by_speaker(reader,
+								       "Wizard");
+		g_assert(table != NULL);
+		g_assert_cmpuint(table->n_contribs, ==, 6);
+		g_assert_cmpstr(experiment_reader_contrib_table_get_text(table, 1),
+				==, "b");
+
+		g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, 2500),
+				==, 1);
+		g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, 5000),
+				==, 2);
+		/* only the enclosing contribution is left */
+		g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, 6500),
+				==, 0);
+		g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, 10000),
+				==, 4);
+		g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, 10500),
+				==, -1);
+		g_assert_cmpint(experiment_reader_contrib_table_lookup(table, 6500),
+				==, 3);
+
+		/* compare with linear scans */
+		for (gint64 t = 0; t <= 13000; t += 250) {
+			gint active = -1;
+
+			for (guint j = 0; j < table->n_contribs; j++)
+				if (table->start_times[j] <= t &&
+				    t <= table->end_times[j])
+					active = j;
+			g_assert_cmpint(experiment_reader_contrib_table_lookup_active(table, t),
+					==, active);
+
+			for (gint64 end = t; end <= 13000; end += 1000) {
+				gint low = -1, high = -1;
+
+				for (guint j = 0; j < table->n_contribs; j++) {
+					if (low < 0 && table->end_times[j] >= t)
+						low = j;
+					if (table->start_times[j] <= end)
+						high = j;
+				}
+
+				if (low < 0 || high < low) {
+					g_assert(!experiment_reader_contrib_table_lookup_range(table,
+											      t, end,
+											      &first, &last));
+					continue;
+				}
+				g_assert(experiment_reader_contrib_table_lookup_range(table,
+										      t, end,
+										      &first, &last));
+				g_assert_cmpuint(first, ==, (guint)low);
+				g_assert_cmpuint(last, ==, (guint)high);
+			}
+		}
+
+		experiment_reader_contrib_table_unref(table);
+		g_object_unref(reader);
+	}
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_streaming_topic_cb(ExperimentReader *reader __attribute__((unused)),
+			const gchar *topic_id, gint64 start_time,
+			gint64 end_time, gpointer data)
+{
+	GString *str = (GString *)data;
+
+	g_string_append_printf(str, "%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ";",
+			       topic_id, start_time, end_time);
+}
+
+static gchar *
+test_streaming_dump_topics(ExperimentReader *reader)
+{
+	GString *str = g_string_new(NULL);
+
+	experiment_reader_foreach_greeting_topic(reader,
+						 test_streaming_topic_cb, str);
+	experiment_reader_foreach_exp_initial_narrative_topic(reader,
+							      test_streaming_topic_cb,
+							      str);
+	for (gint i = 1; i <= 6; i++)
+		experiment_reader_foreach_exp_last_minute_phase_topic(reader, i,
+								      test_streaming_topic_cb,
+								      str);
+	experiment_reader_foreach_farewell_topic(reader,
+						 test_streaming_topic_cb, str);
+
+	return g_string_free(str, FALSE);
+}
+
+static void
+test_streaming_compare_speaker(ExperimentReader *dom,
+			       ExperimentReader *stream, const gchar *speaker)
+{
+	ExperimentReaderContribTable *dom_table, *stream_table;
+
+	dom_table = experiment_reader_get_contrib_table_by_speaker(dom,
+								   speaker);
+	stream_table = experiment_reader_get_contrib_table_by_speaker(stream,
+								      speaker);
+
+	g_assert_cmpuint(stream_table->n_contribs, ==, dom_table->n_contribs);
+	for (guint i = 0; i < dom_table->n_contribs; i++) {
+		g_assert_cmpint(experiment_reader_contrib_table_get_start_time(stream_table, i),
+				==,
+				experiment_reader_contrib_table_get_start_time(dom_table, i));
+		g_assert_cmpint(experiment_reader_contrib_table_get_end_time(stream_table, i),
+				==,
+				experiment_reader_contrib_table_get_end_time(dom_table, i));
+		/* the first element of the tree is unused */
+		if (i > 0)
+			g_assert_cmpint(stream_table->max_end_tree[i], ==,
+					dom_table->max_end_tree[i]);
+		g_assert_cmpstr(experiment_reader_contrib_table_get_text(stream_table, i),
+				==,
+				experiment_reader_contrib_table_get_text(dom_table, i));
+	}
+
+	experiment_reader_contrib_table_unref(stream_table);
+	experiment_reader_contrib_table_unref(dom_table);
+}
+
+static void
+test_streaming_compare(const gchar *filename, ExperimentReaderFlags flags)
+{
+	ExperimentReader *dom, *stream;
+	gchar *dom_topics, *stream_topics;
+
+	dom = experiment_reader_new(filename);
+	g_assert(dom != NULL);
+	stream = experiment_reader_new_with_flags(filename, flags);
+	g_assert(stream != NULL);
+
+	dom_topics = test_streaming_dump_topics(dom);
+	stream_topics = test_streaming_dump_topics(stream);
+	g_assert_cmpstr(stream_topics, ==, dom_topics);
+	g_free(stream_topics);
+	g_free(dom_topics);
+
+	test_streaming_compare_speaker(dom, stream, "Wizard");
+	test_streaming_compare_speaker(dom, stream, "Proband");
+	test_streaming_compare_speaker(dom, stream, "Nobody");
+
+	g_object_unref(stream);
+	g_object_unref(dom);
+}
+
+static void
+test_streaming_values(void)
+{
+	gchar *filename;
+
+	test_streaming_compare(TEST_EXPERIMENT_VALID,
+			       EXPERIMENT_READER_FLAG_STREAMING);
+
+	filename = generate_session(300);
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_STREAMING);
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_cache_values(void)
+{
+	gchar *filename, *contents, *p;
+	gsize length;
+	struct stat buf;
+	struct utimbuf times;
+
+	filename = generate_session(300);
+
+	/* first instance writes cache file, second one maps it */
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_CACHE);
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_CACHE);
+
+	/*
+	 * Touch file without changing its contents, so the cache file
+	 * is still valid according to its digest (and rewritten)
+	 */
+	g_assert(!g_stat(filename, &buf));
+	times.actime = buf.st_atime;
+	times.modtime = buf.st_mtime + 1;
+	g_assert(!g_utime(filename, &times));
+
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_CACHE);
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_CACHE);
+
+	/*
+	 * Modify file without changing its size, so the cache file
+	 * can only be invalidated by its digest
+	 */
+	g_assert(g_file_get_contents(filename, &contents, &length, NULL));
+	p = strstr(contents, "Lorem");
+	g_assert(p != NULL);
+	p[1] = 'a';
+	g_assert(g_file_set_contents(filename, contents, length, NULL));
+	g_free(contents);
+	times.modtime = buf.st_mtime + 2;
+	g_assert(!g_utime(filename, &times));
+
+	test_streaming_compare(filename, EXPERIMENT_READER_FLAG_CACHE);
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_new_async_ready_cb(GObject *source __attribute__((unused)),
+			GAsyncResult *result, gpointer user_data)
+{
+	GAsyncResult **ret = user_data;
+
+	*ret = G_ASYNC_RESULT(g_object_ref(result));
+}
+
+static ExperimentReader *
+test_new_async_run(const gchar *filename, ExperimentReaderFlags flags,
+		   GCancellable *cancellable, GError **error)
+{
+	GAsyncResult *result = NULL;
+	ExperimentReader *reader;
+
+	experiment_reader_new_async(filename, flags, cancellable,
+				    test_new_async_ready_cb, &result);
+	while (result == NULL)
+		g_main_context_iteration(NULL, TRUE);
+
+	reader = experiment_reader_new_finish(result, error);
+	g_object_unref(result);
+
+	return reader;
+}
+
+static void
+test_new_async_values(void)
+{
+	ExperimentReader *dom, *async;
+	gchar *dom_topics, *async_topics;
+	GError *error = NULL;
+
+	dom = experiment_reader_new(TEST_EXPERIMENT_VALID);
+	g_assert(dom != NULL);
+	async = test_new_async_run(TEST_EXPERIMENT_VALID,
+				   EXPERIMENT_READER_FLAG_STREAMING,
+				   NULL, &error);
+	g_assert_no_error(error);
+	g_assert(async != NULL);
+
+	dom_topics = test_streaming_dump_topics(dom);
+	async_topics = test_streaming_dump_topics(async);
+	g_assert_cmpstr(async_topics, ==, dom_topics);
+	g_free(async_topics);
+	g_free(dom_topics);
+
+	test_streaming_compare_speaker(dom, async, "Wizard");
+	test_streaming_compare_speaker(dom, async, "Proband");
+
+	g_object_unref(async);
+	g_object_unref(dom);
+
+	async = test_new_async_run("does-not-exist.xml", 0, NULL, &error);
+	g_assert(async == NULL);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_FAILED);
+	g_clear_error(&error);
+}
+
+static void
+test_new_async_cancel(void)
+{
+	GCancellable *cancellable = g_cancellable_new();
+	ExperimentReader *reader;
+	GError *error = NULL;
+
+	g_cancellable_cancel(cancellable);
+	reader = test_new_async_run(TEST_EXPERIMENT_VALID,
+				    EXPERIMENT_READER_FLAG_STREAMING,
+				    cancellable, &error);
+	g_assert(reader == NULL);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error(&error);
+
+	g_object_unref(cancellable);
+}
+
+static void
+test_perf_topic_cb(ExperimentReader *reader __attribute__((unused)),
+		   const gchar *topic_id __attribute__((unused)),
+		   gint64 start_time, gint64 end_time,
+		   gpointer data)
+{
+	g_assert_cmpint(start_time, >=, 0);
+	g_assert_cmpint(end_time, >=, start_time);
+
+	++*(gint *)data;
+}
+
+static void
+test_perf_new_timeline(void)
+{
+	ExperimentReader *reader;
+	gchar *filename = generate_session(PERF_TIMEPOINTS);
+	gint topics = 0;
+	gdouble elapsed;
+
+	g_test_timer_start();
+	reader = experiment_reader_new(filename);
+	elapsed = g_test_timer_elapsed();
+	g_assert(reader != NULL);
+	g_test_minimized_result(elapsed,
+				"experiment_reader_new(): %d timepoints in %gs",
+				PERF_TIMEPOINTS, elapsed);
+
+	g_test_timer_start();
+	experiment_reader_foreach_greeting_topic(reader, test_perf_topic_cb,
+						 &topics);
+	experiment_reader_foreach_exp_initial_narrative_topic(reader,
+							      test_perf_topic_cb,
+							      &topics);
+	for (gint i = 1; i <= 6; i++)
+		experiment_reader_foreach_exp_last_minute_phase_topic(reader, i,
+								      test_perf_topic_cb,
+								      &topics);
+	experiment_reader_foreach_farewell_topic(reader, test_perf_topic_cb,
+						 &topics);
+	elapsed = g_test_timer_elapsed();
+	g_test_minimized_result(elapsed, "Enumerating %d topics in %gs",
+				topics, elapsed);
+	g_assert_cmpint(topics, ==, PERF_TIMEPOINTS/3);
+
+	g_object_unref(reader);
+	g_unlink(filename);
+	g_free(filename);
+}
+
+static void
+test_perf_new_with_flags(void)
+{
+	ExperimentReader *reader;
+	gchar *filename = generate_session(PERF_TIMEPOINTS);
+	ExperimentReaderContribTable *table;
+	gdouble elapsed;
+
+	g_test_timer_start();
+	reader = experiment_reader_new(filename);
+	g_assert(reader != NULL);
+	table = experiment_reader_get_contrib_table_by_speaker(reader,
+								"Wizard");
+	elapsed = g_test_timer_elapsed();
+	g_test_minimized_result(elapsed,
+				"DOM: %d timepoints, %u contributions in %gs",
+				PERF_TIMEPOINTS, table->n_contribs, elapsed);
+	experiment_reader_contrib_table_unref(table);
+	g_object_unref(reader);
+
+	g_test_timer_start();
+	reader = experiment_reader_new_with_flags(filename,
+						  EXPERIMENT_READER_FLAG_STREAMING);
+	g_assert(reader != NULL);
+	table = experiment_reader_get_contrib_table_by_speaker(reader,
+								"Wizard");
+	elapsed = g_test_timer_elapsed();
+	g_test_minimized_result(elapsed,
+				"Streaming: %d timepoints, %u contributions in %gs",
+				PERF_TIMEPOINTS, table->n_contribs, elapsed);
+	experiment_reader_contrib_table_unref(table);
+	g_object_unref(reader);
+
+	/* write cache file */
+	reader = experiment_reader_new_with_flags(filename,
+						  EXPERIMENT_READER_FLAG_CACHE);
+	g_assert(reader != NULL);
+	g_object_unref(reader);
+
+	g_test_timer_start();
+	reader = experiment_reader_new_with_flags(filename,
+						  EXPERIMENT_READER_FLAG_CACHE);
+	g_assert(reader != NULL);
+	table = experiment_reader_get_contrib_table_by_speaker(reader,
+								"Wizard");
+	elapsed = g_test_timer_elapsed();
+	g_test_minimized_result(elapsed,
+				"Cache: %d timepoints, %u contributions in %gs",
+				PERF_TIMEPOINTS, table->n_contribs, elapsed);
+	experiment_reader_contrib_table_unref(table);
+	g_object_unref(reader);
+
+	g_unlink(filename);
+	g_free(filename);
+}
+
+/**
+ * Remove a directory including its contents, e.g. the cache directory
+ * used by the tests.
+ *
+ * @param dirname Name of directory to remove
+ */
+static void
+remove_dir(const gchar *dirname)
+{
+	GDir *dir;
+	const gchar *name;
+
+	dir = g_dir_open(dirname, 0, NULL);
+	if (dir == NULL)
+		return;
+
+	while ((name = g_dir_read_name(dir)) != NULL) {
+		gchar *path = g_build_filename(dirname, name, NULL);
+
+		if (g_file_test(path, G_FILE_TEST_IS_DIR))
+			remove_dir(path);
+		else
+			g_unlink(path);
+		g_free(path);
+	}
+	g_dir_close(dir);
+
+	g_rmdir(dirname);
+}
+
 /** @private */
 int
 main(int argc, char **argv)
 {
+	gchar *cache_dir;
+	gint ret;
+
+	g_thread_init(NULL);
 	g_type_init();
 	g_test_init(&argc, &argv, NULL);
 
+	/* don't pollute the user's cache directory */
+	cache_dir = g_dir_make_tmp("experiment-reader-tests-XXXXXX", NULL);
+	g_assert(cache_dir != NULL);
+	g_setenv("XDG_CACHE_HOME", cache_dir, TRUE);
+
 	g_test_add_func("/api/new/test_valid", test_new_valid);
+	g_test_add_func("/api/new/test_no_timeline", test_new_no_timeline);
 
 	g_test_add_func("/api/foreach_greeting_topic/test_values",
 			test_foreach_greeting_topic_values);
 
-	g_test_run_suite(g_test_get_root());
+	g_test_add_func("/api/structure/test_values",
+			test_structure_values);
+	g_test_add_func("/api/structure/test_empty_topics",
+			test_structure_empty_topics);
+
+	g_test_add_func("/api/contrib_table/test_values",
+			test_contrib_table_values);
+
+	g_test_add_func("/api/contrib_tables/test_values",
+			test_contrib_tables_values);
+	g_test_add_func("/api/contrib_tables/test_empty",
+			test_contrib_tables_empty);
+
+	g_test_add_func("/api/interval/test_values",
+			test_interval_values);
+	g_test_add_func("/api/interval/test_overlapping",
+			test_interval_overlapping);
+
+	g_test_add_func("/api/new_with_flags/test_streaming",
+			test_streaming_values);
+	g_test_add_func("/api/new_with_flags/test_cache",
+			test_cache_values);
+
+	g_test_add_func("/api/new_async/test_values",
+			test_new_async_values);
+	g_test_add_func("/api/new_async/test_cancel",
+			test_new_async_cancel);
+
+	if (g_test_perf()) {
+		g_test_add_func("/perf/new/timeline",
+				test_perf_new_timeline);
+		g_test_add_func("/perf/new_with_flags",
+				test_perf_new_with_flags);
+	}
+
+	ret = g_test_run_suite(g_test_get_root());
+
+	remove_dir(cache_dir);
+	g_free(cache_dir);
 
-	return 0;
+	return ret;
 }
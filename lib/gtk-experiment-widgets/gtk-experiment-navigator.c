@@ -29,6 +29,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
 
 #include <gtk/gtk.h>
 #include <experiment-reader.h>
@@ -57,11 +58,15 @@ static inline void select_time(GtkExperimentNavigator *navi,
 static inline void activate_section(GtkExperimentNavigator *navi,
 				    gint64 start, gint64 end);
 
-static void topic_row_callback(ExperimentReader *reader,
-			const gchar *topic_id,
-			gint64 start_time,
-			gint64 end_time,
-			gpointer data);
+static void topic_row_callback(ExperimentReaderSection section,
+			       const ExperimentReaderTopic *topic,
+			       gpointer data);
+static void append_section_row(GtkTreeStore *store, GtkTreeIter *parent,
+			       const gchar *name,
+			       const ExperimentReaderStructure *structure,
+			       ExperimentReaderSection section);
+static void load_filename_ready_cb(GObject *source, GAsyncResult *result,
+				   gpointer user_data);
 
 /**
  * @private
@@ -90,20 +95,12 @@ static void topic_row_callback(ExperimentReader *reader,
  * You can access these attributes using \c klass->priv->attribute.
  */
 struct _GtkExperimentNavigatorPrivate {
-	gint dummy; /**< unused dummy attribute, may be deleted when other attributes are added */
-
-	/**
-	 * @todo
-	 * Add necessary \b private instance attributes. They must be
-	 * initialized in the instance initializer function.
-	 */
+	GCancellable *load_cancellable;	/**< Cancels asynchronous load in flight */
 };
 
 struct TopicCallbackData {
 	GtkTreeIter iter;
 	GtkTreeStore *store;
-	gint64 start_time;
-	gint64 end_time;
 };
 
 /** @private */
@@ -189,6 +186,7 @@ gtk_experiment_navigator_init(GtkExperimentNavigator *klass)
 	GtkTreeStore	*store;
 
 	klass->priv = GTK_EXPERIMENT_NAVIGATOR_GET_PRIVATE(klass);
+	klass->priv->load_cancellable = NULL;
 	/*
 	 * Create tree store (and model)
 	 * NOTE: GtkTreeStore is directly derived from GObject and has a
@@ -291,21 +289,16 @@ gtk_experiment_navigator_init(GtkExperimentNavigator *klass)
 static void
 gtk_experiment_navigator_dispose(GObject *gobject)
 {
-	//GtkExperimentNavigator *navi = GTK_EXPERIMENT_NAVIGATOR(gobject);
+	GtkExperimentNavigator *navi = GTK_EXPERIMENT_NAVIGATOR(gobject);
 
 	/*
 	 * destroy might be called more than once, but we have only one
 	 * reference for each object
 	 */
-	/**
-	 * @todo
-	 * Unreference all \e GObject references kept in public or
-	 * private attributes. Use \ref GOBJECT_UNREF_SAFE.
-	 * For example, to unreference private object \c widget:
-	 * @code
-	 * 	GOBJECT_UNREF_SAFE(navi->priv->widget);
-	 * @endcode
-	 */
+	if (navi->priv->load_cancellable != NULL) {
+		g_cancellable_cancel(navi->priv->load_cancellable);
+		GOBJECT_UNREF_SAFE(navi->priv->load_cancellable);
+	}
 
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS(gtk_experiment_navigator_parent_class)->dispose(gobject);
@@ -452,34 +445,57 @@ activate_section(GtkExperimentNavigator *navi, gint64 start, gint64 end)
 
 /**
  * Callback function insert new row in GtkTreeStore
- * initialised colomb name and start time out of userdata
+ * below the section row given in userdata
  * 
- * @param reader     \e ExperimentReader the information refers to
- * @param topic_id   Symbolic identifier of experiment \b topic
- * @param start_time Beginning of first \b contribution in \e topic (milliseconds)
- * @param end_time   End of last \b contribution in \e topic (milliseconds)
- * @param data       Callback user data
+ * @param section Section containing the topic
+ * @param topic   Topic to insert
+ * @param data    Callback user data
  */
 static void
-topic_row_callback(ExperimentReader *reader,
-		   const gchar *topic_id,
-		   gint64 start_time,
-		   gint64 end_time,
+topic_row_callback(ExperimentReaderSection section __attribute__((unused)),
+		   const ExperimentReaderTopic *topic,
 		   gpointer data)
 {
 	struct TopicCallbackData *tcb = (struct TopicCallbackData *) data;
-	GtkTreeIter topic;
+	GtkTreeIter iter;
+
+	gtk_tree_store_append(tcb->store, &iter, &tcb->iter);
+	gtk_tree_store_set(tcb->store, &iter,
+			   COL_NAME, topic->id,
+			   COL_START_TIME, topic->start_time,
+			   COL_END_TIME, topic->end_time,
+			   -1);
+}
 
-	if (tcb->start_time < 0)
-		tcb->start_time = start_time;
-	tcb->end_time = end_time;
+/**
+ * Insert row for a section of the session structure and its topics
+ * into the GtkTreeStore
+ *
+ * @param store     Tree store
+ * @param parent    Parent row or \c NULL
+ * @param name      Row name
+ * @param structure Session structure
+ * @param section   Section to insert
+ */
+static void
+append_section_row(GtkTreeStore *store, GtkTreeIter *parent,
+		   const gchar *name,
+		   const ExperimentReaderStructure *structure,
+		   ExperimentReaderSection section)
+{
+	const ExperimentReaderSectionInfo *info = structure->sections + section;
+	struct TopicCallbackData tcd;
 
-	gtk_tree_store_append(tcb->store, &topic, &tcb->iter);
-	gtk_tree_store_set(tcb->store, &topic,
-			   COL_NAME, topic_id,
-			   COL_START_TIME, start_time,
-			   COL_END_TIME, end_time,
+	tcd.store = store;
+	gtk_tree_store_append(store, &tcd.iter, parent);
+	gtk_tree_store_set(store, &tcd.iter,
+			   COL_NAME,		name,
+			   COL_START_TIME,	info->start_time,
+			   COL_END_TIME,	info->end_time,
 			   -1);
+
+	experiment_reader_structure_foreach_topic(structure, section,
+						  topic_row_callback, &tcd);
 }
 
 /*
@@ -510,101 +526,54 @@ gboolean
 gtk_experiment_navigator_load(GtkExperimentNavigator *navi,
 			      ExperimentReader *exp)
 {
-	struct TopicCallbackData tcd;
+	const ExperimentReaderStructure *structure;
+	const ExperimentReaderSectionInfo *sections;
+	GtkTreeStore *store;
 	GtkTreeIter experiment_level;
 	GtkTreeIter last_minute_level;
 
-	tcd.store = GTK_TREE_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(navi)));
-	gtk_tree_store_clear(tcd.store);
+	/* all sections and their times are extracted at once */
+	structure = experiment_reader_get_structure(exp);
+	sections = structure->sections;
 
-	/* greeting */
-	gtk_tree_store_append(tcd.store, &tcd.iter, NULL);
-
-	tcd.start_time = -1;
-	experiment_reader_foreach_greeting_topic(exp, topic_row_callback, &tcd);
+	store = GTK_TREE_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(navi)));
+	gtk_tree_store_clear(store);
 
-	gtk_tree_store_set(tcd.store, &tcd.iter,
-			   COL_NAME,		"greeting",
-			   COL_START_TIME,	tcd.start_time,
-			   COL_END_TIME,	tcd.end_time,
-			   -1);
+	/* greeting */
+	append_section_row(store, NULL, "greeting", structure,
+			   EXPERIMENT_READER_SECTION_GREETING);
 
 	/* experiment */
-	gtk_tree_store_append(tcd.store, &experiment_level, NULL);
-	gtk_tree_store_set(tcd.store, &experiment_level,
+	gtk_tree_store_append(store, &experiment_level, NULL);
+	gtk_tree_store_set(store, &experiment_level,
 			   COL_NAME,		"experiment",
+			   COL_START_TIME,	sections[EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE].start_time,
+			   COL_END_TIME,	sections[EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE_LAST].end_time,
 			   -1);
 
-	gtk_tree_store_append(tcd.store, &tcd.iter, &experiment_level);
-
-	tcd.start_time = -1;
-	experiment_reader_foreach_exp_initial_narrative_topic(exp,
-							      topic_row_callback,
-							      &tcd);
+	append_section_row(store, &experiment_level, "initial-narrative",
+			   structure,
+			   EXPERIMENT_READER_SECTION_INITIAL_NARRATIVE);
 
-	gtk_tree_store_set(tcd.store, &tcd.iter,
-			   COL_NAME,		"initial-narrative",
-			   COL_START_TIME,	tcd.start_time < 0 ? tcd.end_time
-							           : tcd.start_time,
-			   COL_END_TIME,	tcd.end_time,
-			   -1);
-
-	gtk_tree_store_set(tcd.store, &experiment_level,
-			   COL_START_TIME, tcd.start_time < 0 ? tcd.end_time
-							      : tcd.start_time,
-			   -1);
-
-	gtk_tree_store_append(tcd.store, &last_minute_level, &experiment_level);
-	gtk_tree_store_set(tcd.store, &last_minute_level,
-			   COL_NAME, "last minute",
+	gtk_tree_store_append(store, &last_minute_level, &experiment_level);
+	gtk_tree_store_set(store, &last_minute_level,
+			   COL_NAME,		"last minute",
+			   COL_START_TIME,	sections[EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE].start_time,
+			   COL_END_TIME,	sections[EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE_LAST].end_time,
 			   -1);
 
 	for (gint i = 1; i <= 6; i++) {
 		gchar phasename[8];
 
 		g_snprintf(phasename, sizeof(phasename), "phase %d", i);
-		gtk_tree_store_append(tcd.store,
-				      &tcd.iter,
-				      &last_minute_level);
-
-		tcd.start_time = -1;
-		experiment_reader_foreach_exp_last_minute_phase_topic(exp, i, topic_row_callback, &tcd);
-
-		gtk_tree_store_set(tcd.store, &tcd.iter,
-				   COL_NAME, phasename,
-				   COL_START_TIME, tcd.start_time < 0 ? tcd.end_time
-								      : tcd.start_time,
-				   COL_END_TIME, tcd.end_time,
-				   -1);
-
-		if (i == 1) {
-			gtk_tree_store_set(tcd.store, &last_minute_level,
-					   COL_START_TIME,
-					   tcd.start_time < 0 ? tcd.end_time
-							      : tcd.start_time,
-					   -1);
-		}
+		append_section_row(store, &last_minute_level, phasename,
+				   structure,
+				   EXPERIMENT_READER_SECTION_LAST_MINUTE_PHASE + i - 1);
 	}
 
-	gtk_tree_store_set(tcd.store, &last_minute_level,
-			   COL_END_TIME, tcd.end_time,
-			   -1);
-
-	gtk_tree_store_set(tcd.store, &experiment_level,
-			   COL_END_TIME, tcd.end_time,
-			   -1);
-
 	/* farewell */
-	gtk_tree_store_append(tcd.store, &tcd.iter, NULL);
-
-	tcd.start_time = -1;
-	experiment_reader_foreach_farewell_topic(exp, topic_row_callback, &tcd);
-
-	gtk_tree_store_set(tcd.store, &tcd.iter,
-			   COL_NAME,		"farewell",
-			   COL_START_TIME,	tcd.start_time,
-			   COL_END_TIME,	tcd.end_time,
-			   -1);
+	append_section_row(store, NULL, "farewell", structure,
+			   EXPERIMENT_READER_SECTION_FAREWELL);
 
 	return TRUE;
 }
@@ -626,7 +595,10 @@ gtk_experiment_navigator_load_filename(GtkExperimentNavigator *navi,
 				       const gchar *exp)
 {
 	gboolean returnvalue;
-	ExperimentReader *expread = experiment_reader_new(exp);
+	ExperimentReader *expread;
+
+	expread = experiment_reader_new_with_flags(exp,
+						   EXPERIMENT_READER_FLAG_STREAMING);
 	
 	if (expread == NULL)
 		return FALSE;
@@ -636,3 +608,102 @@ gtk_experiment_navigator_load_filename(GtkExperimentNavigator *navi,
 	
 	return returnvalue;
 }
+
+/** @private */
+static void
+load_filename_ready_cb(GObject *source __attribute__((unused)),
+		       GAsyncResult *result, gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT(user_data);
+	GtkExperimentNavigator *navi;
+	ExperimentReader *expread;
+	GError *error = NULL;
+
+	navi = GTK_EXPERIMENT_NAVIGATOR(g_async_result_get_source_object(G_ASYNC_RESULT(res)));
+
+	/* GLib idle callbacks are invoked without the GDK lock */
+	gdk_threads_enter();
+
+	expread = experiment_reader_new_finish(result, &error);
+	if (expread != NULL) {
+		g_simple_async_result_set_op_res_gboolean(res,
+							  gtk_experiment_navigator_load(navi, expread));
+		g_object_unref(expread);
+	} else {
+		g_simple_async_result_set_from_error(res, error);
+		g_error_free(error);
+	}
+
+	g_simple_async_result_complete(res);
+
+	gdk_threads_leave();
+
+	g_object_unref(res);
+	g_object_unref(navi);
+}
+
+/**
+ * Fills the \e GtkExperimentNavigator widget with the structure specified
+ * in an experiment-XML file (see session.dtd) asynchronously.
+ * The file is read in a worker thread and the widget's contents are
+ * only replaced when it is ready.
+ * Starting another load cancels the one in flight.
+ *
+ * \e callback is invoked with the GDK lock held and must call
+ * \ref gtk_experiment_navigator_load_filename_finish.
+ *
+ * @sa gtk_experiment_navigator_load_filename
+ *
+ * @param navi      Object instance to display the structure in
+ * @param exp       Filename of XML-file to open and use for configuring \e navi
+ * @param callback  Callback to invoke when loading is finished or \c NULL
+ * @param user_data Data to pass to \e callback
+ */
+void
+gtk_experiment_navigator_load_filename_async(GtkExperimentNavigator *navi,
+					     const gchar *exp,
+					     GAsyncReadyCallback callback,
+					     gpointer user_data)
+{
+	GSimpleAsyncResult *res;
+
+	if (navi->priv->load_cancellable != NULL) {
+		g_cancellable_cancel(navi->priv->load_cancellable);
+		g_object_unref(navi->priv->load_cancellable);
+	}
+	navi->priv->load_cancellable = g_cancellable_new();
+
+	res = g_simple_async_result_new(G_OBJECT(navi), callback, user_data,
+					gtk_experiment_navigator_load_filename_async);
+	experiment_reader_new_async(exp, EXPERIMENT_READER_FLAG_STREAMING,
+				    navi->priv->load_cancellable,
+				    load_filename_ready_cb, res);
+}
+
+/**
+ * Finishes filling the \e GtkExperimentNavigator widget asynchronously.
+ *
+ * @sa gtk_experiment_navigator_load_filename_async
+ *
+ * @param navi   Object instance
+ * @param result \e GAsyncResult passed to the callback
+ * @param error  Location to store error or \c NULL. If the load was
+ *               cancelled, it is set to \c G_IO_ERROR_CANCELLED.
+ * @return \c TRUE on success, else \c FALSE
+ */
+gboolean
+gtk_experiment_navigator_load_filename_finish(GtkExperimentNavigator *navi,
+					      GAsyncResult *result,
+					      GError **error)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT(result);
+
+	g_return_val_if_fail(g_simple_async_result_is_valid(result, G_OBJECT(navi),
+							    gtk_experiment_navigator_load_filename_async),
+			     FALSE);
+
+	if (g_simple_async_result_propagate_error(res, error))
+		return FALSE;
+
+	return g_simple_async_result_get_op_res_gboolean(res);
+}
@@ -108,6 +108,13 @@ gboolean gtk_experiment_navigator_load(GtkExperimentNavigator *navi,
 				       ExperimentReader *exp);
 gboolean gtk_experiment_navigator_load_filename(GtkExperimentNavigator *navi,
 						const gchar *exp);
+void gtk_experiment_navigator_load_filename_async(GtkExperimentNavigator *navi,
+						  const gchar *exp,
+						  GAsyncReadyCallback callback,
+						  gpointer user_data);
+gboolean gtk_experiment_navigator_load_filename_finish(GtkExperimentNavigator *navi,
+						       GAsyncResult *result,
+						       GError **error);
 
 G_END_DECLS
 
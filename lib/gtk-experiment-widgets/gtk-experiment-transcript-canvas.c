@@ -0,0 +1,245 @@
+/**
+ * @file
+ * Drawing primitives of the \e GtkExperimentTranscript widget, either
+ * using GDK graphics contexts or cairo
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include <gdk/gdk.h>
+#include <gtk/gtk.h>
+
+#include <cairo.h>
+#include <pango/pangocairo.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+
+static void get_color(GtkExperimentTranscript *trans,
+		      GtkExperimentTranscriptPaint paint, GdkColor *color);
+static cairo_pattern_t *get_source(GtkExperimentTranscript *trans,
+				   GtkExperimentTranscriptPaint paint);
+static GdkGC *get_gc(GtkExperimentTranscript *trans,
+		     GtkExperimentTranscriptPaint paint);
+
+/**
+ * @private
+ * Get color of a paint in the widget's current state.
+ * The backdrop area is drawn with the background color, darkened by
+ * \ref BACKDROP_VALUE or lightened if it is black.
+ */
+static void
+get_color(GtkExperimentTranscript *trans, GtkExperimentTranscriptPaint paint,
+	  GdkColor *color)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+	GtkStateType state = gtk_widget_get_state(widget);
+	GdkColor *bg = &widget->style->bg[state];
+
+	switch (paint) {
+	case GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT:
+		*color = widget->style->text[state];
+		return;
+	case GTK_EXPERIMENT_TRANSCRIPT_PAINT_BG:
+		*color = *bg;
+		return;
+	default:
+		break;
+	}
+
+	color->pixel = 0;
+	color->red = MAX((gint)bg->red - BACKDROP_VALUE, 0);
+	color->blue = MAX((gint)bg->blue - BACKDROP_VALUE, 0);
+	color->green = MAX((gint)bg->green - BACKDROP_VALUE, 0);
+	if (!color->red && !color->blue && !color->green) {
+		color->red = MIN((gint)bg->red + BACKDROP_VALUE, G_MAXUINT16);
+		color->blue = MIN((gint)bg->blue + BACKDROP_VALUE, G_MAXUINT16);
+		color->green = MIN((gint)bg->green + BACKDROP_VALUE, G_MAXUINT16);
+	}
+}
+
+/**
+ * @private
+ * Get cairo source of a paint.
+ * Sources are cached until the style or state changes.
+ */
+static cairo_pattern_t *
+get_source(GtkExperimentTranscript *trans, GtkExperimentTranscriptPaint paint)
+{
+	cairo_pattern_t **source = &trans->priv->paints.sources[paint];
+
+	if (*source == NULL) {
+		GdkColor color;
+
+		get_color(trans, paint, &color);
+		*source = cairo_pattern_create_rgb(color.red/65535.,
+						   color.green/65535.,
+						   color.blue/65535.);
+	}
+
+	return *source;
+}
+
+/**
+ * @private
+ * Get style GC of a paint.
+ * There is no style color for the backdrop area, so the foreground
+ * color is modified for it.
+ */
+static GdkGC *
+get_gc(GtkExperimentTranscript *trans, GtkExperimentTranscriptPaint paint)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+	GtkStateType state = gtk_widget_get_state(widget);
+	GdkColor color;
+
+	switch (paint) {
+	case GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT:
+		return widget->style->text_gc[state];
+	case GTK_EXPERIMENT_TRANSCRIPT_PAINT_BG:
+		return widget->style->bg_gc[state];
+	default:
+		break;
+	}
+
+	get_color(trans, paint, &color);
+	/* modifying the style is expensive, so only do it when necessary */
+	if (!gdk_color_equal(&color, &widget->style->fg[state]))
+		gtk_widget_modify_fg(widget, state, &color);
+
+	return widget->style->fg_gc[state];
+}
+
+/**
+ * @private
+ * @brief Begin drawing into a drawable
+ *
+ * All drawing on the canvas is clipped to \e clip.
+ * Must be followed by \ref gtk_experiment_transcript_canvas_end
+ * before drawing into the drawable by other means.
+ *
+ * @param trans    Widget instance
+ * @param canvas   Canvas to initialize
+ * @param drawable Drawable to draw into
+ * @param clip     Area of \e drawable to clip drawing to
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_canvas_begin(GtkExperimentTranscript *trans,
+				       GtkExperimentTranscriptCanvas *canvas,
+				       GdkDrawable *drawable,
+				       const GdkRectangle *clip)
+{
+	canvas->drawable = drawable;
+	canvas->clip = *clip;
+
+	if (gtk_experiment_transcript_get_use_cairo(trans)) {
+		canvas->cr = gdk_cairo_create(drawable);
+		gdk_cairo_rectangle(canvas->cr, clip);
+		cairo_clip(canvas->cr);
+	} else {
+		canvas->cr = NULL;
+		/*
+		 * getting the backdrop GC may replace the style, so it must
+		 * be done before clipping the style's text GC
+		 */
+		if (gtk_experiment_transcript_get_use_backdrop_area(trans))
+			get_gc(trans, GTK_EXPERIMENT_TRANSCRIPT_PAINT_BACKDROP);
+		/* style GCs are shared, so the clip area must be reset */
+		gdk_gc_set_clip_rectangle(get_gc(trans, GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT),
+					  &canvas->clip);
+	}
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_canvas_end(GtkExperimentTranscript *trans,
+				     GtkExperimentTranscriptCanvas *canvas)
+{
+	if (canvas->cr != NULL) {
+		cairo_destroy(canvas->cr);
+		canvas->cr = NULL;
+	} else {
+		gdk_gc_set_clip_rectangle(get_gc(trans, GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT),
+					  NULL);
+	}
+}
+
+/**
+ * @private
+ * Fill a rectangle.
+ * Only text is clipped when drawing with GDK, so the rectangle
+ * should be within the canvas' clip area.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_canvas_fill(GtkExperimentTranscript *trans,
+				      GtkExperimentTranscriptCanvas *canvas,
+				      GtkExperimentTranscriptPaint paint,
+				      const GdkRectangle *rect)
+{
+	if (canvas->cr == NULL) {
+		gdk_draw_rectangle(canvas->drawable, get_gc(trans, paint), TRUE,
+				   rect->x, rect->y, rect->width, rect->height);
+		return;
+	}
+
+	cairo_set_source(canvas->cr, get_source(trans, paint));
+	gdk_cairo_rectangle(canvas->cr, rect);
+	cairo_fill(canvas->cr);
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_canvas_draw_layout(GtkExperimentTranscript *trans,
+					     GtkExperimentTranscriptCanvas *canvas,
+					     gint x, gint y, PangoLayout *layout)
+{
+	if (canvas->cr == NULL) {
+		gdk_draw_layout(canvas->drawable,
+				get_gc(trans, GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT),
+				x, y, layout);
+		return;
+	}
+
+	cairo_set_source(canvas->cr,
+			 get_source(trans, GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT));
+	cairo_move_to(canvas->cr, x, y);
+	pango_cairo_show_layout(canvas->cr, layout);
+}
+
+/**
+ * @private
+ * Drop cached cairo sources, e.g. because the style or state changed.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_flush_paints(GtkExperimentTranscript *trans)
+{
+	cairo_pattern_t **sources = trans->priv->paints.sources;
+
+	for (gint i = 0; i < GTK_EXPERIMENT_TRANSCRIPT_N_PAINTS; i++) {
+		if (sources[i] != NULL) {
+			cairo_pattern_destroy(sources[i]);
+			sources[i] = NULL;
+		}
+	}
+}
@@ -44,8 +44,13 @@ static gboolean gtk_experiment_transcript_parse_format(GtkExperimentTranscriptFo
 						       const gchar *str,
 						       GError **error);
 
-#define FORMAT_REGEX_COMPILE_FLAGS	(G_REGEX_CASELESS)
-#define FORMAT_REGEX_MATCH_FLAGS	(0)
+static gboolean change_attribute(PangoAttribute *attrib, gpointer user_data);
+static void update_contrib_highlights(GtkExperimentTranscript *trans,
+				      guint contrib);
+static gboolean update_highlights_idle(gpointer user_data);
+
+/** Number of contributions to update highlights for per idle handler call */
+#define HIGHLIGHTS_CHUNK_SIZE		256
 
 static inline gint
 attr_list_get_length(PangoAttrList *list)
@@ -126,16 +131,22 @@ gtk_experiment_transcript_parse_format(GtkExperimentTranscriptFormat *fmt,
 	return TRUE;
 }
 
-/** @private */
-G_GNUC_INTERNAL void
+/**
+ * @private
+ * Add attributes of a format to the spans of \e text it matches.
+ *
+ * @return \c TRUE if any attribute was added, else \c FALSE
+ */
+G_GNUC_INTERNAL gboolean
 gtk_experiment_transcript_apply_format(GtkExperimentTranscriptFormat *fmt,
 				       const gchar *text,
 				       PangoAttrList *attrib_list)
 {
 	GMatchInfo *match_info;
+	gboolean changed = FALSE;
 
 	if (fmt->regexp == NULL || fmt->attribs == NULL)
-		return;
+		return FALSE;
 
 	g_regex_match(fmt->regexp, text, FORMAT_REGEX_MATCH_FLAGS, &match_info);
 
@@ -169,6 +180,7 @@ gtk_experiment_transcript_apply_format(GtkExperimentTranscriptFormat *fmt,
 				attrib->start_index = (guint)start;
 				attrib->end_index = (guint)end;
 				pango_attr_list_change(attrib_list, attrib);
+				changed = TRUE;
 			}
 			g_slist_free(attribs);
 		} while (pango_attr_iterator_next(iter));
@@ -178,6 +190,8 @@ gtk_experiment_transcript_apply_format(GtkExperimentTranscriptFormat *fmt,
 	}
 
 	g_match_info_free(match_info);
+
+	return changed;
 }
 
 /** @private */
@@ -195,46 +209,238 @@ gtk_experiment_transcript_free_formats(GSList *formats)
 	g_slist_free(formats);
 }
 
-/*
- * API
+static gboolean
+change_attribute(PangoAttribute *attrib, gpointer user_data)
+{
+	pango_attr_list_change((PangoAttrList *)user_data,
+			       pango_attribute_copy(attrib));
+
+	/* do not filter anything */
+	return FALSE;
+}
+
+static void
+update_contrib_highlights(GtkExperimentTranscript *trans, guint contrib)
+{
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+	const gchar *text;
+	PangoAttrList *attrib_list;
+
+	text = experiment_reader_contrib_table_get_text(trans->priv->contribs,
+							contrib);
+
+	if (hl->pending & GTK_EXPERIMENT_TRANSCRIPT_FORMATS_MASK) {
+		if (hl->format_attribs[contrib] != NULL)
+			pango_attr_list_unref(hl->format_attribs[contrib]);
+
+		attrib_list = pango_attr_list_new();
+		if (!gtk_experiment_transcript_rule_set_apply(trans->priv->rules,
+							      text, attrib_list)) {
+			pango_attr_list_unref(attrib_list);
+			attrib_list = NULL;
+		}
+		hl->format_attribs[contrib] = attrib_list;
+	}
+
+	if (hl->pending & GTK_EXPERIMENT_TRANSCRIPT_INTERACTIVE_FORMAT_MASK) {
+		if (hl->interactive_attribs[contrib] != NULL)
+			pango_attr_list_unref(hl->interactive_attribs[contrib]);
+
+		attrib_list = pango_attr_list_new();
+		if (!gtk_experiment_transcript_apply_format(&trans->priv->interactive_format,
+							    text, attrib_list)) {
+			pango_attr_list_unref(attrib_list);
+			attrib_list = NULL;
+		}
+		hl->interactive_attribs[contrib] = attrib_list;
+	}
+}
+
+/**
+ * @private
+ * Update highlights of the next chunk of contributions.
+ * After the first chunk, which contains the contributions currently
+ * displayed, and after the last one, the widget is redrawn.
  */
+static gboolean
+update_highlights_idle(gpointer user_data)
+{
+	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(user_data);
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+	gboolean first = hl->remaining == hl->n_contribs;
+
+	for (guint i = 0; i < HIGHLIGHTS_CHUNK_SIZE && hl->remaining; i++) {
+		update_contrib_highlights(trans, hl->next);
+
+		hl->next = hl->next ? hl->next - 1 : hl->n_contribs - 1;
+		hl->remaining--;
+	}
+
+	if (first || !hl->remaining) {
+		/* invalidates cached layouts */
+		trans->priv->format_generation++;
+
+		if (gtk_widget_get_realized(GTK_WIDGET(trans)) &&
+		    trans->priv->layer_text != NULL)
+			gtk_experiment_transcript_text_layer_redraw(trans);
+	}
+
+	if (hl->remaining)
+		return TRUE;
+
+	hl->pending = 0;
+	hl->idle_id = 0;
+	return FALSE;
+}
 
 /**
- * @brief Load a format file to use with the transcript widget
+ * @private
+ * Discard the highlights of all contributions, e.g. because new
+ * contributions were loaded, and compute them again.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_reset_highlights(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+
+	gtk_experiment_transcript_free_highlights(trans);
+
+	hl->n_contribs = trans->priv->contribs != NULL
+				? trans->priv->contribs->n_contribs : 0;
+	hl->format_attribs = g_new0(PangoAttrList *, hl->n_contribs);
+	hl->interactive_attribs = g_new0(PangoAttrList *, hl->n_contribs);
+
+	if (hl->n_contribs)
+		gtk_experiment_transcript_update_highlights(trans,
+							    GTK_EXPERIMENT_TRANSCRIPT_ALL_FORMATS_MASK);
+}
+
+/**
+ * @private
+ * @brief Schedule update of contribution highlights
  *
- * Loading a format file applies additional formattings (highlighting) to the
- * transcript's contributions according to the rules specified in the file.
- * For information about the format file syntax and semantics, refer to the
- * "Experiment Player" manual.
+ * Highlights are computed by matching format rules against all
+ * contributions, so the render path does not have to do any regular
+ * expression matching.
+ * Since this may take a while for large transcripts, the contributions
+ * are processed in chunks from an idle handler, starting with the ones
+ * currently displayed. Until a contribution is updated, it is displayed
+ * with its old highlights.
+ * An update already in progress is restarted.
  *
- * The format file is parsed and and compiled to an internal representation.
+ * @param trans Widget instance
+ * @param mask  Attribute lists to update, i.e. whose format rules changed
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_update_highlights(GtkExperimentTranscript *trans,
+					    GtkExperimentTranscriptHighlightMask mask)
+{
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+	gint64 current_time = 0;
+
+	if (!hl->n_contribs) {
+		trans->priv->format_generation++;
+		gtk_experiment_transcript_text_layer_redraw(trans);
+		return;
+	}
+
+	if (trans->priv->time_adjustment != NULL) {
+		GtkAdjustment *adj =
+				GTK_ADJUSTMENT(trans->priv->time_adjustment);
+		current_time = (gint64)gtk_adjustment_get_value(adj);
+	}
+
+	/* contributions are rendered backwards from the current one */
+	hl->pending |= mask;
+	hl->next = (guint)experiment_reader_contrib_table_lookup(trans->priv->contribs,
+								 current_time);
+	hl->remaining = hl->n_contribs;
+
+	if (!hl->idle_id)
+		hl->idle_id = gdk_threads_add_idle(update_highlights_idle, trans);
+}
+
+/**
+ * @private
+ * Get highlighting attributes of a contribution.
  *
- * @param trans    Widget instance
- * @param filename File name of format file to load (\c NULL or empty string
- *                 resets any formattings of a previously loaded file)
+ * @param trans   Widget instance
+ * @param contrib Contribution index
+ * @return New attribute list, must be unreferenced
+ */
+G_GNUC_INTERNAL PangoAttrList *
+gtk_experiment_transcript_get_highlights(GtkExperimentTranscript *trans,
+					 guint contrib)
+{
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+	PangoAttrList *attrib_list;
+
+	if (contrib >= hl->n_contribs)
+		return pango_attr_list_new();
+
+	attrib_list = hl->format_attribs[contrib] != NULL
+			? pango_attr_list_copy(hl->format_attribs[contrib])
+			: pango_attr_list_new();
+
+	/* interactive format rule is applied after format file rules */
+	if (hl->interactive_attribs[contrib] != NULL)
+		pango_attr_list_filter(hl->interactive_attribs[contrib],
+				       change_attribute, attrib_list);
+
+	return attrib_list;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_free_highlights(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptHighlights *hl = &trans->priv->highlights;
+
+	if (hl->idle_id) {
+		g_source_remove(hl->idle_id);
+		hl->idle_id = 0;
+	}
+	hl->pending = 0;
+
+	for (guint i = 0; i < hl->n_contribs; i++) {
+		if (hl->format_attribs[i] != NULL)
+			pango_attr_list_unref(hl->format_attribs[i]);
+		if (hl->interactive_attribs[i] != NULL)
+			pango_attr_list_unref(hl->interactive_attribs[i]);
+	}
+	g_free(hl->format_attribs);
+	g_free(hl->interactive_attribs);
+
+	hl->n_contribs = 0;
+	hl->format_attribs = NULL;
+	hl->interactive_attribs = NULL;
+}
+
+/**
+ * @private
+ * @brief Read and compile format file
+ *
+ * @sa gtk_experiment_transcript_load_formats
+ *
+ * @param filename File name of format file
+ * @param formats  Location to store list of formats (must be freed with
+ *                 \ref gtk_experiment_transcript_free_formats). It is set
+ *                 to \c NULL on failure.
  * @param error    GError to set on failure, or \c NULL
  * @return \c TRUE on success, else \c FALSE
  */
-gboolean
-gtk_experiment_transcript_load_formats(GtkExperimentTranscript *trans,
-				       const gchar *filename,
+G_GNUC_INTERNAL gboolean
+gtk_experiment_transcript_read_formats(const gchar *filename,
+				       GSList **formats,
 				       GError **error)
 {
 	FILE *file;
 	gchar buf[1024];
 	gint cur_line = 0;
 
-	gboolean res = FALSE;
-
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	gtk_experiment_transcript_free_formats(trans->priv->formats);
-	trans->priv->formats = NULL;
-
-	if (filename == NULL || !*filename) {
-		res = TRUE;
-		goto redraw;
-	}
+	*formats = NULL;
 
 	if ((file = g_fopen(filename, "r")) == NULL) {
 		g_set_error(error,
@@ -243,7 +449,7 @@ gtk_experiment_transcript_load_formats(GtkExperimentTranscript *trans,
 			    "Failed to open format file \"%s\":\n%s",
 			    filename, g_strerror(errno));
 
-		goto redraw;
+		return FALSE;
 	}
 
 	while (fgets((char *)buf, sizeof(buf), file) != NULL) {
@@ -260,10 +466,10 @@ gtk_experiment_transcript_load_formats(GtkExperimentTranscript *trans,
 				    cur_line, filename, (int)sizeof(buf));
 
 			fclose(file);
-			gtk_experiment_transcript_free_formats(trans->priv->formats);
-			trans->priv->formats = NULL;
+			gtk_experiment_transcript_free_formats(*formats);
+			*formats = NULL;
 
-			goto redraw;
+			return FALSE;
 		}
 
 		g_strchug(buf);
@@ -286,21 +492,63 @@ gtk_experiment_transcript_load_formats(GtkExperimentTranscript *trans,
 
 			g_free(fmt);
 			fclose(file);
-			gtk_experiment_transcript_free_formats(trans->priv->formats);
-			trans->priv->formats = NULL;
+			gtk_experiment_transcript_free_formats(*formats);
+			*formats = NULL;
 
-			goto redraw;
+			return FALSE;
 		}
 
-		trans->priv->formats = g_slist_prepend(trans->priv->formats, fmt);
+		*formats = g_slist_prepend(*formats, fmt);
 	}
-	trans->priv->formats = g_slist_reverse(trans->priv->formats);
+	*formats = g_slist_reverse(*formats);
 
 	fclose(file);
-	res = TRUE;
+	return TRUE;
+}
+
+/*
+ * API
+ */
+
+/**
+ * @brief Load a format file to use with the transcript widget
+ *
+ * Loading a format file applies additional formattings (highlighting) to the
+ * transcript's contributions according to the rules specified in the file.
+ * For information about the format file syntax and semantics, refer to the
+ * "Experiment Player" manual.
+ *
+ * The format file is parsed and and compiled to an internal representation.
+ *
+ * @param trans    Widget instance
+ * @param filename File name of format file to load (\c NULL or empty string
+ *                 resets any formattings of a previously loaded file)
+ * @param error    GError to set on failure, or \c NULL
+ * @return \c TRUE on success, else \c FALSE
+ */
+gboolean
+gtk_experiment_transcript_load_formats(GtkExperimentTranscript *trans,
+				       const gchar *filename,
+				       GError **error)
+{
+	gboolean res = TRUE;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* rule set refers to the formats */
+	gtk_experiment_transcript_rule_set_free(trans->priv->rules);
+	gtk_experiment_transcript_free_formats(trans->priv->formats);
+	trans->priv->formats = NULL;
+
+	if (filename != NULL && *filename)
+		res = gtk_experiment_transcript_read_formats(filename,
+							     &trans->priv->formats,
+							     error);
+	trans->priv->rules =
+		gtk_experiment_transcript_rule_set_new(trans->priv->formats);
 
-redraw:
-	gtk_experiment_transcript_text_layer_redraw(trans);
+	gtk_experiment_transcript_update_highlights(trans,
+						    GTK_EXPERIMENT_TRANSCRIPT_FORMATS_MASK);
 	return res;
 }
 
@@ -348,20 +596,20 @@ gtk_experiment_transcript_set_interactive_format(GtkExperimentTranscript *trans,
 
 	if (format_str == NULL || !*format_str) {
 		res = TRUE;
-		goto redraw;
+		goto update;
 	}
 
 	if (with_markup) {
 		res = gtk_experiment_transcript_parse_format(fmt, format_str,
 							     error);
-		goto redraw;
+		goto update;
 	}
 	/* else if (!with_markup) */
 
 	fmt->attribs = pango_attr_list_new();
 	g_warn_if_fail(fmt->attribs != NULL);
 	if (fmt->attribs == NULL)
-		goto redraw;
+		goto update;
 
 	if (trans->interactive_format.default_font != NULL) {
 		attrib = pango_attr_font_desc_new(trans->interactive_format.default_font);
@@ -394,7 +642,7 @@ gtk_experiment_transcript_set_interactive_format(GtkExperimentTranscript *trans,
 		gtk_experiment_transcript_free_format(fmt);
 		fmt->attribs = NULL;
 
-		goto redraw;
+		goto update;
 	}
 
 	if (g_regex_get_capture_count(fmt->regexp) != 1) {
@@ -407,11 +655,12 @@ gtk_experiment_transcript_set_interactive_format(GtkExperimentTranscript *trans,
 		fmt->regexp = NULL;
 		fmt->attribs = NULL;
 
-		goto redraw;
+		goto update;
 	}
 	res = TRUE;
 
-redraw:
-	gtk_experiment_transcript_text_layer_redraw(trans);
+update:
+	gtk_experiment_transcript_update_highlights(trans,
+						    GTK_EXPERIMENT_TRANSCRIPT_INTERACTIVE_FORMAT_MASK);
 	return res;
 }
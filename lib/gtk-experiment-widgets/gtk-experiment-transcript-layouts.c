@@ -0,0 +1,422 @@
+/**
+ * @file
+ * Cache of laid-out contributions of the \e GtkExperimentTranscript
+ * widget
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <gtk/gtk.h>
+
+#include <experiment-reader.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+
+/**
+ * @private
+ * Estimated size of a layout in bytes, not counting the parts depending
+ * on the length of its text
+ */
+#define LAYOUT_SIZE_BASE	512
+/**
+ * @private
+ * Estimated size of a layout per byte of text (text copy, log attributes,
+ * glyph strings and attributes)
+ */
+#define LAYOUT_SIZE_PER_BYTE	48
+
+/** @private */
+typedef struct _GtkExperimentTranscriptLayoutKey {
+	guint	contrib;	/**< Contribution index */
+	gint	width;		/**< Wrap width in Pango units */
+	gint	height;		/**< Height clamp in pixels (multiple of the line height) or -1 */
+	guint	generation;	/**< Format generation the layout was created for */
+} GtkExperimentTranscriptLayoutKey;
+
+/**
+ * @private
+ * Logical height of a contribution's unclamped text, valid as long as
+ * the wrap width and formats do not change
+ */
+typedef struct _GtkExperimentTranscriptLayoutHeight {
+	gint	width;		/**< Wrap width in Pango units */
+	guint	generation;	/**< Format generation */
+	gint	height;		/**< Logical height in pixels */
+} GtkExperimentTranscriptLayoutHeight;
+
+/** @private */
+typedef struct _GtkExperimentTranscriptLayout {
+	GtkExperimentTranscriptLayoutKey key;	/**< Hash table key, must be the first field */
+
+	PangoLayout	*layout;
+	gint		logical_height;		/**< Logical height of \e layout in pixels */
+	gsize		size;			/**< Estimated size in bytes */
+
+	GList		link;			/**< Link in the LRU queue, its data points to the entry */
+} GtkExperimentTranscriptLayout;
+
+static guint layout_key_hash(gconstpointer key);
+static gboolean layout_key_equal(gconstpointer a, gconstpointer b);
+static void layout_free(gpointer data);
+static PangoLayout *create_layout(GtkExperimentTranscript *trans,
+				  guint contrib, gint height);
+static void trim_layouts(GtkExperimentTranscript *trans);
+static gint lookup_height(GtkExperimentTranscript *trans, guint contrib);
+static void store_height(GtkExperimentTranscript *trans, guint contrib,
+			 gint height);
+static GtkExperimentTranscriptLayout *lookup_layout(GtkExperimentTranscript *trans,
+						    guint contrib, gint height);
+
+static guint
+layout_key_hash(gconstpointer key)
+{
+	const GtkExperimentTranscriptLayoutKey *k = key;
+	guint hash = k->contrib;
+
+	hash = hash*31 + (guint)k->width;
+	hash = hash*31 + (guint)k->height;
+	hash = hash*31 + k->generation;
+
+	return hash;
+}
+
+static gboolean
+layout_key_equal(gconstpointer a, gconstpointer b)
+{
+	const GtkExperimentTranscriptLayoutKey *ka = a;
+	const GtkExperimentTranscriptLayoutKey *kb = b;
+
+	return ka->contrib == kb->contrib &&
+	       ka->width == kb->width &&
+	       ka->height == kb->height &&
+	       ka->generation == kb->generation;
+}
+
+static void
+layout_free(gpointer data)
+{
+	GtkExperimentTranscriptLayout *entry = data;
+
+	g_object_unref(entry->layout);
+	g_free(entry);
+}
+
+/**
+ * @private
+ * Lay out a contribution's text with its highlights.
+ * The layout is a copy of \e layer_text_layout, so it inherits its
+ * width, alignment, wrapping and ellipsization.
+ */
+static PangoLayout *
+create_layout(GtkExperimentTranscript *trans, guint contrib, gint height)
+{
+	const gchar *text;
+	PangoLayout *layout;
+	PangoAttrList *attrib_list;
+	GtkExperimentTranscriptPhase phase;
+
+	text = experiment_reader_contrib_table_get_text(trans->priv->contribs,
+							contrib);
+
+	phase = gtk_experiment_transcript_profile_enter(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_PHASE_FORMAT);
+	attrib_list = gtk_experiment_transcript_get_highlights(trans, contrib);
+	gtk_experiment_transcript_profile_leave(trans, phase);
+
+	layout = pango_layout_copy(trans->priv->layer_text_layout);
+	pango_layout_set_attributes(layout, attrib_list);
+	pango_attr_list_unref(attrib_list);
+
+	pango_layout_set_text(layout, text, -1);
+
+	pango_layout_set_height(layout,
+				height < 0 ? G_MAXINT : height*PANGO_SCALE);
+
+	return layout;
+}
+
+/**
+ * @private
+ * Evict least recently used layouts until the cache fits into its size
+ * limit. The most recently used layout is always kept, since it may
+ * still be drawn.
+ */
+static void
+trim_layouts(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptLayoutCache *cache =
+							&trans->priv->layouts;
+
+	while (cache->size > cache->max_size &&
+	       g_queue_get_length(&cache->lru) > 1) {
+		GtkExperimentTranscriptLayout *entry;
+
+		entry = g_queue_peek_tail_link(&cache->lru)->data;
+		g_queue_unlink(&cache->lru, &entry->link);
+		cache->size -= entry->size;
+
+		/* frees entry */
+		g_hash_table_remove(cache->entries, &entry->key);
+	}
+}
+
+/**
+ * @private
+ * Get logical height of a contribution's unclamped text if it is known
+ * for the current wrap width and formats.
+ *
+ * @return Height in pixels or -1
+ */
+static gint
+lookup_height(GtkExperimentTranscript *trans, guint contrib)
+{
+	GtkExperimentTranscriptLayoutHeight *entry;
+
+	entry = g_hash_table_lookup(trans->priv->layouts.heights,
+				    GUINT_TO_POINTER(contrib));
+	if (entry == NULL ||
+	    entry->width != pango_layout_get_width(trans->priv->layer_text_layout) ||
+	    entry->generation != trans->priv->format_generation)
+		return -1;
+
+	return entry->height;
+}
+
+/** @private */
+static void
+store_height(GtkExperimentTranscript *trans, guint contrib, gint height)
+{
+	GtkExperimentTranscriptLayoutHeight *entry;
+
+	entry = g_hash_table_lookup(trans->priv->layouts.heights,
+				    GUINT_TO_POINTER(contrib));
+	if (entry == NULL) {
+		entry = g_new(GtkExperimentTranscriptLayoutHeight, 1);
+		g_hash_table_insert(trans->priv->layouts.heights,
+				    GUINT_TO_POINTER(contrib), entry);
+	}
+
+	entry->width = pango_layout_get_width(trans->priv->layer_text_layout);
+	entry->generation = trans->priv->format_generation;
+	entry->height = height;
+}
+
+static GtkExperimentTranscriptLayout *
+lookup_layout(GtkExperimentTranscript *trans, guint contrib, gint height)
+{
+	struct _GtkExperimentTranscriptLayoutCache *cache =
+							&trans->priv->layouts;
+	GtkExperimentTranscriptLayoutKey key;
+	GtkExperimentTranscriptLayout *entry;
+	GtkExperimentTranscriptPhase phase;
+	const gchar *text;
+
+	key.contrib = contrib;
+	key.width = pango_layout_get_width(trans->priv->layer_text_layout);
+	key.height = height;
+	key.generation = trans->priv->format_generation;
+
+	entry = g_hash_table_lookup(cache->entries, &key);
+	if (entry != NULL) {
+		g_queue_unlink(&cache->lru, &entry->link);
+		g_queue_push_head_link(&cache->lru, &entry->link);
+		gtk_experiment_transcript_profile_count(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_COUNT_LAYOUT_HITS);
+
+		return entry;
+	}
+
+	phase = gtk_experiment_transcript_profile_enter(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_PHASE_LAYOUT);
+	gtk_experiment_transcript_profile_count(trans,
+						GTK_EXPERIMENT_TRANSCRIPT_COUNT_LAYOUTS);
+
+	text = experiment_reader_contrib_table_get_text(trans->priv->contribs,
+							contrib);
+
+	entry = g_new(GtkExperimentTranscriptLayout, 1);
+	entry->key = key;
+	entry->layout = create_layout(trans, contrib, height);
+	pango_layout_get_pixel_size(entry->layout, NULL, &entry->logical_height);
+	/* a clamped text that was not ellipsized fits into its clamp */
+	if (height < 0 || !pango_layout_is_ellipsized(entry->layout))
+		store_height(trans, contrib, entry->logical_height);
+	entry->size = sizeof(GtkExperimentTranscriptLayout) + LAYOUT_SIZE_BASE +
+		      strlen(text)*LAYOUT_SIZE_PER_BYTE;
+	entry->link.data = entry;
+	entry->link.prev = entry->link.next = NULL;
+
+	g_hash_table_insert(cache->entries, &entry->key, entry);
+	g_queue_push_head_link(&cache->lru, &entry->link);
+	cache->size += entry->size;
+
+	trim_layouts(trans);
+
+	gtk_experiment_transcript_profile_leave(trans, phase);
+
+	return entry;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_init_layouts(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptLayoutCache *cache =
+							&trans->priv->layouts;
+
+	cache->entries = g_hash_table_new_full(layout_key_hash,
+					       layout_key_equal,
+					       NULL, layout_free);
+	cache->heights = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+					       NULL, g_free);
+	g_queue_init(&cache->lru);
+	cache->size = 0;
+	cache->max_size = DEFAULT_LAYOUT_CACHE_SIZE;
+}
+
+/**
+ * @private
+ * Get layout of a contribution's text.
+ *
+ * Layouts are cached, so the text is only shaped and broken into lines
+ * again if the contribution, the layout width, the height clamp or the
+ * formats have changed.
+ * Since a contribution's height clamp is the distance to the following
+ * contribution, it does not change while scrolling.
+ * Clamps are rounded down to whole lines, so that slightly different
+ * clamps (e.g. when zooming) share a layout.
+ * Once the contribution's unclamped text is known to fit into the
+ * clamp, its unclamped layout is shared for all clamps, otherwise only
+ * the clamped text is laid out.
+ *
+ * @param trans          Widget instance
+ * @param contrib        Contribution index
+ * @param height         Maximum height in pixels or -1 for no limit
+ * @param logical_height Location to store the layout's logical height
+ *                       in pixels
+ * @return Layout owned by the cache, only valid until the next cache
+ *         lookup
+ */
+G_GNUC_INTERNAL PangoLayout *
+gtk_experiment_transcript_get_layout(GtkExperimentTranscript *trans,
+				     guint contrib, gint height,
+				     gint *logical_height)
+{
+	GtkExperimentTranscriptLayout *entry;
+	gint text_height;
+
+	text_height = height < 0 ? -1 : lookup_height(trans, contrib);
+	if (height < 0 || (text_height >= 0 && text_height <= height)) {
+		entry = lookup_layout(trans, contrib, -1);
+	} else {
+		gint line_height = trans->priv->line_height;
+
+		if (line_height > 0 && height >= line_height)
+			height -= height % line_height;
+		entry = lookup_layout(trans, contrib, height);
+	}
+
+	*logical_height = entry->logical_height;
+	return entry->layout;
+}
+
+/**
+ * @private
+ * Remove all layouts from the cache, e.g. because the contributions,
+ * the font or the alignment changed.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_flush_layouts(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptLayoutCache *cache =
+							&trans->priv->layouts;
+
+	if (cache->entries == NULL)
+		return;
+
+	/* links are embedded into the entries, so they must not be freed */
+	g_hash_table_remove_all(cache->entries);
+	g_hash_table_remove_all(cache->heights);
+	g_queue_init(&cache->lru);
+	cache->size = 0;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_free_layouts(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptLayoutCache *cache =
+							&trans->priv->layouts;
+
+	gtk_experiment_transcript_flush_layouts(trans);
+	if (cache->entries != NULL) {
+		g_hash_table_destroy(cache->entries);
+		cache->entries = NULL;
+	}
+	if (cache->heights != NULL) {
+		g_hash_table_destroy(cache->heights);
+		cache->heights = NULL;
+	}
+}
+
+/*
+ * API
+ */
+
+/**
+ * @brief Set size limit of a transcript widget's layout cache
+ *
+ * Laid-out contributions are cached, so that they do not have to be
+ * shaped and broken into lines again whenever the widget is redrawn.
+ * The size of each cached layout is estimated from its text length.
+ * The limit defaults to \ref DEFAULT_LAYOUT_CACHE_SIZE bytes.
+ * A limit of 0 effectively disables the cache.
+ *
+ * @param trans Widget instance
+ * @param size  Maximum size of the cache in bytes
+ */
+void
+gtk_experiment_transcript_set_layout_cache_size(GtkExperimentTranscript *trans,
+						gsize size)
+{
+	trans->priv->layouts.max_size = size;
+	trim_layouts(trans);
+}
+
+/**
+ * @brief Get size limit of a transcript widget's layout cache
+ *
+ * @sa gtk_experiment_transcript_set_layout_cache_size
+ *
+ * @param trans Widget instance
+ * @return Maximum size of the cache in bytes
+ */
+gsize
+gtk_experiment_transcript_get_layout_cache_size(GtkExperimentTranscript *trans)
+{
+	return trans->priv->layouts.max_size;
+}
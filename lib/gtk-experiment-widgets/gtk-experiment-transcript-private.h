@@ -24,6 +24,7 @@
 #define __GTK_EXPERIMENT_TRANSCRIPT_PRIVATE_H
 
 #include <glib.h>
+#include <gio/gio.h>
 
 #include <gdk/gdk.h>
 #include <gtk/gtk.h>
@@ -42,12 +43,59 @@ typedef struct _GtkExperimentTranscriptFormat {
 	PangoAttrList	*attribs;
 } GtkExperimentTranscriptFormat;
 
+/** @private */
+typedef struct _GtkExperimentTranscriptRuleSet GtkExperimentTranscriptRuleSet;
+
+/** @private */
+typedef enum {
+	GTK_EXPERIMENT_TRANSCRIPT_FORMATS_MASK			= 1 << 0,
+	GTK_EXPERIMENT_TRANSCRIPT_INTERACTIVE_FORMAT_MASK	= 1 << 1,
+	GTK_EXPERIMENT_TRANSCRIPT_ALL_FORMATS_MASK		= (1 << 2) - 1
+} GtkExperimentTranscriptHighlightMask;
+
 /** @private */
 typedef enum {
 	GTK_EXPERIMENT_TRANSCRIPT_REVERSE_MASK		= 1 << 0,
-	GTK_EXPERIMENT_TRANSCRIPT_USE_BACKDROP_MASK	= 1 << 1
+	GTK_EXPERIMENT_TRANSCRIPT_USE_BACKDROP_MASK	= 1 << 1,
+	GTK_EXPERIMENT_TRANSCRIPT_USE_CAIRO_MASK	= 1 << 2
 } GtkExperimentTranscriptFlagMask;
 
+/** @private */
+typedef enum {
+	GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT,
+	GTK_EXPERIMENT_TRANSCRIPT_PAINT_BG,
+	GTK_EXPERIMENT_TRANSCRIPT_PAINT_BACKDROP,
+	GTK_EXPERIMENT_TRANSCRIPT_N_PAINTS
+} GtkExperimentTranscriptPaint;
+
+/**
+ * @private
+ * Drawable being drawn into, either with the style GCs or with cairo
+ */
+typedef struct _GtkExperimentTranscriptCanvas {
+	GdkDrawable	*drawable;
+	cairo_t		*cr;		/**< Cairo context or \c NULL when drawing with GDK */
+	GdkRectangle	clip;		/**< Area drawing is clipped to */
+} GtkExperimentTranscriptCanvas;
+
+/** @private */
+#define PROFILE_BUCKETS		128
+
+/**
+ * @private
+ * Histogram of durations in microseconds.
+ * Buckets are logarithmic with four buckets per power of two (see
+ * \ref gtk_experiment_transcript_profile_record), so percentiles are
+ * accurate to 25%.
+ */
+typedef struct _GtkExperimentTranscriptHistogram {
+	guint	samples;
+	gint64	sum;
+	gint64	min;
+	gint64	max;
+	guint	buckets[PROFILE_BUCKETS];
+} GtkExperimentTranscriptHistogram;
+
 /**
  * @private
  * Private instance attribute structure.
@@ -59,17 +107,98 @@ struct _GtkExperimentTranscriptPrivate {
 	GtkObject	*time_adjustment;
 	gulong		time_adj_on_value_changed_id;
 
+	guint		scale;			/**< Milliseconds per pixel */
+	gint		line_height;		/**< Height of a line of text in pixels */
+	gint		char_width;		/**< Approximate width of a character in pixels */
+
 	GdkPixmap	*layer_text;
 	PangoLayout	*layer_text_layout;
+	gint64		layer_text_time;	/**< Time in milliseconds \e layer_text was rendered for */
+
+	/**
+	 * Throttling of text layer updates on time changes, so that
+	 * all changes between two frames are rendered at once
+	 */
+	struct _GtkExperimentTranscriptRedraw {
+		guint	rate;		/**< Maximum number of updates per second or 0 */
+		guint	timeout_id;	/**< Source Id of frame timeout or 0 */
+		gboolean dirty;		/**< Time changed since last update */
+
+		guint	performed;	/**< Number of updates rendered */
+		guint	skipped;	/**< Number of time changes coalesced into later updates */
+	} redraw;
+
+	/** Cairo sources of the colors in the current state, created on demand */
+	struct _GtkExperimentTranscriptPaints {
+		cairo_pattern_t	*sources[GTK_EXPERIMENT_TRANSCRIPT_N_PAINTS];
+	} paints;
+
+	/**
+	 * Profiling of text layer updates: the duration of each phase
+	 * is accumulated during an update and recorded at its end
+	 */
+	struct _GtkExperimentTranscriptProfile {
+		gboolean	enabled;
+		guint		depth;		/**< Nesting level of updates, 0 outside of updates */
+		GtkExperimentTranscriptPhase phase; /**< Current phase */
+		gint64		phase_start;	/**< Monotonic time the current phase started */
+		gint64		start;		/**< Monotonic time the update started */
+		gint64		elapsed[GTK_EXPERIMENT_TRANSCRIPT_N_PHASES]; /**< Durations in the current update */
+
+		GtkExperimentTranscriptHistogram *histograms; /**< Histogram by phase or \c NULL */
+		guint		counts[GTK_EXPERIMENT_TRANSCRIPT_N_COUNTS];
+		guint		dump_id;	/**< Source Id of periodic dump or 0 */
+	} profile;
 
 	struct _GtkExperimentTranscriptBackdropArea {
 		gint64	start;
 		gint64	end;
 	} backdrop;
 
-	GList		*contribs;
+	ExperimentReaderContribTable *contribs;
+	GCancellable	*load_cancellable;	/**< Cancels asynchronous load in flight */
 	GSList		*formats;
+	GtkExperimentTranscriptRuleSet *rules;	/**< \e formats compiled for single-pass matching */
 	GtkExperimentTranscriptFormat interactive_format;
+	guint		format_generation;	/**< Incremented whenever highlights change */
+
+	/**
+	 * Highlighting attributes of each contribution (indexed like
+	 * \e contribs), updated in chunks from an idle handler
+	 */
+	struct _GtkExperimentTranscriptHighlights {
+		guint		n_contribs;
+		PangoAttrList	**format_attribs;	/**< Attributes by format file rules or \c NULL */
+		PangoAttrList	**interactive_attribs;	/**< Attributes by interactive format rule or \c NULL */
+
+		guint		pending;	/**< Attribute lists to update (GtkExperimentTranscriptHighlightMask) */
+		guint		next;		/**< Next contribution to update */
+		guint		remaining;	/**< Number of contributions left to update */
+		guint		idle_id;	/**< Source Id of update idle handler or 0 */
+	} highlights;
+
+	/** LRU cache of laid-out contributions */
+	struct _GtkExperimentTranscriptLayoutCache {
+		GHashTable	*entries;	/**< Layouts by contribution, width, height clamp and format generation */
+		/** Logical heights of unclamped contributions by contribution index */
+		GHashTable	*heights;
+		GQueue		lru;		/**< Layouts, most recently used first */
+		gsize		size;		/**< Estimated size of all layouts in bytes */
+		gsize		max_size;	/**< Size limit in bytes */
+	} layouts;
+
+	/** Pre-rendered tiles of the text layer around the current time */
+	struct _GtkExperimentTranscriptTileCache {
+		GHashTable	*tiles;		/**< GdkPixmap tiles by index */
+		gint		width;		/**< Width tiles were rendered for */
+		guint		scale;		/**< Scale tiles were rendered for */
+		gboolean	reverse;	/**< Whether tiles were rendered in reverse mode */
+		guint		generation;	/**< Format generation tiles were rendered for */
+
+		gint64		current_time_px; /**< Time in pixels tiles were last drawn for */
+		gint		direction;	/**< Direction of last time change (-1 or 1) */
+		guint		idle_id;	/**< Source Id of pre-rendering idle handler or 0 */
+	} tiles;
 
 	GtkWidget	*menu;			/**< Drop-down menu, doesn't have to be unreferenced manually */
 	GSList		*alignment_group;	/**< GtkRadioMenuItem group for Alignment settings (owned by GTK) */
@@ -78,13 +207,43 @@ struct _GtkExperimentTranscriptPrivate {
 
 /** @private */
 typedef gboolean (*GtkExperimentTranscriptContribRenderer)
-		 (GtkExperimentTranscript *, ExperimentReaderContrib *,
-		  gint64, gint64, gint *);
+		 (GtkExperimentTranscript *, GtkExperimentTranscriptCanvas *,
+		  gint, guint,
+		  gint64, gint64, const GdkRectangle *, gint *);
+
+#define FORMAT_REGEX_COMPILE_FLAGS	(G_REGEX_CASELESS | G_REGEX_OPTIMIZE)
+#define FORMAT_REGEX_MATCH_FLAGS	(0)
+
+/** Default scale in milliseconds per pixel (about 15 pixels per second) */
+#define DEFAULT_SCALE		(1000/15)
+/** Minimum scale in milliseconds per pixel */
+#define MIN_SCALE		1
+/** Maximum scale in milliseconds per pixel (an hour per 60 pixels) */
+#define MAX_SCALE		(60*1000)
+
+/** Zooming changes the scale by 1/ZOOM_STEP */
+#define ZOOM_STEP		5
+
+#define TIME_TO_PX(TRANS, TIME)	((TIME)/(gint64)(TRANS)->priv->scale)
+#define PX_TO_TIME(TRANS, PX)	((PX)*(gint64)(TRANS)->priv->scale)
+
+/** Default maximum number of text layer updates per second */
+#define DEFAULT_REDRAW_RATE		60
+
+/** Height of pre-rendered text layer tiles in pixels */
+#define TILE_HEIGHT			256
+/** Number of tiles to pre-render beyond the visible ones */
+#define TILE_PRERENDER			2
 
-/** @todo scale should be configurable */
-#define PX_PER_SECOND		15
-#define TIME_TO_PX(TIME)	((TIME)/(1000/PX_PER_SECOND))
-#define PX_TO_TIME(PX)		(((PX)*1000)/PX_PER_SECOND)
+/**
+ * Environment variable enabling profiling of new widgets.
+ * Its value is the interval of dumping the profile in seconds
+ * (0 or empty to not dump it).
+ */
+#define PROFILE_ENV		"GTK_EXPERIMENT_TRANSCRIPT_PROFILE"
+
+/** Default size limit of the layout cache in bytes */
+#define DEFAULT_LAYOUT_CACHE_SIZE	(4*1024*1024)
 
 #define BACKDROP_VALUE \
 	((G_MAXUINT16*GTK_EXPERIMENT_TRANSCRIPT_BACKDROP)/100)
@@ -112,9 +271,9 @@ void gtk_experiment_transcript_text_layer_redraw(GtkExperimentTranscript *trans)
 
 /** @private */
 G_GNUC_INTERNAL
-void gtk_experiment_transcript_apply_format(GtkExperimentTranscriptFormat *fmt,
-					    const gchar *text,
-					    PangoAttrList *attrib_list);
+gboolean gtk_experiment_transcript_apply_format(GtkExperimentTranscriptFormat *fmt,
+						const gchar *text,
+						PangoAttrList *attrib_list);
 
 /** @private */
 static inline void
@@ -130,6 +289,182 @@ gtk_experiment_transcript_free_format(GtkExperimentTranscriptFormat *format)
 G_GNUC_INTERNAL
 void gtk_experiment_transcript_free_formats(GSList *formats);
 
+/** @private */
+G_GNUC_INTERNAL
+gboolean gtk_experiment_transcript_read_formats(const gchar *filename,
+						GSList **formats,
+						GError **error);
+
+/** @private */
+G_GNUC_INTERNAL
+GtkExperimentTranscriptRuleSet *gtk_experiment_transcript_rule_set_new(GSList *formats);
+
+/** @private */
+G_GNUC_INTERNAL
+gboolean gtk_experiment_transcript_rule_set_apply(GtkExperimentTranscriptRuleSet *set,
+						  const gchar *text,
+						  PangoAttrList *attrib_list);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_rule_set_free(GtkExperimentTranscriptRuleSet *set);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_reset_highlights(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_update_highlights(GtkExperimentTranscript *trans,
+						 GtkExperimentTranscriptHighlightMask mask);
+
+/** @private */
+G_GNUC_INTERNAL
+PangoAttrList *gtk_experiment_transcript_get_highlights(GtkExperimentTranscript *trans,
+							guint contrib);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_free_highlights(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_init_layouts(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+PangoLayout *gtk_experiment_transcript_get_layout(GtkExperimentTranscript *trans,
+						  guint contrib, gint height,
+						  gint *logical_height);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_flush_layouts(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_free_layouts(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_render_contribs(GtkExperimentTranscript *trans,
+					       GtkExperimentTranscriptCanvas *canvas,
+					       gint height,
+					       gint64 current_time,
+					       gint64 current_time_px,
+					       gint contrib,
+					       const GdkRectangle *area);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_canvas_begin(GtkExperimentTranscript *trans,
+					    GtkExperimentTranscriptCanvas *canvas,
+					    GdkDrawable *drawable,
+					    const GdkRectangle *clip);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_canvas_end(GtkExperimentTranscript *trans,
+					  GtkExperimentTranscriptCanvas *canvas);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_canvas_fill(GtkExperimentTranscript *trans,
+					   GtkExperimentTranscriptCanvas *canvas,
+					   GtkExperimentTranscriptPaint paint,
+					   const GdkRectangle *rect);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_canvas_draw_layout(GtkExperimentTranscript *trans,
+						  GtkExperimentTranscriptCanvas *canvas,
+						  gint x, gint y,
+						  PangoLayout *layout);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_flush_paints(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_init_profile(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_profile_begin(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_profile_end(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+GtkExperimentTranscriptPhase gtk_experiment_transcript_profile_switch(GtkExperimentTranscript *trans,
+								      GtkExperimentTranscriptPhase phase);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_profile_record(GtkExperimentTranscript *trans,
+					      GtkExperimentTranscriptPhase phase,
+					      gint64 duration);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_free_profile(GtkExperimentTranscript *trans);
+
+/**
+ * @private
+ * Enter a phase of the current update.
+ * Does nothing outside of updates, i.e. if profiling is disabled.
+ *
+ * @return Previous phase, to be passed to
+ *         \ref gtk_experiment_transcript_profile_leave
+ */
+static inline GtkExperimentTranscriptPhase
+gtk_experiment_transcript_profile_enter(GtkExperimentTranscript *trans,
+					GtkExperimentTranscriptPhase phase)
+{
+	if (!trans->priv->profile.depth)
+		return phase;
+
+	return gtk_experiment_transcript_profile_switch(trans, phase);
+}
+
+/** @private */
+static inline void
+gtk_experiment_transcript_profile_leave(GtkExperimentTranscript *trans,
+					GtkExperimentTranscriptPhase previous)
+{
+	gtk_experiment_transcript_profile_enter(trans, previous);
+}
+
+/** @private */
+static inline void
+gtk_experiment_transcript_profile_count(GtkExperimentTranscript *trans,
+					GtkExperimentTranscriptCount count)
+{
+	if (trans->priv->profile.enabled)
+		trans->priv->profile.counts[count]++;
+}
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_init_tiles(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+gboolean gtk_experiment_transcript_draw_tiles(GtkExperimentTranscript *trans,
+					      gint64 current_time_px,
+					      const GdkRectangle *area);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_flush_tiles(GtkExperimentTranscript *trans);
+
+/** @private */
+G_GNUC_INTERNAL
+void gtk_experiment_transcript_free_tiles(GtkExperimentTranscript *trans);
+
 /** @private */
 static inline gboolean
 is_newline(gchar c)
@@ -0,0 +1,438 @@
+/**
+ * @file
+ * Profiling of the \e GtkExperimentTranscript widget's text layer
+ * updates
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <gtk/gtk.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+
+static inline guint bucket_index(gint64 value);
+static inline gint64 bucket_max(guint index);
+static gint64 get_percentile(const GtkExperimentTranscriptHistogram *histogram,
+			     guint permille);
+static gboolean dump_timeout(gpointer user_data);
+
+/** @private */
+static const gchar *phase_names[GTK_EXPERIMENT_TRANSCRIPT_N_PHASES] = {
+	"lookup", "format", "layout", "draw", "redraw", "expose"
+};
+
+/** @private */
+static const gchar *count_names[GTK_EXPERIMENT_TRANSCRIPT_N_COUNTS] = {
+	"layouts", "layout-hits", "tiles", "tile-hits"
+};
+
+/**
+ * @private
+ * Get histogram bucket of a duration.
+ * Durations below 4 microseconds have their own buckets, larger ones
+ * are bucketed by their most significant bit and the two bits
+ * following it.
+ */
+static inline guint
+bucket_index(gint64 value)
+{
+	guint64 v = (guint64)MAX(value, 0);
+	guint msb;
+
+	if (v < 4)
+		return (guint)v;
+
+	msb = g_bit_storage(v) - 1;
+	return MIN(msb*4 + (guint)((v >> (msb - 2)) & 3) - 4,
+		   PROFILE_BUCKETS - 1);
+}
+
+/** @private Largest duration in a histogram bucket */
+static inline gint64
+bucket_max(guint index)
+{
+	guint msb = index/4 + 1;
+
+	if (index < 4)
+		return index;
+
+	return ((gint64)(4 + index%4 + 1) << (msb - 2)) - 1;
+}
+
+static gint64
+get_percentile(const GtkExperimentTranscriptHistogram *histogram,
+	       guint permille)
+{
+	guint rank = (guint)(((guint64)histogram->samples*permille + 999)/1000);
+	guint cumulated = 0;
+
+	for (guint i = 0; i < PROFILE_BUCKETS; i++) {
+		cumulated += histogram->buckets[i];
+		if (cumulated >= rank)
+			return CLAMP(bucket_max(i),
+				     histogram->min, histogram->max);
+	}
+
+	return histogram->max;
+}
+
+static gboolean
+dump_timeout(gpointer user_data)
+{
+	gtk_experiment_transcript_dump_profile(GTK_EXPERIMENT_TRANSCRIPT(user_data));
+
+	return TRUE;
+}
+
+/**
+ * @private
+ * Initialize profiling, enabling it if the \ref PROFILE_ENV environment
+ * variable is set.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_init_profile(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+	const gchar *env = g_getenv(PROFILE_ENV);
+
+	profile->enabled = FALSE;
+	profile->depth = 0;
+	profile->histograms = NULL;
+	profile->dump_id = 0;
+
+	if (env == NULL)
+		return;
+
+	gtk_experiment_transcript_set_profiling(trans, TRUE);
+	gtk_experiment_transcript_set_profile_dump_interval(trans,
+							    (guint)g_ascii_strtoull(env, NULL, 10));
+}
+
+/**
+ * @private
+ * Begin an update of the text layer.
+ * Updates may be nested, only the outermost one is recorded.
+ * The update starts in the \c GTK_EXPERIMENT_TRANSCRIPT_PHASE_DRAW phase.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_profile_begin(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+
+	if (!profile->enabled || profile->depth++)
+		return;
+
+	profile->start = profile->phase_start = g_get_monotonic_time();
+	profile->phase = GTK_EXPERIMENT_TRANSCRIPT_PHASE_DRAW;
+	memset(profile->elapsed, 0, sizeof(profile->elapsed));
+}
+
+/**
+ * @private
+ * End an update of the text layer, recording the durations of all
+ * phases (even if they did not occur) and of the update.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_profile_end(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+	gint64 now;
+
+	if (!profile->depth || --profile->depth)
+		return;
+
+	now = g_get_monotonic_time();
+	profile->elapsed[profile->phase] += now - profile->phase_start;
+
+	for (gint phase = 0; phase < GTK_EXPERIMENT_TRANSCRIPT_PHASE_REDRAW; phase++)
+		gtk_experiment_transcript_profile_record(trans, phase,
+							 profile->elapsed[phase]);
+	gtk_experiment_transcript_profile_record(trans,
+						 GTK_EXPERIMENT_TRANSCRIPT_PHASE_REDRAW,
+						 now - profile->start);
+}
+
+/**
+ * @private
+ * Switch to another phase of the current update, which must be active.
+ * Use \ref gtk_experiment_transcript_profile_enter instead.
+ */
+G_GNUC_INTERNAL GtkExperimentTranscriptPhase
+gtk_experiment_transcript_profile_switch(GtkExperimentTranscript *trans,
+					 GtkExperimentTranscriptPhase phase)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+	GtkExperimentTranscriptPhase previous = profile->phase;
+	gint64 now;
+
+	if (phase == previous)
+		return previous;
+
+	now = g_get_monotonic_time();
+	profile->elapsed[previous] += now - profile->phase_start;
+	profile->phase = phase;
+	profile->phase_start = now;
+
+	return previous;
+}
+
+/**
+ * @private
+ * Add a duration in microseconds to a phase's histogram.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_profile_record(GtkExperimentTranscript *trans,
+					 GtkExperimentTranscriptPhase phase,
+					 gint64 duration)
+{
+	GtkExperimentTranscriptHistogram *histogram;
+
+	if (!trans->priv->profile.enabled)
+		return;
+	histogram = &trans->priv->profile.histograms[phase];
+
+	if (!histogram->samples || duration < histogram->min)
+		histogram->min = duration;
+	if (!histogram->samples || duration > histogram->max)
+		histogram->max = duration;
+	histogram->samples++;
+	histogram->sum += duration;
+	histogram->buckets[bucket_index(duration)]++;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_free_profile(GtkExperimentTranscript *trans)
+{
+	gtk_experiment_transcript_set_profile_dump_interval(trans, 0);
+	gtk_experiment_transcript_set_profiling(trans, FALSE);
+}
+
+/*
+ * API
+ */
+
+/**
+ * @brief Enable or disable profiling of a transcript widget
+ *
+ * When enabled, the durations of all phases of updating the widget's
+ * contents (see \ref GtkExperimentTranscriptPhase) are recorded for
+ * every update, e.g. whenever the time changes.
+ * Tile pre-rendering and highlighting in the background are not timed
+ * but their cache hits are counted.
+ * Profiling is disabled by default, unless the environment variable
+ * \c GTK_EXPERIMENT_TRANSCRIPT_PROFILE is set when the widget is created.
+ * Disabling profiling discards all recorded data.
+ *
+ * @sa gtk_experiment_transcript_get_timings
+ * @sa gtk_experiment_transcript_get_count
+ *
+ * @param trans  Widget instance
+ * @param enable Whether to enable (\c TRUE) or disable (\c FALSE) profiling
+ */
+void
+gtk_experiment_transcript_set_profiling(GtkExperimentTranscript *trans,
+					gboolean enable)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+
+	if (!profile->enabled == !enable)
+		return;
+
+	profile->enabled = enable;
+	profile->depth = 0;
+
+	if (enable) {
+		profile->histograms = g_new(GtkExperimentTranscriptHistogram,
+					    GTK_EXPERIMENT_TRANSCRIPT_N_PHASES);
+		gtk_experiment_transcript_reset_profile(trans);
+	} else {
+		g_free(profile->histograms);
+		profile->histograms = NULL;
+	}
+}
+
+/**
+ * @brief Get whether profiling of a transcript widget is enabled
+ *
+ * @sa gtk_experiment_transcript_set_profiling
+ *
+ * @param trans Widget instance
+ * @return \c TRUE if profiling is enabled, else \c FALSE
+ */
+gboolean
+gtk_experiment_transcript_get_profiling(GtkExperimentTranscript *trans)
+{
+	return trans->priv->profile.enabled;
+}
+
+/**
+ * @brief Periodically dump a transcript widget's profile
+ *
+ * While profiling is enabled, the profile is logged every \e seconds
+ * seconds (see \ref gtk_experiment_transcript_dump_profile).
+ * It is not reset after dumping it.
+ * If the \c GTK_EXPERIMENT_TRANSCRIPT_PROFILE environment variable is set,
+ * its value is used as the interval.
+ *
+ * @param trans   Widget instance
+ * @param seconds Interval in seconds or 0 to stop dumping the profile
+ */
+void
+gtk_experiment_transcript_set_profile_dump_interval(GtkExperimentTranscript *trans,
+						    guint seconds)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+
+	if (profile->dump_id) {
+		g_source_remove(profile->dump_id);
+		profile->dump_id = 0;
+	}
+
+	if (seconds)
+		profile->dump_id = gdk_threads_add_timeout_seconds(seconds,
+								   dump_timeout,
+								   trans);
+}
+
+/**
+ * @brief Get distribution of the durations of a phase
+ *
+ * Every update of the widget's contents is one sample of each phase
+ * (except \c GTK_EXPERIMENT_TRANSCRIPT_PHASE_EXPOSE, which is sampled
+ * whenever the widget is exposed).
+ * The durations of the phases of an update are exclusive, i.e. they
+ * add up to the duration of the update.
+ *
+ * @param trans   Widget instance
+ * @param phase   Phase to query
+ * @param timings Location to store the distribution in
+ * @return \c TRUE if there are samples of the phase, \c FALSE if there
+ *         are none or profiling is disabled
+ */
+gboolean
+gtk_experiment_transcript_get_timings(GtkExperimentTranscript *trans,
+				      GtkExperimentTranscriptPhase phase,
+				      GtkExperimentTranscriptTimings *timings)
+{
+	const GtkExperimentTranscriptHistogram *histogram;
+
+	g_return_val_if_fail(phase < GTK_EXPERIMENT_TRANSCRIPT_N_PHASES, FALSE);
+
+	if (!trans->priv->profile.enabled)
+		return FALSE;
+	histogram = &trans->priv->profile.histograms[phase];
+	if (!histogram->samples)
+		return FALSE;
+
+	timings->samples = histogram->samples;
+	timings->min = histogram->min;
+	timings->max = histogram->max;
+	timings->mean = (gdouble)histogram->sum/histogram->samples;
+	timings->p95 = get_percentile(histogram, 950);
+	timings->p99 = get_percentile(histogram, 990);
+
+	return TRUE;
+}
+
+/**
+ * @brief Get number of profiled events
+ *
+ * @sa gtk_experiment_transcript_set_profiling
+ *
+ * @param trans Widget instance
+ * @param count Event to query
+ * @return Number of events since profiling was enabled or reset
+ */
+guint
+gtk_experiment_transcript_get_count(GtkExperimentTranscript *trans,
+				    GtkExperimentTranscriptCount count)
+{
+	g_return_val_if_fail(count < GTK_EXPERIMENT_TRANSCRIPT_N_COUNTS, 0);
+
+	return trans->priv->profile.enabled ? trans->priv->profile.counts[count]
+					    : 0;
+}
+
+/**
+ * @brief Discard all recorded timings and counts
+ *
+ * @param trans Widget instance
+ */
+void
+gtk_experiment_transcript_reset_profile(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptProfile *profile = &trans->priv->profile;
+
+	memset(profile->counts, 0, sizeof(profile->counts));
+	if (profile->histograms != NULL)
+		memset(profile->histograms, 0,
+		       GTK_EXPERIMENT_TRANSCRIPT_N_PHASES*sizeof(GtkExperimentTranscriptHistogram));
+}
+
+/**
+ * @brief Log a transcript widget's profile
+ *
+ * Logs one message per phase with its distribution and one message
+ * with all counts, if profiling is enabled.
+ *
+ * @param trans Widget instance
+ */
+void
+gtk_experiment_transcript_dump_profile(GtkExperimentTranscript *trans)
+{
+	GString *counts;
+
+	if (!trans->priv->profile.enabled)
+		return;
+
+	for (gint phase = 0; phase < GTK_EXPERIMENT_TRANSCRIPT_N_PHASES; phase++) {
+		GtkExperimentTranscriptTimings timings;
+
+		if (!gtk_experiment_transcript_get_timings(trans, phase, &timings))
+			continue;
+
+		g_message("%s: %s: %u samples, "
+			  "min %" G_GINT64_FORMAT " us, mean %.1f us, "
+			  "p95 %" G_GINT64_FORMAT " us, p99 %" G_GINT64_FORMAT " us, "
+			  "max %" G_GINT64_FORMAT " us",
+			  trans->speaker != NULL ? trans->speaker : "transcript",
+			  phase_names[phase], timings.samples,
+			  timings.min, timings.mean,
+			  timings.p95, timings.p99, timings.max);
+	}
+
+	counts = g_string_new(NULL);
+	for (gint count = 0; count < GTK_EXPERIMENT_TRANSCRIPT_N_COUNTS; count++)
+		g_string_append_printf(counts, "%s%s %u",
+					count ? ", " : "", count_names[count],
+					trans->priv->profile.counts[count]);
+	g_message("%s: %s",
+		  trans->speaker != NULL ? trans->speaker : "transcript",
+		  counts->str);
+	g_string_free(counts, TRUE);
+}
@@ -0,0 +1,440 @@
+/**
+ * @file
+ * Compiled format rule sets of the \e GtkExperimentTranscript widget,
+ * matching all rules of a format file in a single pass
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <gtk/gtk.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+
+/** Size of the automaton's alphabet, literals consist of ASCII characters */
+#define ALPHABET_SIZE	128
+
+/**
+ * @private
+ * Literal rule occurrence found by the automaton
+ */
+typedef struct _RuleOccurrence {
+	guint	rule;	/**< Rule index */
+	gint	start;	/**< Byte offset of occurrence */
+} RuleOccurrence;
+
+/**
+ * @private
+ * A format file's rules, compiled for matching them in a single pass.
+ *
+ * Rules whose patterns are plain ASCII literals (the common case of
+ * keyword rules) are matched case-insensitively by an Aho-Corasick
+ * automaton, finding all occurrences of all literals in one scan.
+ * The remaining (regular expression) rules are combined into a single
+ * alternation, so texts matched by none of them are rejected in one
+ * scan, too. Only if it matches, they are applied one by one.
+ */
+struct _GtkExperimentTranscriptRuleSet {
+	guint		n_rules;
+	GtkExperimentTranscriptFormat **rules;	/**< Rules in order of application (not owned) */
+	gint		*literal_length;	/**< Literal length per rule, 0 for regular expression rules */
+	gint		*rule_next;		/**< Next rule with the same literal or -1 */
+
+	gint		*next_state;		/**< Automaton transitions (states x \ref ALPHABET_SIZE) */
+	gint		*state_rule;		/**< First rule whose literal ends in state or -1 */
+	gint		*dict_suffix;		/**< Nearest suffix state with rules or 0 */
+
+	gboolean	have_regexps;		/**< Whether there are regular expression rules */
+	GRegex		*prefilter;		/**< Alternation of all regular expression rules or \c NULL */
+
+	gint		*last_end;		/**< Scratch: end of last occurrence per rule */
+	GArray		*occurrences;		/**< Scratch: RuleOccurrence array */
+};
+
+static gint get_literal_length(const gchar *pattern);
+static gint add_state(GArray *next_state, GArray *state_rule);
+static void build_automaton(GtkExperimentTranscriptRuleSet *set,
+			    GArray *next_state, GArray *state_rule);
+static gint occurrence_cmp(gconstpointer a, gconstpointer b);
+static void find_occurrences(GtkExperimentTranscriptRuleSet *set,
+			     const gchar *text);
+static gboolean apply_literal(GtkExperimentTranscriptFormat *fmt,
+			      gint start, gint length,
+			      PangoAttrList *attrib_list);
+
+/**
+ * @private
+ * Get length of literal matched by a rule's regular expression, which
+ * consists of one capture for every formatted part of the rule.
+ *
+ * @param pattern Regular expression
+ * @return Length of literal without captures or 0 if \e pattern
+ *         is not a plain ASCII literal
+ */
+static gint
+get_literal_length(const gchar *pattern)
+{
+	gint length = 0;
+
+	for (const gchar *p = pattern; *p; p++) {
+		if (*p == '(' || *p == ')')
+			continue;
+		if (!g_ascii_isprint(*p) || strchr("\\^$.|?*+[]{}", *p) != NULL)
+			return 0;
+
+		length++;
+	}
+
+	return length;
+}
+
+static gint
+add_state(GArray *next_state, GArray *state_rule)
+{
+	gint state = state_rule->len;
+	gint none = -1;
+
+	g_array_set_size(next_state, next_state->len + ALPHABET_SIZE);
+	for (gint c = 0; c < ALPHABET_SIZE; c++)
+		g_array_index(next_state, gint, state*ALPHABET_SIZE + c) = -1;
+	g_array_append_val(state_rule, none);
+
+	return state;
+}
+
+/**
+ * @private
+ * Turn trie of literals into a deterministic automaton by following
+ * failure links breadth-first.
+ */
+static void
+build_automaton(GtkExperimentTranscriptRuleSet *set,
+		GArray *next_state, GArray *state_rule)
+{
+	guint n_states = state_rule->len;
+	gint *next, *fail;
+	GQueue queue = G_QUEUE_INIT;
+
+	set->state_rule = (gint *)g_array_free(state_rule, FALSE);
+	set->next_state = next = (gint *)g_array_free(next_state, FALSE);
+	set->dict_suffix = g_new0(gint, n_states);
+	fail = g_new0(gint, n_states);
+
+	for (gint c = 0; c < ALPHABET_SIZE; c++) {
+		gint s = next[c];
+
+		if (s < 0)
+			next[c] = 0;
+		else
+			g_queue_push_tail(&queue, GINT_TO_POINTER(s));
+	}
+
+	while (!g_queue_is_empty(&queue)) {
+		gint r = GPOINTER_TO_INT(g_queue_pop_head(&queue));
+
+		for (gint c = 0; c < ALPHABET_SIZE; c++) {
+			gint s = next[r*ALPHABET_SIZE + c];
+
+			if (s < 0) {
+				next[r*ALPHABET_SIZE + c] =
+					next[fail[r]*ALPHABET_SIZE + c];
+				continue;
+			}
+
+			fail[s] = next[fail[r]*ALPHABET_SIZE + c];
+			set->dict_suffix[s] = set->state_rule[fail[s]] >= 0
+						? fail[s]
+						: set->dict_suffix[fail[s]];
+			g_queue_push_tail(&queue, GINT_TO_POINTER(s));
+		}
+	}
+
+	g_free(fail);
+}
+
+static gint
+occurrence_cmp(gconstpointer a, gconstpointer b)
+{
+	const RuleOccurrence *oa = a;
+	const RuleOccurrence *ob = b;
+
+	if (oa->rule != ob->rule)
+		return oa->rule < ob->rule ? -1 : 1;
+
+	return oa->start - ob->start;
+}
+
+/**
+ * @private
+ * Find occurrences of all literal rules in \e text.
+ * Like successive regular expression matches, occurrences of the same
+ * rule do not overlap. They are sorted by rule, then by offset.
+ */
+static void
+find_occurrences(GtkExperimentTranscriptRuleSet *set, const gchar *text)
+{
+	gint state = 0;
+
+	g_array_set_size(set->occurrences, 0);
+	for (guint r = 0; r < set->n_rules; r++)
+		set->last_end[r] = 0;
+
+	for (gint i = 0; text[i]; i++) {
+		guchar c = (guchar)text[i];
+
+		/* non-ASCII bytes are not part of any literal */
+		state = c < ALPHABET_SIZE
+			? set->next_state[state*ALPHABET_SIZE + g_ascii_tolower(c)]
+			: 0;
+
+		for (gint t = set->state_rule[state] >= 0
+					? state : set->dict_suffix[state];
+		     t > 0;
+		     t = set->dict_suffix[t]) {
+			for (gint r = set->state_rule[t]; r >= 0; r = set->rule_next[r]) {
+				RuleOccurrence occ;
+
+				occ.rule = (guint)r;
+				occ.start = i + 1 - set->literal_length[r];
+				if (occ.start < set->last_end[r])
+					continue;
+
+				g_array_append_val(set->occurrences, occ);
+				set->last_end[r] = i + 1;
+			}
+		}
+	}
+
+	g_array_sort(set->occurrences, occurrence_cmp);
+}
+
+/**
+ * @private
+ * Add attributes of a literal rule to one of its occurrences.
+ * Corresponds to \ref gtk_experiment_transcript_apply_format for
+ * one match, with the captures at fixed offsets.
+ */
+static gboolean
+apply_literal(GtkExperimentTranscriptFormat *fmt, gint start, gint length,
+	      PangoAttrList *attrib_list)
+{
+	PangoAttrIterator *iter;
+	gboolean changed = FALSE;
+
+	iter = pango_attr_list_get_iterator(fmt->attribs);
+	do {
+		gint seg_start, seg_end;
+		GSList *attribs;
+
+		pango_attr_iterator_range(iter, &seg_start, &seg_end);
+		if (seg_end == G_MAXINT)
+			seg_end = length;
+
+		if (seg_end - seg_start == 0)
+			continue;
+
+		attribs = pango_attr_iterator_get_attrs(iter);
+		for (GSList *cur = attribs; cur != NULL; cur = cur->next) {
+			PangoAttribute *attrib;
+
+			attrib = pango_attribute_copy((PangoAttribute *)cur->data);
+			attrib->start_index = (guint)(start + seg_start);
+			attrib->end_index = (guint)(start + seg_end);
+			pango_attr_list_change(attrib_list, attrib);
+			changed = TRUE;
+		}
+		g_slist_free(attribs);
+	} while (pango_attr_iterator_next(iter));
+	pango_attr_iterator_destroy(iter);
+
+	return changed;
+}
+
+/**
+ * @private
+ * Compile rule set from a list of formats.
+ *
+ * @param formats List of \e GtkExperimentTranscriptFormat, which must
+ *                not be freed before the rule set
+ * @return New rule set
+ */
+G_GNUC_INTERNAL GtkExperimentTranscriptRuleSet *
+gtk_experiment_transcript_rule_set_new(GSList *formats)
+{
+	GtkExperimentTranscriptRuleSet *set;
+	GArray *next_state, *state_rule;
+	GString *alternation;
+	guint i = 0;
+
+	set = g_new0(GtkExperimentTranscriptRuleSet, 1);
+	set->n_rules = g_slist_length(formats);
+	set->rules = g_new(GtkExperimentTranscriptFormat *, set->n_rules);
+	set->literal_length = g_new0(gint, set->n_rules);
+	set->rule_next = g_new(gint, set->n_rules);
+	set->last_end = g_new(gint, set->n_rules);
+	set->occurrences = g_array_new(FALSE, FALSE, sizeof(RuleOccurrence));
+
+	next_state = g_array_new(FALSE, FALSE, sizeof(gint));
+	state_rule = g_array_new(FALSE, FALSE, sizeof(gint));
+	add_state(next_state, state_rule);
+
+	alternation = g_string_new(NULL);
+
+	for (GSList *cur = formats; cur != NULL; cur = cur->next, i++) {
+		GtkExperimentTranscriptFormat *fmt =
+				(GtkExperimentTranscriptFormat *)cur->data;
+		const gchar *pattern;
+		gint state = 0;
+
+		set->rules[i] = fmt;
+		set->rule_next[i] = -1;
+
+		if (fmt->regexp == NULL || fmt->attribs == NULL)
+			continue;
+		pattern = g_regex_get_pattern(fmt->regexp);
+
+		set->literal_length[i] = get_literal_length(pattern);
+		if (!set->literal_length[i]) {
+			if (alternation->len)
+				g_string_append_c(alternation, '|');
+			g_string_append_printf(alternation, "(?:%s)", pattern);
+			set->have_regexps = TRUE;
+			continue;
+		}
+
+		for (const gchar *p = pattern; *p; p++) {
+			gint c = g_ascii_tolower(*p);
+			gint *next;
+
+			if (*p == '(' || *p == ')')
+				continue;
+
+			next = &g_array_index(next_state, gint,
+					      state*ALPHABET_SIZE + c);
+			if (*next < 0) {
+				gint s = add_state(next_state, state_rule);
+
+				/* array may have been reallocated */
+				g_array_index(next_state, gint,
+					      state*ALPHABET_SIZE + c) = s;
+				state = s;
+			} else {
+				state = *next;
+			}
+		}
+
+		set->rule_next[i] = g_array_index(state_rule, gint, state);
+		g_array_index(state_rule, gint, state) = (gint)i;
+	}
+
+	build_automaton(set, next_state, state_rule);
+
+	/*
+	 * the rules' captures are not needed for filtering;
+	 * if the alternation cannot be compiled (e.g. because of
+	 * back references), the rules are always applied
+	 */
+	if (set->have_regexps)
+		set->prefilter = g_regex_new(alternation->str,
+					     FORMAT_REGEX_COMPILE_FLAGS |
+					     G_REGEX_NO_AUTO_CAPTURE,
+					     0, NULL);
+	g_string_free(alternation, TRUE);
+
+	return set;
+}
+
+/**
+ * @private
+ * Add attributes of all rules of a rule set to the spans of \e text
+ * they match.
+ * The result is the same as applying each rule in order with
+ * \ref gtk_experiment_transcript_apply_format, except that ASCII
+ * literals are matched by folding ASCII case only.
+ *
+ * @param set         Rule set
+ * @param text        Text to match
+ * @param attrib_list Attribute list to add attributes to
+ * @return \c TRUE if any attribute was added, else \c FALSE
+ */
+G_GNUC_INTERNAL gboolean
+gtk_experiment_transcript_rule_set_apply(GtkExperimentTranscriptRuleSet *set,
+					 const gchar *text,
+					 PangoAttrList *attrib_list)
+{
+	RuleOccurrence *occ;
+	guint n_occ;
+	gboolean match_regexps;
+	gboolean changed = FALSE;
+
+	find_occurrences(set, text);
+	occ = (RuleOccurrence *)set->occurrences->data;
+	n_occ = set->occurrences->len;
+
+	match_regexps = set->have_regexps &&
+			(set->prefilter == NULL ||
+			 g_regex_match(set->prefilter, text,
+				       FORMAT_REGEX_MATCH_FLAGS, NULL));
+
+	if (!n_occ && !match_regexps)
+		return FALSE;
+
+	for (guint r = 0, o = 0; r < set->n_rules; r++) {
+		if (set->literal_length[r]) {
+			for (; o < n_occ && occ[o].rule == r; o++)
+				changed |= apply_literal(set->rules[r],
+							 occ[o].start,
+							 set->literal_length[r],
+							 attrib_list);
+		} else if (match_regexps) {
+			changed |= gtk_experiment_transcript_apply_format(set->rules[r],
+									  text,
+									  attrib_list);
+		}
+	}
+
+	return changed;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_rule_set_free(GtkExperimentTranscriptRuleSet *set)
+{
+	if (set == NULL)
+		return;
+
+	g_free(set->rules);
+	g_free(set->literal_length);
+	g_free(set->rule_next);
+	g_free(set->next_state);
+	g_free(set->state_rule);
+	g_free(set->dict_suffix);
+	if (set->prefilter != NULL)
+		g_regex_unref(set->prefilter);
+	g_free(set->last_end);
+	g_array_free(set->occurrences, TRUE);
+	g_free(set);
+}
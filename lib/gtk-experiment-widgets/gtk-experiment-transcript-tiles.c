@@ -0,0 +1,383 @@
+/**
+ * @file
+ * Cache of pre-rendered tiles of the \e GtkExperimentTranscript widget's
+ * text layer
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The transcript is a vertical strip, mapping time to pixels.
+ * It is divided into tiles of TILE_HEIGHT pixels, tile i covering
+ * the strip positions [i*TILE_HEIGHT, (i+1)*TILE_HEIGHT).
+ * In reverse mode, tiles are flipped, i.e. a tile's first row is the
+ * latest position it covers.
+ *
+ * Tiles contain all contributions, each clamped by the one following it,
+ * no matter whether it has already started. Since contributions that
+ * have not started are always outside the widget, tiles are independent
+ * of the current time, except for the latest contribution and the
+ * backdrop area, which are rendered on top of them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include <gdk/gdk.h>
+#include <gtk/gtk.h>
+
+#include <experiment-reader.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+
+static inline gint floor_div(gint64 a, gint b);
+static void get_tile_range(GtkExperimentTranscript *trans,
+			   gint64 current_time_px, const GdkRectangle *area,
+			   gint *first, gint *last);
+static void validate_tiles(GtkExperimentTranscript *trans);
+static GdkPixmap *render_tile(GtkExperimentTranscript *trans, gint index);
+static GdkPixmap *get_tile(GtkExperimentTranscript *trans, gint index);
+static void trim_tiles(GtkExperimentTranscript *trans);
+static gboolean prerender_tiles_idle(gpointer user_data);
+
+/** @private */
+static inline gint
+floor_div(gint64 a, gint b)
+{
+	return (gint)(a >= 0 ? a/b : -((-a + b - 1)/b));
+}
+
+/**
+ * @private
+ * Get indices of the tiles covering an area of the text layer.
+ */
+static void
+get_tile_range(GtkExperimentTranscript *trans, gint64 current_time_px,
+	       const GdkRectangle *area, gint *first, gint *last)
+{
+	gint64 top, bottom;
+
+	if (gtk_experiment_transcript_get_reverse_mode(trans)) {
+		/* strip position of a row is (current_time_px - y) */
+		top = current_time_px - area->y;
+		bottom = top - area->height + 1;
+
+		*first = floor_div(bottom - 1, TILE_HEIGHT);
+		*last = floor_div(top - 1, TILE_HEIGHT);
+	} else {
+		/* strip position of a row is (current_time_px - height + y) */
+		top = current_time_px -
+		      GTK_WIDGET(trans)->allocation.height + area->y;
+		bottom = top + area->height - 1;
+
+		*first = floor_div(top, TILE_HEIGHT);
+		*last = floor_div(bottom, TILE_HEIGHT);
+	}
+}
+
+/**
+ * @private
+ * Discard tiles rendered for a different width, scale, mode or formats.
+ */
+static void
+validate_tiles(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+	gint width = GTK_WIDGET(trans)->allocation.width;
+	gboolean reverse = gtk_experiment_transcript_get_reverse_mode(trans);
+
+	if (cache->width == width && cache->scale == trans->priv->scale &&
+	    cache->reverse == reverse &&
+	    cache->generation == trans->priv->format_generation)
+		return;
+
+	gtk_experiment_transcript_flush_tiles(trans);
+	cache->width = width;
+	cache->scale = trans->priv->scale;
+	cache->reverse = reverse;
+	cache->generation = trans->priv->format_generation;
+}
+
+static GdkPixmap *
+render_tile(GtkExperimentTranscript *trans, gint index)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+	ExperimentReaderContribTable *contribs = trans->priv->contribs;
+
+	GdkPixmap *tile;
+	GtkExperimentTranscriptCanvas canvas;
+	GtkExperimentTranscriptPhase phase;
+	GdkRectangle area = {0, 0, widget->allocation.width, TILE_HEIGHT};
+	gint64 end_px = ((gint64)index + 1)*TILE_HEIGHT;
+	gint i;
+
+	tile = gdk_pixmap_new(gtk_widget_get_window(widget),
+			      area.width, area.height, -1);
+	gtk_experiment_transcript_canvas_begin(trans, &canvas,
+					       GDK_DRAWABLE(tile), &area);
+	gtk_experiment_transcript_canvas_fill(trans, &canvas,
+					      GTK_EXPERIMENT_TRANSCRIPT_PAINT_BG,
+					      &area);
+
+	if (contribs == NULL || !contribs->n_contribs) {
+		gtk_experiment_transcript_canvas_end(trans, &canvas);
+		return tile;
+	}
+
+	/*
+	 * Start with the first contribution after the tile.
+	 * It is not drawn, but clamps the last one in the tile.
+	 */
+	phase = gtk_experiment_transcript_profile_enter(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_PHASE_LOOKUP);
+	i = experiment_reader_contrib_table_lookup(contribs, PX_TO_TIME(trans, end_px));
+	while ((guint)i < contribs->n_contribs &&
+	       TIME_TO_PX(trans, experiment_reader_contrib_table_get_start_time(contribs, i)) <= end_px)
+		i++;
+	while (i > 0 &&
+	       TIME_TO_PX(trans, experiment_reader_contrib_table_get_start_time(contribs, i - 1)) > end_px)
+		i--;
+	gtk_experiment_transcript_profile_leave(trans, phase);
+
+	gtk_experiment_transcript_render_contribs(trans, &canvas,
+						  area.height, G_MAXINT64, end_px,
+						  MIN(i, (gint)contribs->n_contribs - 1),
+						  &area);
+	gtk_experiment_transcript_canvas_end(trans, &canvas);
+
+	return tile;
+}
+
+static GdkPixmap *
+get_tile(GtkExperimentTranscript *trans, gint index)
+{
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+	GdkPixmap *tile;
+
+	tile = g_hash_table_lookup(cache->tiles, GINT_TO_POINTER(index));
+	if (tile == NULL) {
+		tile = render_tile(trans, index);
+		g_hash_table_insert(cache->tiles, GINT_TO_POINTER(index), tile);
+		gtk_experiment_transcript_profile_count(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_COUNT_TILES);
+	} else {
+		gtk_experiment_transcript_profile_count(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_COUNT_TILE_HITS);
+	}
+
+	return tile;
+}
+
+/**
+ * @private
+ * Evict the tiles farthest from the visible ones, until there are
+ * only enough tiles left to cover the widget and to pre-render
+ * \ref TILE_PRERENDER tiles in either direction.
+ */
+static void
+trim_tiles(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+	GdkRectangle area = {
+		0, 0,
+		GTK_WIDGET(trans)->allocation.width,
+		GTK_WIDGET(trans)->allocation.height
+	};
+	gint first, last;
+	guint max_tiles;
+
+	get_tile_range(trans, cache->current_time_px, &area, &first, &last);
+	max_tiles = (guint)(last - first + 1) + 2*TILE_PRERENDER;
+
+	while (g_hash_table_size(cache->tiles) > max_tiles) {
+		GHashTableIter iter;
+		gpointer key;
+		gint farthest = first, max_distance = -1;
+
+		g_hash_table_iter_init(&iter, cache->tiles);
+		while (g_hash_table_iter_next(&iter, &key, NULL)) {
+			gint index = GPOINTER_TO_INT(key);
+			gint distance = index < first ? first - index
+						      : index - last;
+
+			if (distance > max_distance) {
+				farthest = index;
+				max_distance = distance;
+			}
+		}
+
+		g_hash_table_remove(cache->tiles, GINT_TO_POINTER(farthest));
+	}
+}
+
+/**
+ * @private
+ * Render the next missing tile in playback direction beyond the visible
+ * ones, so that scrolling does not have to render it.
+ */
+static gboolean
+prerender_tiles_idle(gpointer user_data)
+{
+	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(user_data);
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+	GdkRectangle area = {
+		0, 0,
+		GTK_WIDGET(trans)->allocation.width,
+		GTK_WIDGET(trans)->allocation.height
+	};
+	gint first, last;
+
+	if (!gtk_widget_get_realized(GTK_WIDGET(trans)) ||
+	    trans->priv->contribs == NULL)
+		goto stop;
+
+	validate_tiles(trans);
+	get_tile_range(trans, cache->current_time_px, &area, &first, &last);
+
+	for (gint i = 1; i <= TILE_PRERENDER; i++) {
+		gint index = cache->direction < 0 ? first - i : last + i;
+
+		if (g_hash_table_lookup(cache->tiles,
+					GINT_TO_POINTER(index)) == NULL) {
+			get_tile(trans, index);
+			trim_tiles(trans);
+			return TRUE;
+		}
+	}
+
+stop:
+	cache->idle_id = 0;
+	return FALSE;
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_init_tiles(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+
+	cache->tiles = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+					     NULL, g_object_unref);
+	cache->width = 0;
+	cache->scale = 0;
+	cache->reverse = FALSE;
+	cache->generation = 0;
+	cache->current_time_px = 0;
+	cache->direction = 0;
+	cache->idle_id = 0;
+}
+
+/**
+ * @private
+ * Draw tiles into part of the text layer.
+ *
+ * Missing tiles are rendered. Afterwards, the tiles following in
+ * playback direction (derived from the last time change) are
+ * pre-rendered in an idle handler.
+ *
+ * @param trans           Widget instance
+ * @param current_time_px Current time in pixels
+ * @param area            Area of the text layer to draw
+ * @return \c FALSE if tiles cannot be drawn (yet), else \c TRUE
+ */
+G_GNUC_INTERNAL gboolean
+gtk_experiment_transcript_draw_tiles(GtkExperimentTranscript *trans,
+				     gint64 current_time_px,
+				     const GdkRectangle *area)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+
+	gboolean reverse = gtk_experiment_transcript_get_reverse_mode(trans);
+	gint first, last;
+
+	if (!gtk_widget_get_realized(widget) ||
+	    trans->priv->layer_text == NULL || cache->tiles == NULL ||
+	    widget->allocation.width <= 0)
+		return FALSE;
+
+	validate_tiles(trans);
+
+	if (current_time_px != cache->current_time_px)
+		cache->direction = current_time_px > cache->current_time_px
+					? 1 : -1;
+	cache->current_time_px = current_time_px;
+
+	get_tile_range(trans, current_time_px, area, &first, &last);
+
+	for (gint index = first; index <= last; index++) {
+		/* position of the tile's first row */
+		gint y = reverse
+			? (gint)(current_time_px - ((gint64)index + 1)*TILE_HEIGHT)
+			: (gint)(widget->allocation.height - current_time_px +
+				 (gint64)index*TILE_HEIGHT);
+		GdkRectangle rect = {0, y, widget->allocation.width, TILE_HEIGHT};
+
+		if (!gdk_rectangle_intersect((GdkRectangle *)area,
+					     &rect, &rect))
+			continue;
+
+		gdk_draw_drawable(GDK_DRAWABLE(trans->priv->layer_text),
+				  widget->style->bg_gc[gtk_widget_get_state(widget)],
+				  GDK_DRAWABLE(get_tile(trans, index)),
+				  rect.x, rect.y - y,
+				  rect.x, rect.y, rect.width, rect.height);
+	}
+
+	trim_tiles(trans);
+
+	if (!cache->idle_id)
+		cache->idle_id = gdk_threads_add_idle(prerender_tiles_idle,
+						      trans);
+
+	return TRUE;
+}
+
+/**
+ * @private
+ * Discard all tiles, e.g. because the contributions, the font, colors
+ * or the alignment changed.
+ * Changes of the width, scale, reverse mode and highlights are detected
+ * automatically.
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_flush_tiles(GtkExperimentTranscript *trans)
+{
+	if (trans->priv->tiles.tiles != NULL)
+		g_hash_table_remove_all(trans->priv->tiles.tiles);
+}
+
+/** @private */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_free_tiles(GtkExperimentTranscript *trans)
+{
+	struct _GtkExperimentTranscriptTileCache *cache = &trans->priv->tiles;
+
+	if (cache->idle_id) {
+		g_source_remove(cache->idle_id);
+		cache->idle_id = 0;
+	}
+	if (cache->tiles != NULL) {
+		g_hash_table_destroy(cache->tiles);
+		cache->tiles = NULL;
+	}
+}
@@ -29,6 +29,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
 
 #include <gdk/gdk.h>
 #include <gtk/gtk.h>
@@ -51,26 +52,56 @@ static void gtk_experiment_transcript_dispose(GObject *gobject);
 static void gtk_experiment_transcript_finalize(GObject *gobject);
 
 static void time_adj_on_value_changed(GtkAdjustment *adj, gpointer user_data);
+static gboolean redraw_timeout(gpointer user_data);
+static void load_filename_ready_cb(GObject *source, GAsyncResult *result,
+				   gpointer user_data);
 
 static void gtk_experiment_transcript_reconfigure(GtkExperimentTranscript *trans);
 
-static gboolean configure_text_layout(GtkExperimentTranscript *trans,
-				      ExperimentReaderContrib *contrib,
-				      gint64 current_time,
-				      gint y, gint last_contrib_y,
-				      int *logical_height);
+static PangoLayout *get_text_layout(GtkExperimentTranscript *trans,
+				    guint contrib,
+				    gint64 current_time,
+				    gint y, gint last_contrib_y,
+				    int *logical_height);
+static void draw_density_bar(GtkExperimentTranscript *trans,
+			     GtkExperimentTranscriptCanvas *canvas,
+			     guint contrib, gint y, gint height);
 static gboolean render_contribution_bottomup(GtkExperimentTranscript *trans,
-					     ExperimentReaderContrib *contrib,
+					     GtkExperimentTranscriptCanvas *canvas,
+					     gint height,
+					     guint contrib,
 					     gint64 current_time, gint64 current_time_px,
+					     const GdkRectangle *area,
 					     gint *last_contrib_y);
 static gboolean render_contribution_topdown(GtkExperimentTranscript *trans,
-					    ExperimentReaderContrib *contrib,
+					    GtkExperimentTranscriptCanvas *canvas,
+					    gint height,
+					    guint contrib,
 					    gint64 current_time, gint64 current_time_px,
+					    const GdkRectangle *area,
 					    gint *last_contrib_y);
+static gboolean get_backdrop_band(GtkExperimentTranscript *trans,
+				  gint64 current_time_px, GdkRectangle *band);
 static inline void render_backdrop_area(GtkExperimentTranscript *trans,
-					gint64 current_time_px);
+					GtkExperimentTranscriptCanvas *canvas,
+					gint64 current_time_px,
+					const GdkRectangle *area);
+static void text_layer_render_live(GtkExperimentTranscript *trans,
+				   gint64 current_time,
+				   const GdkRectangle *area);
+static void text_layer_render_area(GtkExperimentTranscript *trans,
+				   gint64 current_time,
+				   const GdkRectangle *area);
+static gint get_latest_contrib(GtkExperimentTranscript *trans,
+			       gint64 current_time);
+static gboolean get_contrib_band(GtkExperimentTranscript *trans, guint contrib,
+				 gint64 current_time, GdkRectangle *band);
+static void text_layer_scroll(GtkExperimentTranscript *trans,
+			      gint64 current_time);
 
 static void state_changed(GtkWidget *widget, GtkStateType state);
+static void style_set(GtkWidget *widget, GtkStyle *previous_style);
+static void update_font_metrics(GtkExperimentTranscript *trans);
 static gboolean button_pressed(GtkWidget *widget, GdkEventButton *event);
 static gboolean scrolled(GtkWidget *widget, GdkEventScroll *event);
 
@@ -81,6 +112,13 @@ static void text_alignment_activated(GtkWidget *widget, gpointer data);
 
 static void reverse_activated(GtkWidget *widget, gpointer data);
 
+/** @private */
+enum {
+	SCALE_CHANGED_SIGNAL,
+	LAST_SIGNAL
+};
+static guint gtk_experiment_transcript_signals[LAST_SIGNAL] = {0};
+
 /** @private */
 GQuark
 gtk_experiment_transcript_error_quark(void)
@@ -109,9 +147,19 @@ gtk_experiment_transcript_class_init(GtkExperimentTranscriptClass *klass)
 	widget_class->size_allocate = gtk_experiment_transcript_size_allocate;
 
 	widget_class->state_changed = state_changed;
+	widget_class->style_set = style_set;
 	widget_class->button_press_event = button_pressed;
 	widget_class->scroll_event = scrolled;
 
+	gtk_experiment_transcript_signals[SCALE_CHANGED_SIGNAL] =
+		g_signal_new("scale-changed",
+			     G_TYPE_FROM_CLASS(klass),
+			     G_SIGNAL_RUN_FIRST,
+			     G_STRUCT_OFFSET(GtkExperimentTranscriptClass, scale_changed),
+			     NULL, NULL,
+			     g_cclosure_marshal_VOID__UINT,
+			     G_TYPE_NONE, 1, G_TYPE_UINT);
+
 	g_type_class_add_private(klass, sizeof(GtkExperimentTranscriptPrivate));
 }
 
@@ -134,6 +182,9 @@ gtk_experiment_transcript_init(GtkExperimentTranscript *klass)
 	klass->interactive_format.default_bg_color = NULL;
 
 	klass->priv->flag_mask = 0;
+	klass->priv->scale = DEFAULT_SCALE;
+	klass->priv->line_height = 0;
+	klass->priv->char_width = 0;
 
 	klass->priv->time_adjustment = gtk_adjustment_new(0., 0., 0.,
 							  0., 0., 0.);
@@ -144,18 +195,38 @@ gtk_experiment_transcript_init(GtkExperimentTranscript *klass)
 				 G_CALLBACK(time_adj_on_value_changed), klass);
 
 	klass->priv->layer_text = NULL;
+	klass->priv->layer_text_time = 0;
+	klass->priv->redraw.rate = DEFAULT_REDRAW_RATE;
+	klass->priv->redraw.timeout_id = 0;
+	klass->priv->redraw.dirty = FALSE;
+	klass->priv->redraw.performed = 0;
+	klass->priv->redraw.skipped = 0;
 	klass->priv->layer_text_layout =
 		gtk_widget_create_pango_layout(GTK_WIDGET(klass), NULL);
 	pango_layout_set_wrap(klass->priv->layer_text_layout, PANGO_WRAP_WORD_CHAR);
 	pango_layout_set_ellipsize(klass->priv->layer_text_layout, PANGO_ELLIPSIZE_END);
 
+	for (gint i = 0; i < GTK_EXPERIMENT_TRANSCRIPT_N_PAINTS; i++)
+		klass->priv->paints.sources[i] = NULL;
+
 	klass->priv->backdrop.start = 0;
 	klass->priv->backdrop.end = 0;
 
 	klass->priv->contribs = NULL;
+	klass->priv->load_cancellable = NULL;
 	klass->priv->formats = NULL;
+	klass->priv->rules = gtk_experiment_transcript_rule_set_new(NULL);
 	klass->priv->interactive_format.regexp = NULL;
 	klass->priv->interactive_format.attribs = NULL;
+	klass->priv->format_generation = 0;
+	klass->priv->highlights.n_contribs = 0;
+	klass->priv->highlights.format_attribs = NULL;
+	klass->priv->highlights.interactive_attribs = NULL;
+	klass->priv->highlights.pending = 0;
+	klass->priv->highlights.idle_id = 0;
+	gtk_experiment_transcript_init_layouts(klass);
+	gtk_experiment_transcript_init_tiles(klass);
+	gtk_experiment_transcript_init_profile(klass);
 
 	/** @todo It should be possible to reset font and colors (to widget defaults) */
 	klass->priv->menu = gtk_menu_new();
@@ -274,8 +345,24 @@ gtk_experiment_transcript_dispose(GObject *gobject)
 		g_object_unref(trans->priv->time_adjustment);
 		trans->priv->time_adjustment = NULL;
 	}
+	if (trans->priv->redraw.timeout_id) {
+		g_source_remove(trans->priv->redraw.timeout_id);
+		trans->priv->redraw.timeout_id = 0;
+	}
 	GOBJECT_UNREF_SAFE(trans->priv->layer_text);
 	GOBJECT_UNREF_SAFE(trans->priv->layer_text_layout);
+	gtk_experiment_transcript_flush_layouts(trans);
+	gtk_experiment_transcript_free_tiles(trans);
+	gtk_experiment_transcript_flush_paints(trans);
+	gtk_experiment_transcript_free_profile(trans);
+	if (trans->priv->highlights.idle_id) {
+		g_source_remove(trans->priv->highlights.idle_id);
+		trans->priv->highlights.idle_id = 0;
+	}
+	if (trans->priv->load_cancellable != NULL) {
+		g_cancellable_cancel(trans->priv->load_cancellable);
+		GOBJECT_UNREF_SAFE(trans->priv->load_cancellable);
+	}
 
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS(gtk_experiment_transcript_parent_class)->dispose(gobject);
@@ -308,9 +395,13 @@ gtk_experiment_transcript_finalize(GObject *gobject)
 	if (trans->interactive_format.default_bg_color != NULL)
 		gdk_color_free(trans->interactive_format.default_bg_color);
 
-	experiment_reader_free_contributions(trans->priv->contribs);
+	if (trans->priv->contribs != NULL)
+		experiment_reader_contrib_table_unref(trans->priv->contribs);
+	gtk_experiment_transcript_rule_set_free(trans->priv->rules);
 	gtk_experiment_transcript_free_formats(trans->priv->formats);
 	gtk_experiment_transcript_free_format(&trans->priv->interactive_format);
+	gtk_experiment_transcript_free_layouts(trans);
+	gtk_experiment_transcript_free_highlights(trans);
 
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS(gtk_experiment_transcript_parent_class)->finalize(gobject);
@@ -374,6 +465,10 @@ static gboolean
 gtk_experiment_transcript_expose(GtkWidget *widget, GdkEventExpose *event)
 {
 	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(widget);
+	gint64 start = 0;
+
+	if (gtk_experiment_transcript_get_profiling(trans))
+		start = g_get_monotonic_time();
 
 	gdk_draw_drawable(GDK_DRAWABLE(gtk_widget_get_window(widget)),
 			  widget->style->fg_gc[gtk_widget_get_state(widget)],
@@ -382,20 +477,77 @@ gtk_experiment_transcript_expose(GtkWidget *widget, GdkEventExpose *event)
 			  event->area.x, event->area.y,
 			  event->area.width, event->area.height);
 
+	if (gtk_experiment_transcript_get_profiling(trans))
+		gtk_experiment_transcript_profile_record(trans,
+							 GTK_EXPERIMENT_TRANSCRIPT_PHASE_EXPOSE,
+							 g_get_monotonic_time() - start);
+
 	return FALSE;
 }
 
+/**
+ * @private
+ * Update text layer for a changed time-adjustment value.
+ *
+ * While the value changes rapidly (e.g. when dragging a scale connected
+ * to the adjustment), updates are throttled to the redraw rate:
+ * The first change is rendered immediately, later ones only mark the
+ * text layer dirty and are coalesced into a single update per frame
+ * by \ref redraw_timeout.
+ */
 static void
 time_adj_on_value_changed(GtkAdjustment *adj, gpointer user_data)
 {
 	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(user_data);
+	struct _GtkExperimentTranscriptRedraw *redraw = &trans->priv->redraw;
 
-	/**
-	 * @todo
-	 * heuristic to improve performance in the common case of advancing
-	 * time in small steps
-	 */
-	gtk_experiment_transcript_text_layer_redraw(trans);
+	if (redraw->timeout_id) {
+		/* previous change was not rendered yet and is superseded */
+		if (redraw->dirty)
+			redraw->skipped++;
+		redraw->dirty = TRUE;
+		return;
+	}
+
+	gtk_experiment_transcript_profile_begin(trans);
+	text_layer_scroll(trans, (gint64)gtk_adjustment_get_value(adj));
+	gtk_experiment_transcript_profile_end(trans);
+	redraw->performed++;
+
+	if (redraw->rate)
+		redraw->timeout_id =
+			gdk_threads_add_timeout_full(GDK_PRIORITY_REDRAW,
+						     MAX(1000/redraw->rate, 1),
+						     redraw_timeout, trans,
+						     NULL);
+}
+
+/**
+ * @private
+ * Render time changes since the last frame.
+ * The timeout is removed after a frame without changes, so the next
+ * change will be rendered immediately again.
+ */
+static gboolean
+redraw_timeout(gpointer user_data)
+{
+	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(user_data);
+	struct _GtkExperimentTranscriptRedraw *redraw = &trans->priv->redraw;
+	GtkAdjustment *adj;
+
+	if (!redraw->dirty || trans->priv->time_adjustment == NULL) {
+		redraw->timeout_id = 0;
+		return FALSE;
+	}
+	redraw->dirty = FALSE;
+
+	adj = GTK_ADJUSTMENT(trans->priv->time_adjustment);
+	gtk_experiment_transcript_profile_begin(trans);
+	text_layer_scroll(trans, (gint64)gtk_adjustment_get_value(adj));
+	gtk_experiment_transcript_profile_end(trans);
+	redraw->performed++;
+
+	return TRUE;
 }
 
 static void
@@ -404,7 +556,7 @@ gtk_experiment_transcript_reconfigure(GtkExperimentTranscript *trans)
 	GtkWidget *widget = GTK_WIDGET(trans);
 
 	gtk_adjustment_set_page_size(GTK_ADJUSTMENT(trans->priv->time_adjustment),
-				     (gdouble)PX_TO_TIME(widget->allocation.height));
+				     (gdouble)PX_TO_TIME(trans, widget->allocation.height));
 
 	GOBJECT_UNREF_SAFE(trans->priv->layer_text);
 	trans->priv->layer_text = gdk_pixmap_new(gtk_widget_get_window(widget),
@@ -417,153 +569,358 @@ gtk_experiment_transcript_reconfigure(GtkExperimentTranscript *trans)
 	gtk_experiment_transcript_text_layer_redraw(trans);
 }
 
-static gboolean
-configure_text_layout(GtkExperimentTranscript *trans,
-		      ExperimentReaderContrib *contrib,
-		      gint64 current_time,
-		      gint y, gint last_contrib_y,
-		      int *logical_height)
+/**
+ * @private
+ * Get layout of a contribution's text, clamped by the contribution
+ * rendered before it.
+ *
+ * If there is not enough space for a line of text (level of detail),
+ * no layout is returned and the contribution should be drawn as a
+ * density bar (see \ref draw_density_bar) of \e logical_height pixels.
+ *
+ * @return Layout or \c NULL. If the contribution has not started yet,
+ *         \e logical_height is set to -1.
+ */
+static PangoLayout *
+get_text_layout(GtkExperimentTranscript *trans,
+		guint contrib,
+		gint64 current_time,
+		gint y, gint last_contrib_y,
+		int *logical_height)
 {
-	PangoAttrList *attrib_list;
+	gint height = last_contrib_y == G_MININT ? -1
+						 : ABS(last_contrib_y - y);
 
-	if (contrib->start_time > current_time)
-		return FALSE;
+	if (experiment_reader_contrib_table_get_start_time(trans->priv->contribs,
+							   contrib) > current_time) {
+		*logical_height = -1;
+		return NULL;
+	}
 
-	attrib_list = pango_attr_list_new();
+	if (height >= 0 && height < trans->priv->line_height) {
+		*logical_height = height;
+		return NULL;
+	}
 
-	for (GSList *cur = trans->priv->formats; cur != NULL; cur = cur->next) {
-		GtkExperimentTranscriptFormat *fmt =
-				(GtkExperimentTranscriptFormat *)cur->data;
+	return gtk_experiment_transcript_get_layout(trans, contrib, height,
+						    logical_height);
+}
 
-		gtk_experiment_transcript_apply_format(fmt, contrib->text,
-						       attrib_list);
-	}
-	gtk_experiment_transcript_apply_format(&trans->priv->interactive_format,
-					       contrib->text, attrib_list);
+/**
+ * @private
+ * Draw a contribution too close to the next one for its text as a bar.
+ * The bar is as wide as the text would be in a single line, so the
+ * amount of speech is visible even at low zoom levels.
+ */
+static void
+draw_density_bar(GtkExperimentTranscript *trans,
+		 GtkExperimentTranscriptCanvas *canvas,
+		 guint contrib, gint y, gint height)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
 
-	pango_layout_set_attributes(trans->priv->layer_text_layout,
-				    attrib_list);
-	pango_attr_list_unref(attrib_list);
+	const gchar *text;
+	GdkRectangle bar;
 
-	pango_layout_set_text(trans->priv->layer_text_layout,
-			      contrib->text, -1);
+	/* keep contributions apart */
+	if (height > 1)
+		height--;
+	if (height <= 0)
+		return;
 
-	pango_layout_set_height(trans->priv->layer_text_layout,
-				last_contrib_y == -1
-					? G_MAXINT
-					: ABS(last_contrib_y - y)*PANGO_SCALE);
+	text = experiment_reader_contrib_table_get_text(trans->priv->contribs,
+							contrib);
+	bar.width = (gint)MIN(g_utf8_strlen(text, -1)*MAX(trans->priv->char_width, 1),
+			      (glong)widget->allocation.width);
+	bar.y = y;
+	bar.height = height;
 
-	pango_layout_get_pixel_size(trans->priv->layer_text_layout,
-				    NULL, logical_height);
+	switch (gtk_experiment_transcript_get_alignment(trans)) {
+	case PANGO_ALIGN_CENTER:
+		bar.x = (widget->allocation.width - bar.width)/2;
+		break;
+	case PANGO_ALIGN_RIGHT:
+		bar.x = widget->allocation.width - bar.width;
+		break;
+	default:
+		bar.x = 0;
+	}
 
-	return TRUE;
+	gtk_experiment_transcript_canvas_fill(trans, canvas,
+					      GTK_EXPERIMENT_TRANSCRIPT_PAINT_TEXT,
+					      &bar);
 }
 
 static gboolean
 render_contribution_bottomup(GtkExperimentTranscript *trans,
-			     ExperimentReaderContrib *contrib,
+			     GtkExperimentTranscriptCanvas *canvas,
+			     gint height, guint contrib,
 			     gint64 current_time, gint64 current_time_px,
+			     const GdkRectangle *area,
 			     gint *last_contrib_y)
 {
-	GtkWidget *widget = GTK_WIDGET(trans);
-
+	gint64 start_time =
+		experiment_reader_contrib_table_get_start_time(trans->priv->contribs,
+							       contrib);
 	gint old_last_contrib_y = *last_contrib_y;
+	PangoLayout *layout;
 	int logical_height;
 
-	*last_contrib_y = widget->allocation.height -
-			  (current_time_px - TIME_TO_PX(contrib->start_time));
+	*last_contrib_y = height - (current_time_px - TIME_TO_PX(trans, start_time));
 
-	if (!configure_text_layout(trans, contrib, current_time,
-				   *last_contrib_y, old_last_contrib_y,
-				   &logical_height))
+	/* text ends before the next contribution, i.e. below the area */
+	if (*last_contrib_y >= area->y + area->height)
 		return TRUE;
 
-	if (*last_contrib_y + logical_height < 0)
+	layout = get_text_layout(trans, contrib, current_time,
+				 *last_contrib_y, old_last_contrib_y,
+				 &logical_height);
+	if (layout == NULL && logical_height < 0)
+		return TRUE;
+
+	if (*last_contrib_y + logical_height < area->y)
 		return FALSE;
 
-	gdk_draw_layout(GDK_DRAWABLE(trans->priv->layer_text),
-			widget->style->text_gc[gtk_widget_get_state(widget)],
-			0, *last_contrib_y,
-			trans->priv->layer_text_layout);
+	if (layout != NULL)
+		gtk_experiment_transcript_canvas_draw_layout(trans, canvas,
+							     0, *last_contrib_y,
+							     layout);
+	else
+		draw_density_bar(trans, canvas, contrib,
+				 *last_contrib_y, logical_height);
 
-	return *last_contrib_y > 0;
+	return *last_contrib_y > area->y;
 }
 
 static gboolean
 render_contribution_topdown(GtkExperimentTranscript *trans,
-			    ExperimentReaderContrib *contrib,
+			    GtkExperimentTranscriptCanvas *canvas,
+			    gint height __attribute__((unused)),
+			    guint contrib,
 			    gint64 current_time, gint64 current_time_px,
+			    const GdkRectangle *area,
 			    gint *last_contrib_y)
 {
-	GtkWidget *widget = GTK_WIDGET(trans);
-
+	gint64 start_time =
+		experiment_reader_contrib_table_get_start_time(trans->priv->contribs,
+							       contrib);
 	gint old_last_contrib_y = *last_contrib_y;
+	PangoLayout *layout;
 	int logical_height;
 
-	*last_contrib_y = current_time_px - TIME_TO_PX(contrib->start_time);
+	*last_contrib_y = current_time_px - TIME_TO_PX(trans, start_time);
+
+	/* text starts after the next contribution, i.e. above the area */
+	if (*last_contrib_y <= area->y)
+		return TRUE;
 
-	if (!configure_text_layout(trans, contrib, current_time,
-				   *last_contrib_y, old_last_contrib_y,
-				   &logical_height))
+	layout = get_text_layout(trans, contrib, current_time,
+				 *last_contrib_y, old_last_contrib_y,
+				 &logical_height);
+	if (layout == NULL && logical_height < 0)
 		return TRUE;
 
-	if (*last_contrib_y - logical_height > widget->allocation.height)
+	if (*last_contrib_y - logical_height > area->y + area->height)
 		return FALSE;
 
-	gdk_draw_layout(GDK_DRAWABLE(trans->priv->layer_text),
-			widget->style->text_gc[gtk_widget_get_state(widget)],
-			0, *last_contrib_y - logical_height,
-			trans->priv->layer_text_layout);
+	if (layout != NULL)
+		gtk_experiment_transcript_canvas_draw_layout(trans, canvas,
+							     0, *last_contrib_y - logical_height,
+							     layout);
+	else
+		draw_density_bar(trans, canvas, contrib,
+				 *last_contrib_y - logical_height,
+				 logical_height);
 
-	return *last_contrib_y < widget->allocation.height;
+	return *last_contrib_y < area->y + area->height;
 }
 
-static inline void
-render_backdrop_area(GtkExperimentTranscript *trans, gint64 current_time_px)
+/**
+ * @private
+ * Get area of the text layer covered by the backdrop area.
+ *
+ * @return \c FALSE if no backdrop area is drawn
+ */
+static gboolean
+get_backdrop_band(GtkExperimentTranscript *trans, gint64 current_time_px,
+		  GdkRectangle *band)
 {
 	GtkWidget *widget = GTK_WIDGET(trans);
 
 	gint y_start, y_end;
-	GdkColor color;
-	GdkColor *bg = &widget->style->bg[gtk_widget_get_state(widget)];
 
 	if (!gtk_experiment_transcript_get_use_backdrop_area(trans))
-		return;
+		return FALSE;
 
 	if (gtk_experiment_transcript_get_reverse_mode(trans)) {
-		y_end = current_time_px - TIME_TO_PX(trans->priv->backdrop.start);
-		y_start = current_time_px - TIME_TO_PX(trans->priv->backdrop.end);
+		y_end = current_time_px - TIME_TO_PX(trans, trans->priv->backdrop.start);
+		y_start = current_time_px - TIME_TO_PX(trans, trans->priv->backdrop.end);
 	} else {
 		y_start = widget->allocation.height -
-			  (current_time_px - TIME_TO_PX(trans->priv->backdrop.start));
+			  (current_time_px - TIME_TO_PX(trans, trans->priv->backdrop.start));
 		y_end = widget->allocation.height -
-			(current_time_px - TIME_TO_PX(trans->priv->backdrop.end));
+			(current_time_px - TIME_TO_PX(trans, trans->priv->backdrop.end));
 	}
 
-	if ((y_start < 0 && y_end < 0) ||
-	    (y_start > widget->allocation.height &&
-	     y_end > widget->allocation.height))
+	band->x = 0;
+	band->y = y_start;
+	band->width = widget->allocation.width;
+	band->height = y_end - y_start;
+
+	return band->height > 0;
+}
+
+static inline void
+render_backdrop_area(GtkExperimentTranscript *trans,
+		     GtkExperimentTranscriptCanvas *canvas,
+		     gint64 current_time_px, const GdkRectangle *area)
+{
+	GdkRectangle band;
+
+	if (!get_backdrop_band(trans, current_time_px, &band) ||
+	    !gdk_rectangle_intersect((GdkRectangle *)area, &band, &band))
 		return;
 
-	y_start = CLAMP(y_start, 0, widget->allocation.height);
-	y_end = CLAMP(y_end, 0, widget->allocation.height);
-
-	color.pixel = 0;
-	color.red = MAX((gint)bg->red - BACKDROP_VALUE, 0);
-	color.blue = MAX((gint)bg->blue - BACKDROP_VALUE, 0);
-	color.green = MAX((gint)bg->green - BACKDROP_VALUE, 0);
-	if (!color.red && !color.blue && !color.green) {
-		color.red = MIN((gint)bg->red + BACKDROP_VALUE, G_MAXUINT16);
-		color.blue = MIN((gint)bg->blue + BACKDROP_VALUE, G_MAXUINT16);
-		color.green = MIN((gint)bg->green + BACKDROP_VALUE, G_MAXUINT16);
+	gtk_experiment_transcript_canvas_fill(trans, canvas,
+					      GTK_EXPERIMENT_TRANSCRIPT_PAINT_BACKDROP,
+					      &band);
+}
+
+/**
+ * @private
+ * @brief Render contributions into part of a drawable
+ *
+ * Contributions are rendered from \e contrib backwards, i.e. up in
+ * normal mode and down in reverse mode, until \e area is filled.
+ * Each contribution's text is clamped by the one rendered before it,
+ * so the first one is not clamped.
+ * The area is not cleared.
+ *
+ * @param trans           Widget instance
+ * @param canvas          Canvas to render into, clipped to \e area
+ * @param height          Height of the canvas' drawable in pixels
+ * @param current_time    Contributions starting later are not rendered
+ * @param current_time_px Position of the \e drawable's edge in pixels
+ *                        (bottom edge in normal mode, top edge in
+ *                        reverse mode)
+ * @param contrib         Index of first contribution to render
+ * @param area            Area of \e drawable to render
+ */
+G_GNUC_INTERNAL void
+gtk_experiment_transcript_render_contribs(GtkExperimentTranscript *trans,
+					  GtkExperimentTranscriptCanvas *canvas,
+					  gint height,
+					  gint64 current_time,
+					  gint64 current_time_px,
+					  gint contrib,
+					  const GdkRectangle *area)
+{
+	gint last_contrib_y = G_MININT;
+
+	GtkExperimentTranscriptContribRenderer renderer;
+
+	renderer = gtk_experiment_transcript_get_reverse_mode(trans)
+			? render_contribution_topdown
+			: render_contribution_bottomup;
+
+	for (gint i = contrib; i >= 0; i--) {
+		if (!renderer(trans, canvas, height, (guint)i,
+			      current_time, current_time_px,
+			      area, &last_contrib_y))
+			break;
+	}
+}
+
+/**
+ * @private
+ * @brief Render part of the text layer from scratch
+ *
+ * Only contributions intersecting \e area are laid out and drawing is
+ * clipped to it, so the rest of the text layer is left untouched.
+ * The widget is not invalidated.
+ *
+ * @param trans        Widget instance
+ * @param current_time Time to render in milliseconds
+ * @param area         Area of text layer to render
+ */
+static void
+text_layer_render_live(GtkExperimentTranscript *trans, gint64 current_time,
+		       const GdkRectangle *area)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+
+	gint64 current_time_px = TIME_TO_PX(trans, current_time);
+	GtkExperimentTranscriptCanvas canvas;
+	GtkExperimentTranscriptPhase phase;
+	gint contrib;
+
+	gtk_experiment_transcript_canvas_begin(trans, &canvas,
+					       GDK_DRAWABLE(trans->priv->layer_text),
+					       area);
+
+	gtk_experiment_transcript_canvas_fill(trans, &canvas,
+					      GTK_EXPERIMENT_TRANSCRIPT_PAINT_BG,
+					      area);
+
+	render_backdrop_area(trans, &canvas, current_time_px, area);
+
+	if (trans->priv->contribs != NULL) {
+		phase = gtk_experiment_transcript_profile_enter(trans,
+								GTK_EXPERIMENT_TRANSCRIPT_PHASE_LOOKUP);
+		contrib = experiment_reader_contrib_table_lookup(trans->priv->contribs,
+								 current_time);
+		gtk_experiment_transcript_profile_leave(trans, phase);
+
+		gtk_experiment_transcript_render_contribs(trans, &canvas,
+							  widget->allocation.height,
+							  current_time, current_time_px,
+							  contrib, area);
+	}
+
+	gtk_experiment_transcript_canvas_end(trans, &canvas);
+}
+
+/**
+ * @private
+ * @brief Render part of the text layer
+ *
+ * The text layer is composed of pre-rendered tiles (see
+ * \ref gtk_experiment_transcript_draw_tiles).
+ * Tiles do not depend on the current time, so two bands are rendered
+ * on top of them from scratch:
+ * The latest contribution is not clamped by the contribution following
+ * it as long as that one has not started yet, and the backdrop area
+ * is drawn beneath the text.
+ *
+ * @param trans        Widget instance
+ * @param current_time Time to render in milliseconds
+ * @param area         Area of text layer to render
+ */
+static void
+text_layer_render_area(GtkExperimentTranscript *trans, gint64 current_time,
+		       const GdkRectangle *area)
+{
+	GdkRectangle band;
+	gint latest;
+
+	if (trans->priv->contribs == NULL ||
+	    !gtk_experiment_transcript_draw_tiles(trans,
+						  TIME_TO_PX(trans, current_time),
+						  area)) {
+		text_layer_render_live(trans, current_time, area);
+		return;
 	}
-	gtk_widget_modify_fg(widget, gtk_widget_get_state(widget), &color);
 
-	gdk_draw_rectangle(GDK_DRAWABLE(trans->priv->layer_text),
-			   widget->style->fg_gc[gtk_widget_get_state(widget)],
-			   TRUE,
-			   0, y_start,
-			   widget->allocation.width, y_end - y_start);
+	latest = get_latest_contrib(trans, current_time);
+	if (latest >= 0 &&
+	    (guint)latest + 1 < trans->priv->contribs->n_contribs &&
+	    get_contrib_band(trans, (guint)latest, current_time, &band) &&
+	    gdk_rectangle_intersect((GdkRectangle *)area, &band, &band))
+		text_layer_render_live(trans, current_time, &band);
+
+	if (get_backdrop_band(trans, TIME_TO_PX(trans, current_time), &band) &&
+	    gdk_rectangle_intersect((GdkRectangle *)area, &band, &band))
+		text_layer_render_live(trans, current_time, &band);
 }
 
 /** @private */
@@ -572,50 +929,172 @@ gtk_experiment_transcript_text_layer_redraw(GtkExperimentTranscript *trans)
 {
 	GtkWidget *widget = GTK_WIDGET(trans);
 
-	gint64 current_time = 0, current_time_px;
-	gint last_contrib_y = -1;
-
-	GtkExperimentTranscriptContribRenderer renderer;
+	gint64 current_time = 0;
+	GdkRectangle area = {
+		0, 0, widget->allocation.width, widget->allocation.height
+	};
 
 	if (trans->priv->time_adjustment != NULL) {
 		GtkAdjustment *adj =
 				GTK_ADJUSTMENT(trans->priv->time_adjustment);
 		current_time = (gint64)gtk_adjustment_get_value(adj);
 	}
-	current_time_px = TIME_TO_PX(current_time);
 
-	gdk_draw_rectangle(GDK_DRAWABLE(trans->priv->layer_text),
-			   widget->style->bg_gc[gtk_widget_get_state(widget)],
-			   TRUE,
-			   0, 0,
-			   widget->allocation.width,
-			   widget->allocation.height);
-
-	render_backdrop_area(trans, current_time_px);
+	gtk_experiment_transcript_profile_begin(trans);
+	text_layer_render_area(trans, current_time, &area);
+	gtk_experiment_transcript_profile_end(trans);
+	trans->priv->layer_text_time = current_time;
 
 	gtk_widget_queue_draw_area(widget, 0, 0,
 				   widget->allocation.width,
 				   widget->allocation.height);
+}
 
-	if (trans->priv->contribs == NULL)
+/**
+ * @private
+ * Get index of the latest contribution started at \e current_time or
+ * -1 if there is none.
+ */
+static gint
+get_latest_contrib(GtkExperimentTranscript *trans, gint64 current_time)
+{
+	ExperimentReaderContribTable *contribs = trans->priv->contribs;
+	GtkExperimentTranscriptPhase phase;
+	gint i;
+
+	if (contribs == NULL || !contribs->n_contribs)
+		return -1;
+
+	phase = gtk_experiment_transcript_profile_enter(trans,
+							GTK_EXPERIMENT_TRANSCRIPT_PHASE_LOOKUP);
+	i = experiment_reader_contrib_table_lookup(contribs, current_time);
+	gtk_experiment_transcript_profile_leave(trans, phase);
+	if (experiment_reader_contrib_table_get_start_time(contribs, i) >
+	    current_time)
+		return -1;
+
+	return i;
+}
+
+/**
+ * @private
+ * Get area of the text layer from a contribution's start to the edge
+ * of the current time.
+ *
+ * @return \c FALSE if the area is empty
+ */
+static gboolean
+get_contrib_band(GtkExperimentTranscript *trans, guint contrib,
+		 gint64 current_time, GdkRectangle *band)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+
+	gint height = widget->allocation.height;
+	gint64 start_time =
+		experiment_reader_contrib_table_get_start_time(trans->priv->contribs,
+							       contrib);
+	gint y = (gint)(TIME_TO_PX(trans, current_time) -
+			TIME_TO_PX(trans, start_time));
+
+	band->x = 0;
+	band->width = widget->allocation.width;
+	if (gtk_experiment_transcript_get_reverse_mode(trans)) {
+		band->y = 0;
+		band->height = MIN(y, height);
+	} else {
+		band->y = MAX(height - y, 0);
+		band->height = height - band->y;
+	}
+
+	return band->height > 0;
+}
+
+/**
+ * @private
+ * @brief Update text layer for a new time
+ *
+ * For small steps, the existing text layer contents are shifted and only
+ * the newly exposed strip is rendered. Contributions already shown keep
+ * their place, except for the latest one visible both before and after
+ * the step: its text is clamped by the contribution following it, which
+ * may have appeared or disappeared, so it is rendered again.
+ * Only the changed areas of the widget are invalidated, the rest of the
+ * window is scrolled.
+ * Larger steps fall back to
+ * \ref gtk_experiment_transcript_text_layer_redraw.
+ *
+ * @param trans        Widget instance
+ * @param current_time New time in milliseconds
+ */
+static void
+text_layer_scroll(GtkExperimentTranscript *trans, gint64 current_time)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+
+	gint width = widget->allocation.width;
+	gint height = widget->allocation.height;
+	gint64 old_time = trans->priv->layer_text_time;
+	gint64 delta_px = TIME_TO_PX(trans, current_time) - TIME_TO_PX(trans, old_time);
+	gboolean reverse = gtk_experiment_transcript_get_reverse_mode(trans);
+	gint shift, common;
+	GdkRectangle strip = {0, 0, width, 0};
+	GdkRectangle clamped = {0, 0, width, 0};
+	GdkRectangle overlap;
+
+	if (!gtk_widget_get_realized(widget) ||
+	    trans->priv->layer_text == NULL)
 		return;
 
-	renderer = gtk_experiment_transcript_get_reverse_mode(trans)
-			? render_contribution_topdown
-			: render_contribution_bottomup;
+	if (ABS(delta_px) >= height) {
+		gtk_experiment_transcript_text_layer_redraw(trans);
+		return;
+	}
 
-	for (GList *cur = experiment_reader_get_contribution_by_time(
-							trans->priv->contribs,
-							current_time);
-	     cur != NULL;
-	     cur = cur->prev) {
-		ExperimentReaderContrib *contrib = (ExperimentReaderContrib *)
-						   cur->data;
+	/* number of pixels contents move down (or up if negative) */
+	shift = reverse ? (gint)delta_px : -(gint)delta_px;
+
+	if (shift > 0) {
+		gdk_draw_drawable(GDK_DRAWABLE(trans->priv->layer_text),
+				  widget->style->bg_gc[gtk_widget_get_state(widget)],
+				  GDK_DRAWABLE(trans->priv->layer_text),
+				  0, 0, 0, shift, width, height - shift);
+		strip.height = shift;
+	} else if (shift < 0) {
+		gdk_draw_drawable(GDK_DRAWABLE(trans->priv->layer_text),
+				  widget->style->bg_gc[gtk_widget_get_state(widget)],
+				  GDK_DRAWABLE(trans->priv->layer_text),
+				  0, -shift, 0, 0, width, height + shift);
+		strip.y = height + shift;
+		strip.height = -shift;
+	}
 
-		if (!renderer(trans, contrib, current_time, current_time_px,
-			      &last_contrib_y))
-			break;
+	common = get_latest_contrib(trans, MIN(old_time, current_time));
+	if (common >= 0 &&
+	    get_latest_contrib(trans, old_time) !=
+	    get_latest_contrib(trans, current_time) &&
+	    !get_contrib_band(trans, (guint)common, current_time, &clamped))
+		clamped.height = 0;
+
+	if (strip.height > 0 && clamped.height > 0 &&
+	    gdk_rectangle_intersect(&strip, &clamped, &overlap)) {
+		gdk_rectangle_union(&strip, &clamped, &strip);
+		clamped.height = 0;
 	}
+
+	if (strip.height > 0)
+		text_layer_render_area(trans, current_time, &strip);
+	if (clamped.height > 0)
+		text_layer_render_area(trans, current_time, &clamped);
+	trans->priv->layer_text_time = current_time;
+
+	if (shift)
+		gdk_window_scroll(gtk_widget_get_window(widget), 0, shift);
+	if (strip.height > 0)
+		gtk_widget_queue_draw_area(widget, strip.x, strip.y,
+					   strip.width, strip.height);
+	if (clamped.height > 0)
+		gtk_widget_queue_draw_area(widget, clamped.x, clamped.y,
+					   clamped.width, clamped.height);
 }
 
 static void
@@ -623,11 +1102,77 @@ state_changed(GtkWidget *widget, GtkStateType state __attribute__((unused)))
 {
 	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(widget);
 
+	/* tiles were rendered with the colors of the previous state */
+	gtk_experiment_transcript_flush_tiles(trans);
+	gtk_experiment_transcript_flush_paints(trans);
+
 	if (gtk_widget_get_realized(widget) &&
 	    trans->priv->layer_text != NULL)
 		gtk_experiment_transcript_text_layer_redraw(trans);
 }
 
+static void
+style_set(GtkWidget *widget, GtkStyle *previous_style)
+{
+	GtkExperimentTranscript *trans = GTK_EXPERIMENT_TRANSCRIPT(widget);
+
+	GTK_WIDGET_CLASS(gtk_experiment_transcript_parent_class)->style_set(widget,
+									     previous_style);
+
+	gtk_experiment_transcript_flush_paints(trans);
+
+	/*
+	 * the GDK backend modifies the foreground color when the backdrop
+	 * area's color changes, but only text and background colors are
+	 * rendered into tiles and only font changes invalidate layouts
+	 */
+	for (guint state = 0;
+	     previous_style != NULL && state < G_N_ELEMENTS(previous_style->bg);
+	     state++) {
+		if (!gdk_color_equal(&previous_style->text[state],
+				     &widget->style->text[state]) ||
+		    !gdk_color_equal(&previous_style->bg[state],
+				     &widget->style->bg[state])) {
+			gtk_experiment_transcript_flush_tiles(trans);
+			break;
+		}
+	}
+
+	if (previous_style != NULL &&
+	    pango_font_description_equal(previous_style->font_desc,
+					 widget->style->font_desc))
+		return;
+
+	if (trans->priv->layer_text_layout != NULL)
+		pango_layout_context_changed(trans->priv->layer_text_layout);
+	update_font_metrics(trans);
+	gtk_experiment_transcript_flush_layouts(trans);
+	gtk_experiment_transcript_flush_tiles(trans);
+}
+
+/**
+ * @private
+ * Update line height and character width of the widget's font, used
+ * to decide whether there is enough space to draw a contribution's text.
+ */
+static void
+update_font_metrics(GtkExperimentTranscript *trans)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+	PangoFontMetrics *metrics;
+
+	metrics = pango_context_get_metrics(gtk_widget_get_pango_context(widget),
+					    widget->style->font_desc, NULL);
+
+	trans->priv->line_height =
+		PANGO_PIXELS(pango_font_metrics_get_ascent(metrics) +
+			     pango_font_metrics_get_descent(metrics));
+	trans->priv->char_width =
+		PANGO_PIXELS(pango_font_metrics_get_approximate_char_width(metrics));
+
+	pango_font_metrics_unref(metrics);
+}
+
 static gboolean
 button_pressed(GtkWidget *widget, GdkEventButton *event)
 {
@@ -655,6 +1200,24 @@ scrolled(GtkWidget *widget, GdkEventScroll *event)
 	if (trans->priv->time_adjustment == NULL)
 		return FALSE;
 
+	/* zoom with Ctrl + mouse wheel */
+	if (event->state & GDK_CONTROL_MASK) {
+		guint scale = trans->priv->scale;
+
+		switch (event->direction) {
+		case GDK_SCROLL_UP:
+			scale -= MAX(scale/ZOOM_STEP, 1);
+			break;
+		case GDK_SCROLL_DOWN:
+			scale += MAX(scale/ZOOM_STEP, 1);
+		default:
+			break;
+		}
+
+		gtk_experiment_transcript_set_scale(trans, scale);
+		return TRUE;
+	}
+
 	adj = GTK_ADJUSTMENT(trans->priv->time_adjustment);
 	value = gtk_adjustment_get_value(adj);
 	real_upper = gtk_adjustment_get_upper(adj) -
@@ -783,6 +1346,8 @@ text_alignment_activated(GtkWidget *widget __attribute__((unused)),
 
 		pango_layout_set_alignment(trans->priv->layer_text_layout,
 					   alignment);
+		gtk_experiment_transcript_flush_layouts(trans);
+		gtk_experiment_transcript_flush_tiles(trans);
 
 		if (gtk_widget_get_realized(GTK_WIDGET(trans)) &&
 		    trans->priv->layer_text != NULL)
@@ -846,13 +1411,56 @@ gboolean
 gtk_experiment_transcript_load(GtkExperimentTranscript *trans,
 			       ExperimentReader *exp)
 {
-	experiment_reader_free_contributions(trans->priv->contribs);
+	if (trans->priv->contribs != NULL)
+		experiment_reader_contrib_table_unref(trans->priv->contribs);
 	trans->priv->contribs =
-		experiment_reader_get_contributions_by_speaker(exp, trans->speaker);
+		experiment_reader_get_contrib_table_by_speaker(exp, trans->speaker);
+	gtk_experiment_transcript_flush_layouts(trans);
+	gtk_experiment_transcript_flush_tiles(trans);
+	gtk_experiment_transcript_reset_highlights(trans);
+
+	gtk_experiment_transcript_text_layer_redraw(trans);
+
+	return trans->priv->contribs->n_contribs > 0;
+}
+
+/**
+ * @brief Load contributions from a set of contribution tables.
+ *
+ * The contribution tables are given as returned by
+ * \e experiment_reader_get_contrib_tables, so that the contributions
+ * of all speakers can be extracted from a session at once and then be
+ * loaded into several transcript widgets.
+ * Only the contributions of the configured speaker are used.
+ *
+ * @sa gtk_experiment_transcript_load
+ *
+ * @param trans  Widget instance
+ * @param tables Hash table of \e ExperimentReaderContribTable structures
+ *               keyed by speaker name quarks
+ * @return \c TRUE on success, else \c FALSE
+ */
+gboolean
+gtk_experiment_transcript_load_tables(GtkExperimentTranscript *trans,
+				      GHashTable *tables)
+{
+	ExperimentReaderContribTable *table;
+
+	table = g_hash_table_lookup(tables,
+				    GUINT_TO_POINTER(g_quark_from_string(trans->speaker)));
+
+	if (trans->priv->contribs != NULL)
+		experiment_reader_contrib_table_unref(trans->priv->contribs);
+	trans->priv->contribs = table != NULL
+			? experiment_reader_contrib_table_ref(table)
+			: NULL;
+	gtk_experiment_transcript_flush_layouts(trans);
+	gtk_experiment_transcript_flush_tiles(trans);
+	gtk_experiment_transcript_reset_highlights(trans);
 
 	gtk_experiment_transcript_text_layer_redraw(trans);
 
-	return trans->priv->contribs != NULL;
+	return table != NULL && table->n_contribs > 0;
 }
 
 /**
@@ -873,7 +1481,10 @@ gtk_experiment_transcript_load_filename(GtkExperimentTranscript *trans,
 					const gchar *filename)
 {
 	gboolean res = FALSE;
-	ExperimentReader *exp = experiment_reader_new(filename);
+	ExperimentReader *exp;
+
+	exp = experiment_reader_new_with_flags(filename,
+					       EXPERIMENT_READER_FLAG_STREAMING);
 
 	if (exp != NULL) {
 		res = gtk_experiment_transcript_load(trans, exp);
@@ -883,6 +1494,107 @@ gtk_experiment_transcript_load_filename(GtkExperimentTranscript *trans,
 	return res;
 }
 
+/** @private */
+static void
+load_filename_ready_cb(GObject *source __attribute__((unused)),
+		       GAsyncResult *result, gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT(user_data);
+	GtkExperimentTranscript *trans;
+	ExperimentReader *exp;
+	GError *error = NULL;
+
+	trans = GTK_EXPERIMENT_TRANSCRIPT(g_async_result_get_source_object(G_ASYNC_RESULT(res)));
+
+	/* GLib idle callbacks are invoked without the GDK lock */
+	gdk_threads_enter();
+
+	exp = experiment_reader_new_finish(result, &error);
+	if (exp != NULL) {
+		g_simple_async_result_set_op_res_gboolean(res,
+							  gtk_experiment_transcript_load(trans, exp));
+		g_object_unref(exp);
+	} else {
+		g_simple_async_result_set_from_error(res, error);
+		g_error_free(error);
+	}
+
+	g_simple_async_result_complete(res);
+
+	gdk_threads_leave();
+
+	g_object_unref(res);
+	g_object_unref(trans);
+}
+
+/**
+ * @brief Asynchronously load contributions from an experiment transcript
+ *        file.
+ *
+ * The file is read in a worker thread, so that the user interface stays
+ * responsive while large sessions are loaded. The widget keeps showing
+ * its current contributions until the new ones are ready.
+ * Starting another load cancels the one in flight.
+ *
+ * \e callback is invoked with the GDK lock held and must call
+ * \ref gtk_experiment_transcript_load_filename_finish.
+ *
+ * @sa gtk_experiment_transcript_load_filename
+ *
+ * @param trans     Widget instance
+ * @param filename  Filename of transcript file
+ * @param callback  Callback to invoke when loading is finished or \c NULL
+ * @param user_data Data to pass to \e callback
+ */
+void
+gtk_experiment_transcript_load_filename_async(GtkExperimentTranscript *trans,
+					      const gchar *filename,
+					      GAsyncReadyCallback callback,
+					      gpointer user_data)
+{
+	GSimpleAsyncResult *res;
+
+	if (trans->priv->load_cancellable != NULL) {
+		g_cancellable_cancel(trans->priv->load_cancellable);
+		g_object_unref(trans->priv->load_cancellable);
+	}
+	trans->priv->load_cancellable = g_cancellable_new();
+
+	res = g_simple_async_result_new(G_OBJECT(trans), callback, user_data,
+					gtk_experiment_transcript_load_filename_async);
+	experiment_reader_new_async(filename, EXPERIMENT_READER_FLAG_STREAMING,
+				    trans->priv->load_cancellable,
+				    load_filename_ready_cb, res);
+}
+
+/**
+ * @brief Finish loading contributions asynchronously.
+ *
+ * @sa gtk_experiment_transcript_load_filename_async
+ *
+ * @param trans  Widget instance
+ * @param result \e GAsyncResult passed to the callback
+ * @param error  Location to store error or \c NULL. If the load was
+ *               cancelled, it is set to \c G_IO_ERROR_CANCELLED.
+ * @return \c TRUE on success, else \c FALSE
+ */
+gboolean
+gtk_experiment_transcript_load_filename_finish(GtkExperimentTranscript *trans,
+					       GAsyncResult *result,
+					       GError **error)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT(result);
+
+	g_return_val_if_fail(g_simple_async_result_is_valid(result, G_OBJECT(trans),
+							    gtk_experiment_transcript_load_filename_async),
+			     FALSE);
+
+	if (g_simple_async_result_propagate_error(res, error))
+		return FALSE;
+
+	return g_simple_async_result_get_op_res_gboolean(res);
+}
+
 /**
  * @brief Enable or disable drawing a backdrop area
  *
@@ -903,6 +1615,52 @@ gtk_experiment_transcript_set_use_backdrop_area(GtkExperimentTranscript *trans,
 		gtk_experiment_transcript_text_layer_redraw(trans);
 }
 
+/**
+ * @brief Select whether a transcript widget draws with cairo
+ *
+ * Text and backgrounds are either drawn with cairo (and Pango's cairo
+ * renderer) or with the style's GDK graphics contexts.
+ * The GDK backend modifies the widget's foreground color to draw the
+ * backdrop area.
+ * \e render-benchmark in the widget library's tests measures both.
+ * GDK is used by default.
+ *
+ * @param trans Widget instance
+ * @param use   Whether to draw with cairo (\c TRUE) or GDK (\c FALSE)
+ */
+void
+gtk_experiment_transcript_set_use_cairo(GtkExperimentTranscript *trans,
+					gboolean use)
+{
+	if (!gtk_experiment_transcript_get_use_cairo(trans) == !use)
+		return;
+
+	trans->priv->flag_mask &= ~GTK_EXPERIMENT_TRANSCRIPT_USE_CAIRO_MASK;
+	trans->priv->flag_mask |=
+			use ? GTK_EXPERIMENT_TRANSCRIPT_USE_CAIRO_MASK : 0;
+
+	gtk_experiment_transcript_flush_tiles(trans);
+
+	if (gtk_widget_get_realized(GTK_WIDGET(trans)) &&
+	    trans->priv->layer_text != NULL)
+		gtk_experiment_transcript_text_layer_redraw(trans);
+}
+
+/**
+ * @brief Retrieve whether a transcript widget draws with cairo
+ *
+ * @sa gtk_experiment_transcript_set_use_cairo
+ *
+ * @param trans Widget instance
+ * @return \c TRUE if it draws with cairo, \c FALSE if it draws with GDK
+ */
+gboolean
+gtk_experiment_transcript_get_use_cairo(GtkExperimentTranscript *trans)
+{
+	return trans->priv->flag_mask &
+	       GTK_EXPERIMENT_TRANSCRIPT_USE_CAIRO_MASK;
+}
+
 /**
  * @brief Retrieve whether a backdrop area is drawn or not
  *
@@ -1023,6 +1781,139 @@ gtk_experiment_transcript_get_alignment(GtkExperimentTranscript *trans)
 	return pango_layout_get_alignment(trans->priv->layer_text_layout);
 }
 
+/**
+ * @brief Set time scale of a transcript widget
+ *
+ * The scale determines how much of the transcript is visible at once.
+ * It can also be changed by the user by scrolling with the mouse wheel
+ * while pressing the Control key.
+ * When zoomed out so far that there is not enough space between
+ * contributions for a line of text, contributions are drawn as bars
+ * whose widths correspond to the lengths of their texts.
+ * The scale defaults to \ref DEFAULT_SCALE and is clamped to
+ * \ref MIN_SCALE and \ref MAX_SCALE.
+ * If it changes, the "scale-changed" signal is emitted.
+ *
+ * @param trans Widget instance
+ * @param scale New scale in milliseconds per pixel
+ */
+void
+gtk_experiment_transcript_set_scale(GtkExperimentTranscript *trans,
+				    guint scale)
+{
+	GtkWidget *widget = GTK_WIDGET(trans);
+
+	scale = CLAMP(scale, MIN_SCALE, MAX_SCALE);
+	if (scale == trans->priv->scale)
+		return;
+	trans->priv->scale = scale;
+
+	if (trans->priv->time_adjustment != NULL)
+		gtk_adjustment_set_page_size(GTK_ADJUSTMENT(trans->priv->time_adjustment),
+					     (gdouble)PX_TO_TIME(trans, widget->allocation.height));
+
+	/* tiles are invalidated automatically */
+	if (gtk_widget_get_realized(widget) &&
+	    trans->priv->layer_text != NULL)
+		gtk_experiment_transcript_text_layer_redraw(trans);
+
+	g_signal_emit(trans, gtk_experiment_transcript_signals[SCALE_CHANGED_SIGNAL], 0,
+		      scale);
+}
+
+/**
+ * @brief Get time scale of a transcript widget
+ *
+ * @sa gtk_experiment_transcript_set_scale
+ *
+ * @param trans Widget instance
+ * @return Scale in milliseconds per pixel
+ */
+guint
+gtk_experiment_transcript_get_scale(GtkExperimentTranscript *trans)
+{
+	return trans->priv->scale;
+}
+
+/**
+ * @brief Set maximum rate of transcript widget updates on time changes
+ *
+ * Whenever the value of the widget's time-adjustment changes, the
+ * transcript has to be rendered for the new time.
+ * When the value changes more often than \e rate times per second
+ * (e.g. while dragging a scale sharing the adjustment), all changes
+ * within one frame are coalesced into a single update.
+ * The rate defaults to \ref DEFAULT_REDRAW_RATE, which should match
+ * common display refresh rates.
+ * A rate of 0 disables throttling, i.e. every change is rendered
+ * immediately.
+ *
+ * @sa gtk_experiment_transcript_get_redraw_stats
+ *
+ * @param trans Widget instance
+ * @param rate  Maximum number of updates per second or 0
+ */
+void
+gtk_experiment_transcript_set_redraw_rate(GtkExperimentTranscript *trans,
+					  guint rate)
+{
+	struct _GtkExperimentTranscriptRedraw *redraw = &trans->priv->redraw;
+
+	redraw->rate = rate;
+
+	/* the next change will be rendered immediately with the new rate */
+	if (redraw->timeout_id) {
+		g_source_remove(redraw->timeout_id);
+		redraw->timeout_id = 0;
+	}
+	if (redraw->dirty) {
+		redraw->dirty = FALSE;
+		if (trans->priv->time_adjustment != NULL)
+			time_adj_on_value_changed(GTK_ADJUSTMENT(trans->priv->time_adjustment),
+						  trans);
+	}
+}
+
+/**
+ * @brief Get maximum rate of transcript widget updates on time changes
+ *
+ * @sa gtk_experiment_transcript_set_redraw_rate
+ *
+ * @param trans Widget instance
+ * @return Maximum number of updates per second or 0 if unlimited
+ */
+guint
+gtk_experiment_transcript_get_redraw_rate(GtkExperimentTranscript *trans)
+{
+	return trans->priv->redraw.rate;
+}
+
+/**
+ * @brief Get statistics about transcript widget updates on time changes
+ *
+ * Every change of the time-adjustment's value is either rendered or
+ * skipped, because a later change was rendered instead within the same
+ * frame.
+ * The ratio of both numbers shows how effective throttling is.
+ *
+ * @sa gtk_experiment_transcript_set_redraw_rate
+ *
+ * @param trans     Widget instance
+ * @param performed Location to store the number of rendered updates
+ *                  or \c NULL
+ * @param skipped   Location to store the number of skipped updates
+ *                  or \c NULL
+ */
+void
+gtk_experiment_transcript_get_redraw_stats(GtkExperimentTranscript *trans,
+					   guint *performed, guint *skipped)
+{
+	if (performed != NULL)
+		*performed = trans->priv->redraw.performed;
+	if (skipped != NULL)
+		*skipped = trans->priv->redraw.skipped;
+}
+
 /**
  * @brief Get time-adjustment currently used by a transcript widget
  *
@@ -1073,7 +1964,7 @@ gtk_experiment_transcript_set_time_adjustment(GtkExperimentTranscript *trans,
 	g_object_ref_sink(trans->priv->time_adjustment);
 
 	gtk_adjustment_set_page_size(GTK_ADJUSTMENT(trans->priv->time_adjustment),
-				     (gdouble)PX_TO_TIME(widget->allocation.height));
+				     (gdouble)PX_TO_TIME(trans, widget->allocation.height));
 
 	trans->priv->time_adj_on_value_changed_id =
 		g_signal_connect(G_OBJECT(trans->priv->time_adjustment),
@@ -45,6 +45,49 @@ typedef enum {
 	GTK_EXPERIMENT_TRANSCRIPT_ERROR_LINELENGTH	/**< Line read is too long */
 } GtkExperimentTranscriptError;
 
+/**
+ * Phases of updating a \e GtkExperimentTranscript, timed when profiling
+ * is enabled
+ *
+ * @sa gtk_experiment_transcript_get_timings
+ */
+typedef enum {
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_LOOKUP,	/**< Looking up contributions by time */
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_FORMAT,	/**< Applying format rules to contributions */
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_LAYOUT,	/**< Laying out contributions */
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_DRAW,	/**< Drawing and copying, i.e. everything else */
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_REDRAW,	/**< Whole update of the widget's contents */
+	GTK_EXPERIMENT_TRANSCRIPT_PHASE_EXPOSE,	/**< Copying the contents to the screen */
+	GTK_EXPERIMENT_TRANSCRIPT_N_PHASES	/**< @private */
+} GtkExperimentTranscriptPhase;
+
+/**
+ * Events counted when profiling a \e GtkExperimentTranscript
+ *
+ * @sa gtk_experiment_transcript_get_count
+ */
+typedef enum {
+	GTK_EXPERIMENT_TRANSCRIPT_COUNT_LAYOUTS,	/**< Contributions laid out */
+	GTK_EXPERIMENT_TRANSCRIPT_COUNT_LAYOUT_HITS,	/**< Layouts found in the layout cache */
+	GTK_EXPERIMENT_TRANSCRIPT_COUNT_TILES,		/**< Tiles rendered */
+	GTK_EXPERIMENT_TRANSCRIPT_COUNT_TILE_HITS,	/**< Tiles found in the tile cache */
+	GTK_EXPERIMENT_TRANSCRIPT_N_COUNTS		/**< @private */
+} GtkExperimentTranscriptCount;
+
+/**
+ * Distribution of the durations of a phase
+ *
+ * @sa gtk_experiment_transcript_get_timings
+ */
+typedef struct _GtkExperimentTranscriptTimings {
+	guint	samples;	/**< Number of updates (or exposes) timed */
+	gint64	min;		/**< Minimum duration in microseconds */
+	gint64	max;		/**< Maximum duration in microseconds */
+	gdouble	mean;		/**< Mean duration in microseconds */
+	gint64	p95;		/**< 95th percentile in microseconds (approximated) */
+	gint64	p99;		/**< 99th percentile in microseconds (approximated) */
+} GtkExperimentTranscriptTimings;
+
 /** \e GtkExperimentTranscript type */
 #define GTK_TYPE_EXPERIMENT_TRANSCRIPT \
 	(gtk_experiment_transcript_get_type())
@@ -96,6 +139,15 @@ typedef struct _GtkExperimentTranscript {
  */
 typedef struct _GtkExperimentTranscriptClass {
 	GtkWidgetClass parent_class;	/**< Parent class structure */
+
+	/**
+	 * Callback function to invoke when emitting the "scale-changed"
+	 * signal.
+	 *
+	 * @param self  \e GtkExperimentTranscript the event was emitted on.
+	 * @param scale New scale in milliseconds per pixel
+	 */
+	void (*scale_changed)(GtkExperimentTranscript *self, guint scale);
 } GtkExperimentTranscriptClass;
 
 /** @private */
@@ -110,8 +162,17 @@ GtkWidget *gtk_experiment_transcript_new(const gchar *speaker);
 
 gboolean gtk_experiment_transcript_load(GtkExperimentTranscript *trans,
 					ExperimentReader *exp);
+gboolean gtk_experiment_transcript_load_tables(GtkExperimentTranscript *trans,
+					       GHashTable *tables);
 gboolean gtk_experiment_transcript_load_filename(GtkExperimentTranscript *trans,
 						 const gchar *filename);
+void gtk_experiment_transcript_load_filename_async(GtkExperimentTranscript *trans,
+						   const gchar *filename,
+						   GAsyncReadyCallback callback,
+						   gpointer user_data);
+gboolean gtk_experiment_transcript_load_filename_finish(GtkExperimentTranscript *trans,
+							GAsyncResult *result,
+							GError **error);
 
 void gtk_experiment_transcript_set_use_backdrop_area(GtkExperimentTranscript *trans,
 						     gboolean use);
@@ -135,6 +196,37 @@ gboolean gtk_experiment_transcript_set_interactive_format(GtkExperimentTranscrip
 							  gboolean with_markup,
 							  GError **error);
 
+void gtk_experiment_transcript_set_scale(GtkExperimentTranscript *trans,
+					 guint scale);
+guint gtk_experiment_transcript_get_scale(GtkExperimentTranscript *trans);
+
+void gtk_experiment_transcript_set_layout_cache_size(GtkExperimentTranscript *trans,
+						     gsize size);
+gsize gtk_experiment_transcript_get_layout_cache_size(GtkExperimentTranscript *trans);
+
+void gtk_experiment_transcript_set_use_cairo(GtkExperimentTranscript *trans,
+					     gboolean use);
+gboolean gtk_experiment_transcript_get_use_cairo(GtkExperimentTranscript *trans);
+
+void gtk_experiment_transcript_set_redraw_rate(GtkExperimentTranscript *trans,
+					       guint rate);
+guint gtk_experiment_transcript_get_redraw_rate(GtkExperimentTranscript *trans);
+void gtk_experiment_transcript_get_redraw_stats(GtkExperimentTranscript *trans,
+						guint *performed, guint *skipped);
+
+void gtk_experiment_transcript_set_profiling(GtkExperimentTranscript *trans,
+					     gboolean enable);
+gboolean gtk_experiment_transcript_get_profiling(GtkExperimentTranscript *trans);
+void gtk_experiment_transcript_set_profile_dump_interval(GtkExperimentTranscript *trans,
+							 guint seconds);
+gboolean gtk_experiment_transcript_get_timings(GtkExperimentTranscript *trans,
+					       GtkExperimentTranscriptPhase phase,
+					       GtkExperimentTranscriptTimings *timings);
+guint gtk_experiment_transcript_get_count(GtkExperimentTranscript *trans,
+					  GtkExperimentTranscriptCount count);
+void gtk_experiment_transcript_reset_profile(GtkExperimentTranscript *trans);
+void gtk_experiment_transcript_dump_profile(GtkExperimentTranscript *trans);
+
 GtkAdjustment *gtk_experiment_transcript_get_time_adjustment(GtkExperimentTranscript *trans);
 void gtk_experiment_transcript_set_time_adjustment(GtkExperimentTranscript *trans,
 						   GtkAdjustment *adj);
@@ -0,0 +1,310 @@
+/**
+ * @file
+ * Benchmark of transcript format rule matching.
+ *
+ * Generates format files with an increasing number of rules (mostly
+ * keywords, some regular expressions) and times highlighting a set of
+ * random contribution texts, applying the rules one by one and applying
+ * the compiled rule set. Both must produce the same attributes.
+ * Results are written as tab-separated values, one line per measurement.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <gtk/gtk.h>
+
+#include "gtk-experiment-transcript-private.h"
+
+/** Number of words per generated text */
+#define TEXT_WORDS	12
+
+static const gchar *words[] = {
+	"Lorem", "ipsum", "dolor", "sit", "amet", "consetetur", "sadipscing",
+	"elitr", "sed", "diam", "nonumy", "eirmod", "tempor", "invidunt",
+	"ut", "labore", "et", "dolore", "magna", "aliquyam", "erat"
+};
+
+static gchar *opt_rules = NULL;
+static gint opt_texts = 10000;
+static gint opt_repeat = 3;
+static gchar *opt_output = NULL;
+
+static GOptionEntry entries[] = {
+	{"rules", 'n', 0, G_OPTION_ARG_STRING, &opt_rules,
+	 "Comma-separated numbers of format rules (default: 10,50,200)", "LIST"},
+	{"texts", 't', 0, G_OPTION_ARG_INT, &opt_texts,
+	 "Number of texts to highlight (default: 10000)", "N"},
+	{"repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+	 "Repeat each measurement N times, reporting the minimum (default: 3)",
+	 "N"},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	 "Write results to FILE instead of standard output", "FILE"},
+	{NULL}
+};
+
+static gchar **generate_texts(guint n);
+static gchar *write_formats(guint n_rules);
+static gboolean append_attribute(PangoAttribute *attrib, gpointer data);
+static gchar *attr_list_to_string(PangoAttrList *attrib_list);
+static gdouble highlight(GSList *formats, GtkExperimentTranscriptRuleSet *set,
+			 gchar **texts, GPtrArray *results);
+
+static gchar **
+generate_texts(guint n)
+{
+	GRand *rand = g_rand_new_with_seed(1);
+	gchar **texts = g_new(gchar *, n + 1);
+
+	for (guint i = 0; i < n; i++) {
+		GString *str = g_string_new(NULL);
+
+		for (guint j = 0; j < TEXT_WORDS; j++) {
+			if (j)
+				g_string_append_c(str, ' ');
+			g_string_append(str,
+					words[g_rand_int_range(rand, 0,
+							       G_N_ELEMENTS(words))]);
+		}
+		texts[i] = g_string_free(str, FALSE);
+	}
+	texts[n] = NULL;
+
+	g_rand_free(rand);
+	return texts;
+}
+
+/**
+ * Write format file into a temporary file.
+ * Every fifth rule is a regular expression, the others are keywords,
+ * some of them occurring in the texts, some not.
+ *
+ * @return Name of temporary file (must be unlinked and freed) or
+ *         \c NULL on error
+ */
+static gchar *
+write_formats(guint n_rules)
+{
+	gchar *filename;
+	FILE *file;
+	gint fd;
+
+	fd = g_file_open_tmp("formats-XXXXXX.txt", &filename, NULL);
+	if (fd < 0)
+		return NULL;
+	file = fdopen(fd, "w");
+	if (file == NULL) {
+		close(fd);
+		g_unlink(filename);
+		g_free(filename);
+		return NULL;
+	}
+
+	fputs("# generated by format-benchmark\n", file);
+	for (guint i = 0; i < n_rules; i++) {
+		const gchar *word = words[i % G_N_ELEMENTS(words)];
+
+		if (i % 5 == 4)
+			fprintf(file, "<u>%c[a-z]+%c</u>\n",
+				word[0], word[1]);
+		else if (i < G_N_ELEMENTS(words))
+			fprintf(file, "<b>%s</b> %s\n",
+				word, words[(i + 1) % G_N_ELEMENTS(words)]);
+		else
+			fprintf(file, "<i>%s%u</i>\n", word, i);
+	}
+
+	fclose(file);
+	return filename;
+}
+
+static gboolean
+append_attribute(PangoAttribute *attrib, gpointer data)
+{
+	g_string_append_printf((GString *)data, "%d:%u-%u;",
+			       (gint)attrib->klass->type,
+			       attrib->start_index, attrib->end_index);
+
+	/* do not filter anything */
+	return FALSE;
+}
+
+static gchar *
+attr_list_to_string(PangoAttrList *attrib_list)
+{
+	GString *str = g_string_new(NULL);
+
+	pango_attr_list_filter(attrib_list, append_attribute, str);
+
+	return g_string_free(str, FALSE);
+}
+
+/**
+ * Highlight all texts, either using the per-rule loop (if \e set is
+ * \c NULL) or the rule set.
+ *
+ * @param results Array to append string representations of the
+ *                attribute lists to or \c NULL
+ * @return Elapsed time in seconds
+ */
+static gdouble
+highlight(GSList *formats, GtkExperimentTranscriptRuleSet *set,
+	  gchar **texts, GPtrArray *results)
+{
+	GTimer *timer = g_timer_new();
+	gdouble elapsed;
+
+	for (gchar **text = texts; *text != NULL; text++) {
+		PangoAttrList *attrib_list = pango_attr_list_new();
+
+		if (set == NULL) {
+			for (GSList *cur = formats; cur != NULL; cur = cur->next)
+				gtk_experiment_transcript_apply_format((GtkExperimentTranscriptFormat *)cur->data,
+								       *text,
+								       attrib_list);
+		} else {
+			gtk_experiment_transcript_rule_set_apply(set, *text,
+								 attrib_list);
+		}
+
+		if (results != NULL)
+			g_ptr_array_add(results,
+					attr_list_to_string(attrib_list));
+		pango_attr_list_unref(attrib_list);
+	}
+
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	return elapsed;
+}
+
+/** @private */
+int
+main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar **rules, **texts;
+	FILE *out = stdout;
+	gint ret = EXIT_SUCCESS;
+
+	g_type_init();
+
+	context = g_option_context_new("- benchmark transcript format rules");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	opt_repeat = MAX(opt_repeat, 1);
+
+	if (opt_output != NULL) {
+		out = g_fopen(opt_output, "w");
+		if (out == NULL) {
+			g_printerr("Cannot open \"%s\"\n", opt_output);
+			return EXIT_FAILURE;
+		}
+	}
+
+#ifdef PACKAGE_STRING
+	fprintf(out, "# %s\n", PACKAGE_STRING);
+#endif
+	fputs("rules\tmode\tops\tseconds\tns_per_op\n", out);
+
+	texts = generate_texts((guint)MAX(opt_texts, 1));
+
+	rules = g_strsplit(opt_rules != NULL ? opt_rules : "10,50,200",
+			   ",", 0);
+	for (gchar **p = rules; *p != NULL; p++) {
+		guint n_rules = (guint)g_ascii_strtoull(*p, NULL, 10);
+		gchar *filename;
+		GSList *formats;
+		GtkExperimentTranscriptRuleSet *set;
+		GPtrArray *expected, *actual;
+		gdouble loop = G_MAXDOUBLE, compiled = G_MAXDOUBLE;
+		guint n_texts = g_strv_length(texts);
+
+		filename = write_formats(n_rules);
+		if (filename == NULL) {
+			g_printerr("Cannot write format file\n");
+			return EXIT_FAILURE;
+		}
+		if (!gtk_experiment_transcript_read_formats(filename, &formats,
+							    &error)) {
+			g_printerr("%s\n", error->message);
+			return EXIT_FAILURE;
+		}
+		g_unlink(filename);
+		g_free(filename);
+
+		set = gtk_experiment_transcript_rule_set_new(formats);
+
+		/* both must result in the same attributes */
+		expected = g_ptr_array_new_with_free_func(g_free);
+		actual = g_ptr_array_new_with_free_func(g_free);
+		highlight(formats, NULL, texts, expected);
+		highlight(formats, set, texts, actual);
+		for (guint i = 0; i < n_texts; i++) {
+			if (g_strcmp0(expected->pdata[i], actual->pdata[i])) {
+				g_printerr("Mismatch for %u rules in \"%s\":\n"
+					   "per-rule: %s\nrule set: %s\n",
+					   n_rules, texts[i],
+					   (gchar *)expected->pdata[i],
+					   (gchar *)actual->pdata[i]);
+				ret = EXIT_FAILURE;
+				break;
+			}
+		}
+		g_ptr_array_free(expected, TRUE);
+		g_ptr_array_free(actual, TRUE);
+
+		for (gint r = 0; r < opt_repeat; r++) {
+			loop = MIN(loop, highlight(formats, NULL, texts, NULL));
+			compiled = MIN(compiled, highlight(formats, set, texts, NULL));
+		}
+
+		fprintf(out, "%u\tper_rule\t%u\t%.6f\t%.1f\n",
+			n_rules, n_texts, loop, loop*1e9/n_texts);
+		fprintf(out, "%u\trule_set\t%u\t%.6f\t%.1f\n",
+			n_rules, n_texts, compiled, compiled*1e9/n_texts);
+		fflush(out);
+
+		gtk_experiment_transcript_rule_set_free(set);
+		gtk_experiment_transcript_free_formats(formats);
+	}
+	g_strfreev(rules);
+	g_strfreev(texts);
+
+	if (out != stdout)
+		fclose(out);
+
+	return ret;
+}
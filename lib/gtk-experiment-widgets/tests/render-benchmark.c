@@ -0,0 +1,291 @@
+/**
+ * @file
+ * Benchmark of transcript rendering backends.
+ *
+ * Loads a generated session into a transcript widget in an offscreen
+ * window and times jumps to random points of time (with all tiles
+ * discarded, so the text layer is rendered from scratch) as well as
+ * playback at 60 frames per second (scrolling the text layer), drawing
+ * with GDK and with cairo, each without and with the layout cache.
+ * Requires a display. Results are written as tab-separated values,
+ * one line per measurement.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <gtk/gtk.h>
+
+#include <experiment-reader.h>
+
+#include "gtk-experiment-transcript.h"
+#include "gtk-experiment-transcript-private.h"
+#include "session-generator.h"
+
+/** Speaker whose contributions are rendered */
+#define SPEAKER		"Wizard"
+
+/** Backends to benchmark */
+static const struct {
+	const gchar	*name;
+	gboolean	use_cairo;
+} backends[] = {
+	{"gdk",		FALSE},
+	{"cairo",	TRUE}
+};
+
+/** Layout cache sizes to benchmark */
+static const struct {
+	const gchar	*name;
+	gsize		size;
+} layout_caches[] = {
+	{"none",	0},
+	{"default",	DEFAULT_LAYOUT_CACHE_SIZE}
+};
+
+static gint opt_frames = 500;
+static gint opt_width = 300;
+static gint opt_height = 600;
+static gint opt_repeat = 3;
+static gdouble opt_scale = 1.;
+static gchar *opt_output = NULL;
+
+static GOptionEntry entries[] = {
+	{"frames", 'f', 0, G_OPTION_ARG_INT, &opt_frames,
+	 "Number of frames per measurement (default: 500)", "N"},
+	{"width", 'W', 0, G_OPTION_ARG_INT, &opt_width,
+	 "Width of transcript widget (default: 300)", "PIXELS"},
+	{"height", 'H', 0, G_OPTION_ARG_INT, &opt_height,
+	 "Height of transcript widget (default: 600)", "PIXELS"},
+	{"repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+	 "Repeat each measurement N times, reporting the minimum (default: 3)",
+	 "N"},
+	{"scale", 's', 0, G_OPTION_ARG_DOUBLE, &opt_scale,
+	 "Scale factor of the generated session (default: 1)", "FACTOR"},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	 "Write results to FILE instead of standard output", "FILE"},
+	{NULL}
+};
+
+static void flush_display(void);
+static gdouble jump(GtkExperimentTranscript *trans, GRand *rand,
+		    gint64 length);
+static gdouble play(GtkExperimentTranscript *trans, GRand *rand,
+		    gint64 length);
+
+/**
+ * Wait until the X server has executed all drawing requests, so that
+ * server-side rendering is measured as well
+ */
+static void
+flush_display(void)
+{
+	while (gtk_events_pending())
+		gtk_main_iteration();
+	gdk_display_sync(gdk_display_get_default());
+}
+
+/**
+ * Set the widget's time to random points of time, rendering each one
+ * from scratch.
+ *
+ * @return Elapsed time in seconds
+ */
+static gdouble
+jump(GtkExperimentTranscript *trans, GRand *rand, gint64 length)
+{
+	GtkAdjustment *adj = gtk_experiment_transcript_get_time_adjustment(trans);
+	GTimer *timer = g_timer_new();
+	gdouble elapsed;
+
+	for (gint i = 0; i < opt_frames; i++) {
+		gtk_experiment_transcript_flush_tiles(trans);
+		gtk_adjustment_set_value(adj,
+					 (gdouble)g_rand_int_range(rand, 0,
+								   (gint32)MIN(length, G_MAXINT32)));
+	}
+	flush_display();
+
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	return elapsed;
+}
+
+/**
+ * Advance the widget's time like playback at 60 frames per second,
+ * starting at a random point of time.
+ *
+ * @return Elapsed time in seconds
+ */
+static gdouble
+play(GtkExperimentTranscript *trans, GRand *rand, gint64 length)
+{
+	GtkAdjustment *adj = gtk_experiment_transcript_get_time_adjustment(trans);
+	gint64 time = g_rand_int_range(rand, 0,
+				       (gint32)MIN(length/2, G_MAXINT32));
+	GTimer *timer;
+	gdouble elapsed;
+
+	gtk_adjustment_set_value(adj, (gdouble)time);
+	flush_display();
+
+	timer = g_timer_new();
+
+	for (gint i = 0; i < opt_frames; i++) {
+		time += 1000/60;
+		gtk_adjustment_set_value(adj, (gdouble)time);
+	}
+	flush_display();
+
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	return elapsed;
+}
+
+/** @private */
+int
+main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	FILE *out = stdout;
+
+	SessionGeneratorParams params;
+	gchar *filename;
+	GtkWidget *window, *widget;
+	GtkExperimentTranscript *trans;
+	ExperimentReaderContribTable *contribs;
+	gint64 length;
+
+	context = g_option_context_new("- benchmark transcript rendering");
+	g_option_context_add_main_entries(context, entries, NULL);
+	g_option_context_add_group(context, gtk_get_option_group(FALSE));
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	opt_frames = MAX(opt_frames, 1);
+	opt_repeat = MAX(opt_repeat, 1);
+	opt_scale = MAX(opt_scale, 0.01);
+
+	if (!gtk_init_check(&argc, &argv)) {
+		g_printerr("Cannot open display\n");
+		return EXIT_FAILURE;
+	}
+
+	if (opt_output != NULL) {
+		out = g_fopen(opt_output, "w");
+		if (out == NULL) {
+			g_printerr("Cannot open \"%s\"\n", opt_output);
+			return EXIT_FAILURE;
+		}
+	}
+
+	session_generator_params_init(&params);
+	session_generator_params_scale(&params, opt_scale);
+	filename = session_generator_write_tmp(&params);
+	if (filename == NULL) {
+		g_printerr("Cannot write session file\n");
+		return EXIT_FAILURE;
+	}
+
+	window = gtk_offscreen_window_new();
+	widget = gtk_experiment_transcript_new(SPEAKER);
+	trans = GTK_EXPERIMENT_TRANSCRIPT(widget);
+	gtk_widget_set_size_request(widget, opt_width, opt_height);
+	gtk_container_add(GTK_CONTAINER(window), widget);
+	gtk_widget_show_all(window);
+
+	if (!gtk_experiment_transcript_load_filename(trans, filename)) {
+		g_printerr("Cannot load \"%s\"\n", filename);
+		g_unlink(filename);
+		return EXIT_FAILURE;
+	}
+	g_unlink(filename);
+	g_free(filename);
+
+	/* render every time change, the benchmark is the frame clock */
+	gtk_experiment_transcript_set_redraw_rate(trans, 0);
+	flush_display();
+
+	contribs = trans->priv->contribs;
+	length = experiment_reader_contrib_table_get_end_time(contribs,
+							      contribs->n_contribs - 1);
+
+	/* the backdrop area is drawn differently by both backends */
+	gtk_experiment_transcript_set_use_backdrop_area(trans, TRUE);
+	gtk_experiment_transcript_set_backdrop_area(trans, length/4, length*3/4);
+
+#ifdef PACKAGE_STRING
+	fprintf(out, "# %s\n", PACKAGE_STRING);
+#endif
+	fputs("backend\tlayout_cache\tmode\tops\tseconds\tus_per_op\n", out);
+
+	for (guint b = 0; b < G_N_ELEMENTS(backends); b++) {
+		gtk_experiment_transcript_set_use_cairo(trans,
+							backends[b].use_cairo);
+
+		for (guint c = 0; c < G_N_ELEMENTS(layout_caches); c++) {
+			gdouble jumps = G_MAXDOUBLE, frames = G_MAXDOUBLE;
+
+			/* start with an empty cache */
+			gtk_experiment_transcript_set_layout_cache_size(trans, 0);
+			gtk_experiment_transcript_set_layout_cache_size(trans,
+									layout_caches[c].size);
+
+			for (gint r = 0; r < opt_repeat; r++) {
+				/* equal seeds, so all runs render the same frames */
+				GRand *rand = g_rand_new_with_seed((guint32)r);
+
+				jumps = MIN(jumps, jump(trans, rand, length));
+				frames = MIN(frames, play(trans, rand, length));
+
+				g_rand_free(rand);
+			}
+
+			fprintf(out, "%s\t%s\tjump\t%d\t%.6f\t%.1f\n",
+				backends[b].name, layout_caches[c].name,
+				opt_frames, jumps, jumps*1e6/opt_frames);
+			fprintf(out, "%s\t%s\tplay\t%d\t%.6f\t%.1f\n",
+				backends[b].name, layout_caches[c].name,
+				opt_frames, frames, frames*1e6/opt_frames);
+			fflush(out);
+		}
+	}
+
+	gtk_widget_destroy(window);
+
+	if (out != stdout)
+		fclose(out);
+
+	return EXIT_SUCCESS;
+}
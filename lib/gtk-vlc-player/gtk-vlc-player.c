@@ -52,15 +52,18 @@
 #include "gtk-vlc-player.h"
 
 static void gtk_vlc_player_class_init(GtkVlcPlayerClass *klass);
-static inline libvlc_instance_t *create_vlc_instance(void);
+static inline libvlc_instance_t *create_vlc_instance(const gchar *const *args);
+static libvlc_instance_t *shared_vlc_instance_ref(void);
+static void vlc_instance_unref(libvlc_instance_t *inst);
 static void gtk_vlc_player_init(GtkVlcPlayer *klass);
 
+static void gtk_vlc_player_set_property(GObject *gobject, guint prop_id,
+					const GValue *value,
+					GParamSpec *pspec);
+static void gtk_vlc_player_constructed(GObject *gobject);
 static void gtk_vlc_player_dispose(GObject *gobject);
 static void gtk_vlc_player_finalize(GObject *gobject);
 
-static inline void maybe_lock_gdk(void);
-static inline void maybe_unlock_gdk(void);
-
 #ifdef G_OS_WIN32
 static BOOL CALLBACK enumerate_vlc_windows_cb(HWND hWndvlc, LPARAM lParam);
 static gboolean poll_vlc_event_window_cb(gpointer data);
@@ -83,12 +86,93 @@ static void vlc_time_changed(const struct libvlc_event_t *event,
 			     void *userdata);
 static void vlc_length_changed(const struct libvlc_event_t *event,
 			       void *userdata);
+static void vlc_state_changed(const struct libvlc_event_t *event,
+			      void *userdata);
+static void vlc_media_parsed_changed(const struct libvlc_event_t *event,
+				     void *userdata);
+
+static void events_attach(GtkVlcPlayer *player);
+static void events_detach(GtkVlcPlayer *player);
+static void events_post(GtkVlcPlayer *player, guint event,
+			volatile gint *slot, gint value);
+static gboolean events_dispatch_cb(gpointer user_data);
+static void dispatch_time(GtkVlcPlayer *player, gint serial,
+			  gint64 new_time);
+static void dispatch_state(GtkVlcPlayer *player, gint type);
+static void dispatch_parsed(GtkVlcPlayer *player, gint serial);
+
+static gint64 clock_get_time(GtkVlcPlayer *player);
+static void clock_sync(GtkVlcPlayer *player, gint64 time);
+static void clock_start(GtkVlcPlayer *player);
+static void clock_stop(GtkVlcPlayer *player);
+static gboolean clock_timeout_cb(gpointer user_data);
+
+static void seek_issue(GtkVlcPlayer *player, gint64 time);
+static void seek_finish(GtkVlcPlayer *player, gboolean landed);
+static void seek_reset(GtkVlcPlayer *player);
+static gboolean seek_timeout_cb(gpointer user_data);
 
 static void vlc_player_load_media(GtkVlcPlayer *player, libvlc_media_t *media);
+static void vlc_player_load_media_async(GtkVlcPlayer *player,
+					libvlc_media_t *media);
+static void load_cancel(GtkVlcPlayer *player);
+
+static void preload_trim(GtkVlcPlayer *player, guint limit);
+static libvlc_media_t *preload_take(GtkVlcPlayer *player, const gchar *file);
 
 /** @private */
 #define POLL_VLC_EVENT_WINDOW_INTERVAL 100 /* milliseconds */
 
+/** @private */
+#define DEFAULT_CLOCK_RATE		60	/* Hz */
+/**
+ * @private
+ * Maximum time the playback clock may run ahead of the last time
+ * reported by VLC, e.g. while VLC is buffering
+ */
+#define CLOCK_MAX_EXTRAPOLATION	1000	/* milliseconds */
+
+/**
+ * @private
+ * Maximum difference between a seek's target and the time reported by
+ * VLC for considering the seek done
+ */
+#define SEEK_TOLERANCE		1000	/* milliseconds */
+/**
+ * @private
+ * Time after which a seek is considered done even if VLC did not
+ * report it, e.g. because no media is playing.
+ * Such seeks are not counted as landed.
+ */
+#define SEEK_TIMEOUT		500	/* milliseconds */
+
+/**
+ * @private
+ * VLC events handled by the widget
+ */
+static const struct {
+	libvlc_event_type_t	type;
+	libvlc_callback_t	callback;
+} vlc_events[] = {
+	{libvlc_MediaPlayerTimeChanged,		vlc_time_changed},
+	{libvlc_MediaPlayerLengthChanged,	vlc_length_changed},
+	{libvlc_MediaPlayerPlaying,		vlc_state_changed},
+	{libvlc_MediaPlayerPaused,		vlc_state_changed},
+	{libvlc_MediaPlayerStopped,		vlc_state_changed},
+	{libvlc_MediaPlayerEndReached,		vlc_state_changed}
+};
+
+/**
+ * @private
+ * Bits of events posted by VLC callbacks
+ */
+enum {
+	EVENT_TIME	= 1 << 0,
+	EVENT_LENGTH	= 1 << 1,
+	EVENT_STATE	= 1 << 2,
+	EVENT_PARSED	= 1 << 3
+};
+
 /** @private */
 #define GOBJECT_UNREF_SAFE(VAR) G_STMT_START {	\
 	if ((VAR) != NULL) {			\
@@ -110,20 +194,116 @@ struct _GtkVlcPlayerPrivate {
 	GtkObject		*volume_adjustment;
 	gulong			vol_adj_on_value_changed_id;
 
+	gchar			**vlc_args;	/**< libVLC arguments until construction or \c NULL */
 	libvlc_instance_t	*vlc_inst;
 	libvlc_media_player_t	*media_player;
 
 	gboolean		isFullscreen;
 	GtkWidget		*fullscreen_window;
+
+	/**
+	 * Latest values posted by VLC callbacks (possibly in other
+	 * threads), dispatched in the main loop.
+	 * The pending mask and value slots are only accessed atomically.
+	 */
+	struct _GtkVlcPlayerEvents {
+		gboolean	attached;	/**< Callbacks are attached to VLC events */
+		volatile guint	pending;	/**< Mask of events posted since last dispatch */
+		gboolean	disposed;	/**< Widget was disposed, events are no longer dispatched */
+
+		volatile gint	time;		/**< Latest time (milliseconds) */
+		volatile gint	time_serial;	/**< Serial of latest seek issued when \e time was posted */
+		volatile gint	length;		/**< Latest length (milliseconds) */
+		volatile gint	state;		/**< Latest state event type */
+		volatile gint	parsed;		/**< Serial of latest media parsed */
+	} events;
+
+	/** Asynchronous media loading */
+	struct _GtkVlcPlayerLoad {
+		libvlc_media_t	*media;		/**< Media being parsed or \c NULL */
+		gint		serial;		/**< Serial of latest load, identifies its media */
+	} load;
+
+	/** Media parsed in the background for later loads */
+	struct _GtkVlcPlayerPreload {
+		GQueue		queue;		/**< Preloaded media, most recent first */
+		guint		limit;		/**< Maximum number of preloaded media */
+	} preload;
+
+	/** Playback clock interpolating between VLC time events */
+	struct _GtkVlcPlayerClock {
+		guint		rate;		/**< Updates per second, 0 disables interpolation */
+		guint		timeout_id;	/**< Update timeout or 0 */
+		gboolean	playing;
+
+		gint64		sync_time;	/**< Media time at last synchronization (milliseconds) */
+		gint64		sync_clock;	/**< Monotonic time at last synchronization (microseconds) */
+		gfloat		speed;		/**< Playback rate at last synchronization */
+
+		gint64		time;		/**< Last published time (milliseconds) */
+		gint64		length;		/**< Media length (milliseconds) */
+	} clock;
+
+	/**
+	 * Seek scheduling: Only one seek is passed to VLC at a time,
+	 * seeks requested meanwhile are coalesced into the latest one
+	 */
+	struct _GtkVlcPlayerSeek {
+		gboolean	in_flight;	/**< Seek was passed to VLC, but is not done yet */
+		/**
+		 * Serial of latest seek passed to VLC. Read by VLC
+		 * callbacks to tag time events, so only accessed
+		 * atomically.
+		 */
+		volatile gint	serial;
+		gint64		target;		/**< Target of seek in flight (milliseconds) */
+		gint64		issued_at;	/**< Monotonic time seek in flight was passed to VLC */
+		guint		timeout_id;	/**< Source Id of seek timeout or 0 */
+
+		gboolean	pending;	/**< Seek was requested while another was in flight */
+		gint64		pending_target;	/**< Target of latest seek requested (milliseconds) */
+
+		guint		requested;	/**< Number of seeks requested */
+		guint		issued;		/**< Number of seeks passed to VLC */
+		guint		landed;		/**< Number of seeks reported done by VLC */
+		guint		timed_out;	/**< Number of seeks not reported done within \ref SEEK_TIMEOUT */
+		gint64		latency;	/**< Total time from passing to VLC until reported done (microseconds) */
+	} seek;
+};
+
+/**
+ * @private
+ * Media preloaded by \ref gtk_vlc_player_preload_filename
+ */
+typedef struct {
+	gchar		*file;		/**< Filename of media */
+	libvlc_media_t	*media;		/**< Media, parsed or being parsed */
+} GtkVlcPlayerPreloaded;
+
+/** @private */
+enum {
+	PROP_0,
+	PROP_VLC_ARGS
 };
 
 /** @private */
 enum {
 	TIME_CHANGED_SIGNAL,
 	LENGTH_CHANGED_SIGNAL,
+	LOAD_FINISHED_SIGNAL,
 	LAST_SIGNAL
 };
-static guint gtk_vlc_player_signals[LAST_SIGNAL] = {0, 0};
+static guint gtk_vlc_player_signals[LAST_SIGNAL] = {0, 0, 0};
+
+/**
+ * @private
+ * libVLC instance shared by all player widgets not created with
+ * arguments, since creating an instance is expensive
+ */
+static libvlc_instance_t *shared_vlc_inst = NULL;
+/** @private Number of player widgets using \ref shared_vlc_inst */
+static guint shared_vlc_inst_refs = 0;
+G_LOCK_DEFINE_STATIC(shared_vlc_inst);
 
 /**
  * @private
@@ -137,9 +317,20 @@ gtk_vlc_player_class_init(GtkVlcPlayerClass *klass)
 {
 	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
 
+	gobject_class->set_property = gtk_vlc_player_set_property;
+	gobject_class->constructed = gtk_vlc_player_constructed;
 	gobject_class->dispose = gtk_vlc_player_dispose;
 	gobject_class->finalize = gtk_vlc_player_finalize;
 
+	g_object_class_install_property(gobject_class, PROP_VLC_ARGS,
+		g_param_spec_boxed("vlc-args",
+				   "libVLC arguments",
+				   "libVLC command line arguments of a separate "
+				   "libVLC instance (shared instance if empty)",
+				   G_TYPE_STRV,
+				   G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY |
+				   G_PARAM_STATIC_STRINGS));
+
 	gtk_vlc_player_signals[TIME_CHANGED_SIGNAL] =
 		g_signal_new("time-changed",
 			     G_TYPE_FROM_CLASS(klass),
@@ -158,29 +349,42 @@ gtk_vlc_player_class_init(GtkVlcPlayerClass *klass)
 			     gtk_vlc_player_marshal_VOID__INT64,
 			     G_TYPE_NONE, 1, G_TYPE_INT64);
 
+	gtk_vlc_player_signals[LOAD_FINISHED_SIGNAL] =
+		g_signal_new("load-finished",
+			     G_TYPE_FROM_CLASS(klass),
+			     G_SIGNAL_RUN_FIRST,
+			     G_STRUCT_OFFSET(GtkVlcPlayerClass, load_finished),
+			     NULL, NULL,
+			     g_cclosure_marshal_VOID__VOID,
+			     G_TYPE_NONE, 0);
+
 	g_type_class_add_private(klass, sizeof(GtkVlcPlayerPrivate));
 }
 
 static inline libvlc_instance_t *
-create_vlc_instance(void)
+create_vlc_instance(const gchar *const *args)
 {
 	gchar	**vlc_argv;
 	gint	vlc_argc = 0;
+	guint	n_args = args != NULL ? g_strv_length((gchar **)args) : 0;
 
 	libvlc_instance_t *ret;
 
-	vlc_argv = g_malloc_n(2, sizeof(vlc_argv[0]));
+	vlc_argv = g_malloc_n(1 + n_args + 1, sizeof(vlc_argv[0]));
 	vlc_argv[vlc_argc++] = g_strdup(g_get_prgname());
 
 #if LIBVLC_VERSION_INT < LIBVLC_VERSION(2,0,0,0)
 	if (g_getenv("VLC_PLUGIN_PATH") != NULL) {
 		vlc_argv = g_realloc_n(vlc_argv,
-				       vlc_argc + 2 + 1, sizeof(vlc_argv[0]));
+				       vlc_argc + 2 + n_args + 1,
+				       sizeof(vlc_argv[0]));
 		vlc_argv[vlc_argc++] = g_strdup("--plugin-path");
 		vlc_argv[vlc_argc++] = g_strdup(g_getenv("VLC_PLUGIN_PATH"));
 	}
 #endif
 
+	for (guint i = 0; i < n_args; i++)
+		vlc_argv[vlc_argc++] = g_strdup(args[i]);
 	vlc_argv[vlc_argc] = NULL;
 
 	ret = libvlc_new((int)vlc_argc, (const char *const *)vlc_argv);
@@ -189,12 +393,59 @@ create_vlc_instance(void)
 	return ret;
 }
 
+/**
+ * @private
+ * Get a reference to the shared libVLC instance, creating it for the
+ * first player widget.
+ *
+ * @return Shared libVLC instance or \c NULL if it cannot be created
+ */
+static libvlc_instance_t *
+shared_vlc_instance_ref(void)
+{
+	libvlc_instance_t *ret;
+
+	G_LOCK(shared_vlc_inst);
+
+	if (shared_vlc_inst == NULL)
+		shared_vlc_inst = create_vlc_instance(NULL);
+	if (shared_vlc_inst != NULL)
+		shared_vlc_inst_refs++;
+	ret = shared_vlc_inst;
+
+	G_UNLOCK(shared_vlc_inst);
+
+	return ret;
+}
+
+/**
+ * @private
+ * Release a player widget's libVLC instance.
+ * The shared instance is destroyed with its last reference.
+ */
+static void
+vlc_instance_unref(libvlc_instance_t *inst)
+{
+	if (inst == NULL)
+		return;
+
+	G_LOCK(shared_vlc_inst);
+
+	if (inst != shared_vlc_inst) {
+		libvlc_release(inst);
+	} else if (--shared_vlc_inst_refs == 0) {
+		libvlc_release(shared_vlc_inst);
+		shared_vlc_inst = NULL;
+	}
+
+	G_UNLOCK(shared_vlc_inst);
+}
+
 static void
 gtk_vlc_player_init(GtkVlcPlayer *klass)
 {
 	GtkWidget		*drawing_area;
 	GdkColor		color;
-	libvlc_event_manager_t	*evman;
 
 	klass->priv = GTK_VLC_PLAYER_GET_PRIVATE(klass);
 	gtk_alignment_set(GTK_ALIGNMENT(klass), 0., 0., 1., 1.);
@@ -244,16 +495,38 @@ gtk_vlc_player_init(GtkVlcPlayer *klass)
 				 "value-changed",
 				 G_CALLBACK(vol_adj_on_value_changed), klass);
 
-	klass->priv->vlc_inst = create_vlc_instance();
-	klass->priv->media_player = libvlc_media_player_new(klass->priv->vlc_inst);
-
-	/* sign up for time updates */
-	evman = libvlc_media_player_event_manager(klass->priv->media_player);
-
-	libvlc_event_attach(evman, libvlc_MediaPlayerTimeChanged,
-			    vlc_time_changed, klass);
-	libvlc_event_attach(evman, libvlc_MediaPlayerLengthChanged,
-			    vlc_length_changed, klass);
+	klass->priv->events.attached = FALSE;
+	klass->priv->events.pending = 0;
+	klass->priv->events.disposed = FALSE;
+	klass->priv->events.time_serial = 0;
+
+	/* libVLC instance is chosen when the construct properties are set */
+	klass->priv->vlc_args = NULL;
+	klass->priv->vlc_inst = NULL;
+	klass->priv->media_player = NULL;
+
+	klass->priv->load.media = NULL;
+	klass->priv->load.serial = 0;
+
+	g_queue_init(&klass->priv->preload.queue);
+	klass->priv->preload.limit = 0;
+
+	klass->priv->clock.rate = DEFAULT_CLOCK_RATE;
+	klass->priv->clock.timeout_id = 0;
+	klass->priv->clock.playing = FALSE;
+	klass->priv->clock.length = 0;
+	clock_sync(klass, 0);
+	klass->priv->clock.time = 0;
+
+	klass->priv->seek.in_flight = FALSE;
+	klass->priv->seek.serial = 0;
+	klass->priv->seek.pending = FALSE;
+	klass->priv->seek.timeout_id = 0;
+	klass->priv->seek.requested = 0;
+	klass->priv->seek.issued = 0;
+	klass->priv->seek.landed = 0;
+	klass->priv->seek.timed_out = 0;
+	klass->priv->seek.latency = 0;
 
 	klass->priv->isFullscreen = FALSE;
 	klass->priv->fullscreen_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -271,11 +544,76 @@ gtk_vlc_player_init(GtkVlcPlayer *klass)
 				  TRUE);
 }
 
+static void
+gtk_vlc_player_set_property(GObject *gobject, guint prop_id,
+			    const GValue *value, GParamSpec *pspec)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(gobject);
+
+	switch (prop_id) {
+	case PROP_VLC_ARGS:
+		g_strfreev(player->priv->vlc_args);
+		player->priv->vlc_args = g_value_dup_boxed(value);
+		break;
+
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(gobject, prop_id, pspec);
+		break;
+	}
+}
+
+/**
+ * @private
+ * Create the player's media player, using a separate libVLC instance
+ * if libVLC arguments were specified, else the shared one.
+ * The shared instance is also used if the separate one cannot be
+ * created.
+ */
+static void
+gtk_vlc_player_constructed(GObject *gobject)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(gobject);
+	libvlc_instance_t *inst = NULL;
+
+	if (player->priv->vlc_args != NULL && *player->priv->vlc_args != NULL)
+		inst = create_vlc_instance((const gchar *const *)player->priv->vlc_args);
+	if (inst == NULL)
+		inst = shared_vlc_instance_ref();
+	g_strfreev(player->priv->vlc_args);
+	player->priv->vlc_args = NULL;
+
+	player->priv->vlc_inst = inst;
+	player->priv->media_player = libvlc_media_player_new(inst);
+
+	/* sign up for time updates */
+	events_attach(player);
+
+	/* Chain up to the parent class */
+	if (G_OBJECT_CLASS(gtk_vlc_player_parent_class)->constructed != NULL)
+		G_OBJECT_CLASS(gtk_vlc_player_parent_class)->constructed(gobject);
+}
+
 static void
 gtk_vlc_player_dispose(GObject *gobject)
 {
 	GtkVlcPlayer *player = GTK_VLC_PLAYER(gobject);
 
+	/*
+	 * no more events will be posted after detaching, a dispatch
+	 * already added holds a reference and drops its events
+	 */
+	events_detach(player);
+	load_cancel(player);
+	preload_trim(player, 0);
+	player->priv->events.disposed = TRUE;
+
+	player->priv->clock.playing = FALSE;
+	if (player->priv->clock.timeout_id != 0) {
+		g_source_remove(player->priv->clock.timeout_id);
+		player->priv->clock.timeout_id = 0;
+	}
+	seek_reset(player);
+
 	/*
 	 * destroy might be called more than once, but we have only one
 	 * reference for each object
@@ -306,40 +644,12 @@ gtk_vlc_player_finalize(GObject *gobject)
 	GtkVlcPlayer *player = GTK_VLC_PLAYER(gobject);
 
 	libvlc_media_player_release(player->priv->media_player);
-	libvlc_release(player->priv->vlc_inst);
+	vlc_instance_unref(player->priv->vlc_inst);
 
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS(gtk_vlc_player_parent_class)->finalize(gobject);
 }
 
-/**
- * @brief Locks GDK mutex if necessary.
- *
- * When GTK+ functions are invoked from another than the main
- * thread (the one with the \e gtk_main() event loop),
- * \e gdk_threads_enter() must be called.
- * This auxiliary function is for callers (like VLC callbacks) that
- * may or may not be invoked from the main event loop to avoid dead locks.
- */
-static inline void
-maybe_lock_gdk(void)
-{
-	if (!g_main_context_is_owner(g_main_context_default()))
-		gdk_threads_enter();
-}
-
-/**
- * @brief Unlocks GDK mutex if necessary.
- *
- * @see maybe_lock_gdk
- */
-static inline void
-maybe_unlock_gdk(void)
-{
-	if (!g_main_context_is_owner(g_main_context_default()))
-		gdk_threads_leave();
-}
-
 #ifdef G_OS_WIN32
 
 static BOOL CALLBACK
@@ -489,6 +799,8 @@ update_time(GtkVlcPlayer *player, gint64 new_time)
 static void
 update_length(GtkVlcPlayer *player, gint64 new_length)
 {
+	player->priv->clock.length = new_length;
+
 	g_signal_emit(player, gtk_vlc_player_signals[LENGTH_CHANGED_SIGNAL], 0,
 		      new_length);
 
@@ -505,41 +817,583 @@ update_length(GtkVlcPlayer *player, gint64 new_length)
 	}
 }
 
+/*
+ * VLC callbacks may be invoked from another thread!
+ * They only post the event's value, so they never block on (or call
+ * into) GTK+.
+ */
+
+/**
+ * @private
+ * Posts the time tagged with the serial of the latest seek issued, so
+ * times VLC reported before that seek can be told apart.
+ * The time is set before its serial, see \ref events_dispatch_cb.
+ */
 static void
 vlc_time_changed(const struct libvlc_event_t *event, void *user_data)
 {
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+	libvlc_time_t new_time = event->u.media_player_time_changed.new_time;
+
 	assert(event->type == libvlc_MediaPlayerTimeChanged);
 
-	/* VLC callbacks may be invoked from another thread! */
-	maybe_lock_gdk();
-	update_time(GTK_VLC_PLAYER(user_data),
-		    (gint64)event->u.media_player_time_changed.new_time);
-	maybe_unlock_gdk();
+	g_atomic_int_set(&player->priv->events.time,
+			 (gint)CLAMP(new_time, 0, G_MAXINT));
+	events_post(player, EVENT_TIME, &player->priv->events.time_serial,
+		    g_atomic_int_get(&player->priv->seek.serial));
 }
 
 static void
 vlc_length_changed(const struct libvlc_event_t *event, void *user_data)
 {
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+	libvlc_time_t new_length = event->u.media_player_length_changed.new_length;
+
 	assert(event->type == libvlc_MediaPlayerLengthChanged);
 
-	/* VLC callbacks may be invoked from another thread! */
-	maybe_lock_gdk();
-	update_length(GTK_VLC_PLAYER(user_data),
-		      (gint64)event->u.media_player_length_changed.new_length);
-	maybe_unlock_gdk();
+	events_post(player, EVENT_LENGTH, &player->priv->events.length,
+		    (gint)CLAMP(new_length, 0, G_MAXINT));
 }
 
+static void
+vlc_state_changed(const struct libvlc_event_t *event, void *user_data)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+
+	events_post(player, EVENT_STATE, &player->priv->events.state,
+		    (gint)event->type);
+}
+
+/**
+ * @private
+ * Posts the serial of the load the media belongs to, so parse events
+ * of cancelled loads can be ignored.
+ */
+static void
+vlc_media_parsed_changed(const struct libvlc_event_t *event, void *user_data)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+	libvlc_media_t *media = (libvlc_media_t *)event->p_obj;
+
+	assert(event->type == libvlc_MediaParsedChanged);
+
+	events_post(player, EVENT_PARSED, &player->priv->events.parsed,
+		    GPOINTER_TO_INT(libvlc_media_get_user_data(media)));
+}
+
+/** @private */
+static void
+events_attach(GtkVlcPlayer *player)
+{
+	libvlc_event_manager_t *evman;
+
+	if (player->priv->events.attached)
+		return;
+
+	evman = libvlc_media_player_event_manager(player->priv->media_player);
+	for (guint i = 0; i < G_N_ELEMENTS(vlc_events); i++)
+		libvlc_event_attach(evman, vlc_events[i].type,
+				    vlc_events[i].callback, player);
+
+	player->priv->events.attached = TRUE;
+}
+
+/**
+ * @private
+ * Detach from VLC events. libVLC waits for callbacks in progress, so
+ * no events are posted afterwards.
+ */
+static void
+events_detach(GtkVlcPlayer *player)
+{
+	libvlc_event_manager_t *evman;
+
+	if (!player->priv->events.attached)
+		return;
+
+	evman = libvlc_media_player_event_manager(player->priv->media_player);
+	for (guint i = 0; i < G_N_ELEMENTS(vlc_events); i++)
+		libvlc_event_detach(evman, vlc_events[i].type,
+				    vlc_events[i].callback, player);
+
+	player->priv->events.attached = FALSE;
+}
+
+/**
+ * @private
+ * Post an event's value from any thread.
+ *
+ * The value replaces the last one posted for the same event, i.e.
+ * events are coalesced until they are dispatched by an idle source in
+ * the main loop. Only the first event posted since the last dispatch
+ * adds that source. It holds a reference to the widget, so the source
+ * never has to be removed from another thread.
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @param event  Event bit
+ * @param slot   Latest value slot of event
+ * @param value  New value of event
+ */
+static void
+events_post(GtkVlcPlayer *player, guint event,
+	    volatile gint *slot, gint value)
+{
+	struct _GtkVlcPlayerEvents *events = &player->priv->events;
+
+	g_atomic_int_set(slot, value);
+
+	if (g_atomic_int_or(&events->pending, event) == 0)
+		gdk_threads_add_idle_full(G_PRIORITY_HIGH_IDLE,
+					  events_dispatch_cb,
+					  g_object_ref(player), g_object_unref);
+}
+
+/**
+ * @private
+ * Idle callback dispatching the events posted since the last dispatch
+ * in the main loop.
+ * The priority is higher than that of redrawing, so widgets connected
+ * to the player are redrawn with the latest time.
+ * Events posted before the widget was disposed are dropped.
+ */
+static gboolean
+events_dispatch_cb(gpointer user_data)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+	struct _GtkVlcPlayerEvents *events = &player->priv->events;
+	guint pending;
+
+	/*
+	 * events posted from now on add another source, even if their
+	 * values are dispatched by this one already
+	 */
+	pending = g_atomic_int_and(&events->pending, 0);
+	if (events->disposed)
+		return FALSE;
+
+	if (pending & EVENT_LENGTH)
+		update_length(player, (gint64)g_atomic_int_get(&events->length));
+	if (pending & EVENT_PARSED)
+		dispatch_parsed(player, g_atomic_int_get(&events->parsed));
+	if (pending & EVENT_STATE)
+		dispatch_state(player, g_atomic_int_get(&events->state));
+	if (pending & EVENT_TIME) {
+		/*
+		 * the serial is read first: if it is that of a newer time
+		 * posted meanwhile, that time is read as well
+		 */
+		gint serial = g_atomic_int_get(&events->time_serial);
+
+		dispatch_time(player, serial,
+			      (gint64)g_atomic_int_get(&events->time));
+	}
+
+	return FALSE;
+}
+
+/**
+ * @private
+ * Publish time reported by VLC.
+ *
+ * Times posted before the latest seek was passed to VLC (tagged with
+ * an older \e serial) are for the position before that seek and are
+ * ignored. While a seek is in flight, VLC may still report times it
+ * computed before processing the seek, so only a time near its target
+ * finishes it.
+ */
+static void
+dispatch_time(GtkVlcPlayer *player, gint serial, gint64 new_time)
+{
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	if (serial != g_atomic_int_get(&seek->serial))
+		return;
+
+	if (seek->in_flight) {
+		if (ABS(new_time - seek->target) > SEEK_TOLERANCE)
+			return;
+
+		seek_finish(player, TRUE);
+		/* the next seek's target is already published */
+		if (seek->in_flight)
+			return;
+	}
+
+	clock_sync(player, new_time);
+	/*
+	 * While the playback clock is running, it publishes the time.
+	 * The interpolated time may be slightly ahead of VLC's time, but
+	 * anything further back is a jump (e.g. a seek).
+	 */
+	if (player->priv->clock.timeout_id == 0 ||
+	    new_time < player->priv->clock.time - CLOCK_MAX_EXTRAPOLATION) {
+		player->priv->clock.time = new_time;
+		update_time(player, new_time);
+	}
+}
+
+/** @private */
+static void
+dispatch_state(GtkVlcPlayer *player, gint type)
+{
+	if (type == libvlc_MediaPlayerPlaying) {
+		/* continue from the last published time */
+		clock_sync(player, player->priv->clock.time);
+		clock_start(player);
+	} else {
+		clock_stop(player);
+	}
+}
+
+/**
+ * @private
+ * Finish asynchronous load after its media has been parsed, i.e.
+ * publish the media's length and emit "load-finished".
+ */
+static void
+dispatch_parsed(GtkVlcPlayer *player, gint serial)
+{
+	struct _GtkVlcPlayerLoad *load = &player->priv->load;
+
+	/* media of a cancelled load */
+	if (load->media == NULL || serial != load->serial)
+		return;
+
+	update_length(player, MAX((gint64)libvlc_media_get_duration(load->media), 0));
+	load_cancel(player);
+
+	g_signal_emit(player, gtk_vlc_player_signals[LOAD_FINISHED_SIGNAL], 0);
+}
+
+/**
+ * @private
+ * Get interpolated playback time.
+ *
+ * The time elapsed since the last synchronization with VLC is
+ * scaled by the playback rate and added to the time reported by VLC.
+ * It is limited to \ref CLOCK_MAX_EXTRAPOLATION milliseconds (e.g. if
+ * VLC stalls) and to the media length.
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @return Playback time in milliseconds
+ */
+static gint64
+clock_get_time(GtkVlcPlayer *player)
+{
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+	gint64 elapsed, time;
+
+	elapsed = (g_get_monotonic_time() - clock->sync_clock)/1000;
+	elapsed = (gint64)(elapsed*clock->speed);
+	elapsed = CLAMP(elapsed, 0, CLOCK_MAX_EXTRAPOLATION);
+
+	time = clock->sync_time + elapsed;
+	if (clock->length > 0)
+		time = MIN(time, clock->length);
+
+	return time;
+}
+
+/**
+ * @private
+ * Synchronize playback clock with a time reported by VLC or set by the
+ * user. The current playback rate is fetched as well, so rate changes
+ * take effect with the next VLC time event.
+ */
+static void
+clock_sync(GtkVlcPlayer *player, gint64 time)
+{
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+	gfloat speed = 1.;
+
+	if (player->priv->media_player != NULL)
+		speed = libvlc_media_player_get_rate(player->priv->media_player);
+
+	clock->sync_time = time;
+	clock->sync_clock = g_get_monotonic_time();
+	clock->speed = speed > 0. ? speed : 1.;
+}
+
+/**
+ * @private
+ * Start publishing the interpolated playback time.
+ */
+static void
+clock_start(GtkVlcPlayer *player)
+{
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+
+	clock->playing = TRUE;
+	if (clock->rate == 0 || clock->timeout_id != 0)
+		return;
+
+	clock->timeout_id = gdk_threads_add_timeout_full(GDK_PRIORITY_REDRAW,
+							 MAX(1000/clock->rate, 1),
+							 clock_timeout_cb,
+							 player, NULL);
+}
+
+/**
+ * @private
+ * Stop publishing the interpolated playback time.
+ * The clock is frozen at the last published time.
+ * Its timeout removes itself.
+ */
+static void
+clock_stop(GtkVlcPlayer *player)
+{
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+
+	clock->playing = FALSE;
+	clock_sync(player, clock->time);
+}
+
+/**
+ * @private
+ * Timeout callback publishing the interpolated playback time, i.e.
+ * emitting "time-changed" and updating the time-adjustment.
+ * The published time never moves backwards during playback, so
+ * widgets following the time-adjustment scroll smoothly even if VLC's
+ * time lags behind the interpolation.
+ *
+ * @param user_data \e GtkVlcPlayer instance
+ * @return \c TRUE while playing, else \c FALSE
+ */
+static gboolean
+clock_timeout_cb(gpointer user_data)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+	gint64 time;
+
+	if (!clock->playing) {
+		clock->timeout_id = 0;
+		return FALSE;
+	}
+
+	time = clock_get_time(player);
+	if (time > clock->time) {
+		clock->time = time;
+		update_time(player, time);
+	}
+
+	return TRUE;
+}
+
+/**
+ * @private
+ * Pass seek to VLC. It is in flight until VLC reports a time near its
+ * target or \ref SEEK_TIMEOUT elapses.
+ */
+static void
+seek_issue(GtkVlcPlayer *player, gint64 time)
+{
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	libvlc_media_player_set_time(player->priv->media_player,
+				     (libvlc_time_t)time);
+	/*
+	 * incremented only after VLC got the seek, so times posted before
+	 * are never tagged with its serial
+	 */
+	g_atomic_int_inc(&seek->serial);
+
+	seek->in_flight = TRUE;
+	seek->target = time;
+	seek->issued_at = g_get_monotonic_time();
+	seek->issued++;
+
+	if (seek->timeout_id == 0)
+		seek->timeout_id = gdk_threads_add_timeout(SEEK_TIMEOUT,
+							   seek_timeout_cb,
+							   player);
+}
+
+/**
+ * @private
+ * Finish seek in flight and pass the latest seek requested meanwhile
+ * to VLC.
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @param landed Whether VLC reported the seek done (\c TRUE) or it
+ *               timed out (\c FALSE)
+ */
+static void
+seek_finish(GtkVlcPlayer *player, gboolean landed)
+{
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	if (!seek->in_flight)
+		return;
+
+	if (seek->timeout_id != 0) {
+		g_source_remove(seek->timeout_id);
+		seek->timeout_id = 0;
+	}
+
+	seek->in_flight = FALSE;
+	if (landed) {
+		seek->landed++;
+		seek->latency += g_get_monotonic_time() - seek->issued_at;
+	} else {
+		seek->timed_out++;
+	}
+
+	if (seek->pending) {
+		seek->pending = FALSE;
+		seek_issue(player, seek->pending_target);
+	}
+}
+
+/**
+ * @private
+ * Forget seeks in flight and pending, e.g. because the media changed.
+ */
+static void
+seek_reset(GtkVlcPlayer *player)
+{
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	if (seek->timeout_id != 0) {
+		g_source_remove(seek->timeout_id);
+		seek->timeout_id = 0;
+	}
+	seek->in_flight = FALSE;
+	seek->pending = FALSE;
+}
+
+static gboolean
+seek_timeout_cb(gpointer user_data)
+{
+	GtkVlcPlayer *player = GTK_VLC_PLAYER(user_data);
+
+	player->priv->seek.timeout_id = 0;
+	seek_finish(player, FALSE);
+
+	return FALSE;
+}
+
+/**
+ * @private
+ * Set player's media and reset time and length.
+ * The length is only known if the media was parsed before.
+ * Loading media cancels an asynchronous load in progress.
+ */
 static void
 vlc_player_load_media(GtkVlcPlayer *player, libvlc_media_t *media)
 {
-	libvlc_media_parse(media);
+	load_cancel(player);
 	libvlc_media_player_set_media(player->priv->media_player, media);
 
-	/* NOTE: media was parsed so get_duration works */
-	update_length(player, (gint64)libvlc_media_get_duration(media));
+	update_length(player, MAX((gint64)libvlc_media_get_duration(media), 0));
+	seek_reset(player);
+	player->priv->clock.playing = FALSE;
+	clock_sync(player, 0);
+	player->priv->clock.time = 0;
 	update_time(player, 0);
 }
 
+/**
+ * @private
+ * Set player's media and parse it in the background.
+ * The media can be played back immediately, but its length is only
+ * published when parsing finished.
+ */
+static void
+vlc_player_load_media_async(GtkVlcPlayer *player, libvlc_media_t *media)
+{
+	struct _GtkVlcPlayerLoad *load = &player->priv->load;
+
+	vlc_player_load_media(player, media);
+
+	libvlc_media_retain(media);
+	load->media = media;
+	load->serial++;
+	libvlc_media_set_user_data(media, GINT_TO_POINTER(load->serial));
+
+	libvlc_event_attach(libvlc_media_event_manager(media),
+			    libvlc_MediaParsedChanged,
+			    vlc_media_parsed_changed, player);
+
+	/* libVLC does not parse media again */
+	if (libvlc_media_is_parsed(media))
+		events_post(player, EVENT_PARSED, &player->priv->events.parsed,
+			    load->serial);
+	else
+		libvlc_media_parse_async(media);
+}
+
+/**
+ * @private
+ * Cancel asynchronous load in progress, i.e. stop waiting for its
+ * media to be parsed. Its media is still set.
+ * libVLC waits for parse callbacks in progress when detaching, so
+ * the media can be released afterwards.
+ */
+static void
+load_cancel(GtkVlcPlayer *player)
+{
+	struct _GtkVlcPlayerLoad *load = &player->priv->load;
+
+	if (load->media == NULL)
+		return;
+
+	libvlc_event_detach(libvlc_media_event_manager(load->media),
+			    libvlc_MediaParsedChanged,
+			    vlc_media_parsed_changed, player);
+	libvlc_media_release(load->media);
+	load->media = NULL;
+}
+
+/**
+ * @private
+ * Release preloaded media, least recently preloaded first, until at
+ * most \e limit are left.
+ */
+static void
+preload_trim(GtkVlcPlayer *player, guint limit)
+{
+	GQueue *queue = &player->priv->preload.queue;
+
+	while (g_queue_get_length(queue) > limit) {
+		GtkVlcPlayerPreloaded *entry = g_queue_pop_tail(queue);
+
+		libvlc_media_release(entry->media);
+		g_free(entry->file);
+		g_free(entry);
+	}
+}
+
+/**
+ * @private
+ * Remove media preloaded for a filename from the preloaded media.
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @param file   Filename of media
+ * @return Preloaded media (reference is taken over) or \c NULL
+ */
+static libvlc_media_t *
+preload_take(GtkVlcPlayer *player, const gchar *file)
+{
+	GQueue *queue = &player->priv->preload.queue;
+
+	for (GList *cur = queue->head; cur != NULL; cur = cur->next) {
+		GtkVlcPlayerPreloaded *entry = cur->data;
+		libvlc_media_t *media = entry->media;
+
+		if (g_strcmp0(entry->file, file))
+			continue;
+
+		g_queue_delete_link(queue, cur);
+		g_free(entry->file);
+		g_free(entry);
+
+		return media;
+	}
+
+	return NULL;
+}
+
 /*
  * API
  */
@@ -555,6 +1409,29 @@ gtk_vlc_player_new(void)
 	return GTK_WIDGET(g_object_new(GTK_TYPE_VLC_PLAYER, NULL));
 }
 
+/**
+ * @brief Construct new \e GtkVlcPlayer widget instance with its own
+ *        libVLC instance
+ *
+ * Player widgets constructed with \ref gtk_vlc_player_new share one
+ * libVLC instance, so only the first one pays for creating it.
+ * This creates a separate libVLC instance with the specified
+ * command line arguments instead, so it should only be used if the
+ * widget really needs different libVLC options.
+ * The arguments are passed as the construct-only "vlc-args" property,
+ * so the shared instance is not touched.
+ *
+ * @param args \c NULL-terminated array of libVLC command line
+ *             arguments (e.g. \c "--no-audio") or \c NULL
+ * @return New \e GtkVlcPlayer widget instance
+ */
+GtkWidget *
+gtk_vlc_player_new_with_args(const gchar *const *args)
+{
+	return GTK_WIDGET(g_object_new(GTK_TYPE_VLC_PLAYER,
+				       "vlc-args", args, NULL));
+}
+
 /**
  * @brief Load media with specified filename into player widget
  *
@@ -572,10 +1449,14 @@ gtk_vlc_player_load_filename(GtkVlcPlayer *player, const gchar *file)
 {
 	libvlc_media_t *media;
 
-	media = libvlc_media_new_path(player->priv->vlc_inst,
-				      (const char *)file);
+	media = preload_take(player, file);
+	if (media == NULL)
+		media = libvlc_media_new_path(player->priv->vlc_inst,
+					      (const char *)file);
 	if (media == NULL)
 		return FALSE;
+	/* NOTE: media is parsed so get_duration works */
+	libvlc_media_parse(media);
 	vlc_player_load_media(player, media);
 	libvlc_media_release(media);
 
@@ -602,18 +1483,158 @@ gtk_vlc_player_load_uri(GtkVlcPlayer *player, const gchar *uri)
 					  (const char *)uri);
 	if (media == NULL)
 		return FALSE;
+	/* NOTE: media is parsed so get_duration works */
+	libvlc_media_parse(media);
 	vlc_player_load_media(player, media);
 	libvlc_media_release(media);
 
 	return TRUE;
 }
 
+/**
+ * @brief Load media with specified filename into player widget
+ *        without blocking
+ *
+ * Unlike \ref gtk_vlc_player_load_filename, the media is parsed in
+ * the background, so this returns immediately.
+ * The media can be played back right away, but its length is \c 0
+ * until parsing finished. Then "length-changed" and "load-finished"
+ * signals will be emitted.
+ * Loading other media cancels the load, i.e. "load-finished" will not
+ * be emitted for it.
+ * If the file has been preloaded, it is usually parsed already, so
+ * loading finishes almost immediately.
+ *
+ * @param player \e GtkVlcPlayer instance to load file into.
+ * @param file   \e Filename to load
+ * @return \c TRUE if loading was started, else \c FALSE
+ */
+gboolean
+gtk_vlc_player_load_filename_async(GtkVlcPlayer *player, const gchar *file)
+{
+	libvlc_media_t *media;
+
+	media = preload_take(player, file);
+	if (media == NULL)
+		media = libvlc_media_new_path(player->priv->vlc_inst,
+					      (const char *)file);
+	if (media == NULL)
+		return FALSE;
+	vlc_player_load_media_async(player, media);
+	libvlc_media_release(media);
+
+	return TRUE;
+}
+
+/**
+ * @brief Load media with specified URI into player widget
+ *        without blocking
+ *
+ * It is otherwise identical to \ref gtk_vlc_player_load_filename_async.
+ *
+ * @sa gtk_vlc_player_load_filename_async
+ *
+ * @param player \e GtkVlcPlayer instance to load media into.
+ * @param uri    \e URI to load
+ * @return \c TRUE if loading was started, else \c FALSE
+ */
+gboolean
+gtk_vlc_player_load_uri_async(GtkVlcPlayer *player, const gchar *uri)
+{
+	libvlc_media_t *media;
+
+	media = libvlc_media_new_location(player->priv->vlc_inst,
+					  (const char *)uri);
+	if (media == NULL)
+		return FALSE;
+	vlc_player_load_media_async(player, media);
+	libvlc_media_release(media);
+
+	return TRUE;
+}
+
+/**
+ * @brief Parse media with specified filename in the background for
+ *        loading it later
+ *
+ * Loading the file with \ref gtk_vlc_player_load_filename_async or
+ * \ref gtk_vlc_player_load_filename uses the preloaded media, so they
+ * do not have to wait for parsing.
+ * At most the number of media set by
+ * \ref gtk_vlc_player_set_preload_limit are kept, releasing the least
+ * recently preloaded ones first.
+ *
+ * @param player \e GtkVlcPlayer instance to preload file for.
+ * @param file   \e Filename to preload
+ * @return \c TRUE if the file is preloaded, else \c FALSE
+ */
+gboolean
+gtk_vlc_player_preload_filename(GtkVlcPlayer *player, const gchar *file)
+{
+	GtkVlcPlayerPreloaded *entry;
+	libvlc_media_t *media;
+
+	if (player->priv->preload.limit == 0)
+		return FALSE;
+
+	media = preload_take(player, file);
+	if (media == NULL) {
+		media = libvlc_media_new_path(player->priv->vlc_inst,
+					      (const char *)file);
+		if (media == NULL)
+			return FALSE;
+		libvlc_media_parse_async(media);
+	}
+
+	entry = g_new(GtkVlcPlayerPreloaded, 1);
+	entry->file = g_strdup(file);
+	entry->media = media;
+	g_queue_push_head(&player->priv->preload.queue, entry);
+
+	preload_trim(player, player->priv->preload.limit);
+
+	return TRUE;
+}
+
+/**
+ * @brief Set maximum number of media preloaded
+ *
+ * Every preloaded media keeps its meta data and track information in
+ * memory.
+ * It defaults to \c 0, i.e. preloading is disabled.
+ *
+ * @sa gtk_vlc_player_preload_filename
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @param limit  Maximum number of preloaded media
+ */
+void
+gtk_vlc_player_set_preload_limit(GtkVlcPlayer *player, guint limit)
+{
+	player->priv->preload.limit = limit;
+	preload_trim(player, limit);
+}
+
+/**
+ * @brief Get maximum number of media preloaded
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @return Maximum number of preloaded media
+ */
+guint
+gtk_vlc_player_get_preload_limit(GtkVlcPlayer *player)
+{
+	return player->priv->preload.limit;
+}
+
 /**
  * @brief Play back media if playback is currently paused
  *
  * If it is already playing, do nothing.
  * In playback mode, there will be constant "time-changed" signal emissions
  * and the time-adjustment's value will be set accordingly.
+ * The playback time is interpolated between VLC's time updates, so the
+ * emissions occur at the rate set by \ref gtk_vlc_player_set_clock_rate.
  *
  * @param player \e GtkVlcPlayer instance
  */
@@ -688,20 +1709,81 @@ gtk_vlc_player_stop(GtkVlcPlayer *player)
 	gtk_vlc_player_pause(player);
 	libvlc_media_player_stop(player->priv->media_player);
 
+	seek_reset(player);
+	clock_stop(player);
+	clock_sync(player, 0);
+	player->priv->clock.time = 0;
 	update_time(player, 0);
 }
 
 /**
  * @brief Set point of time in playback
  *
+ * Only one seek is passed to VLC at a time. While it is in progress,
+ * further seeks (e.g. while dragging a scale connected to the
+ * time-adjustment) are coalesced, i.e. only the latest one is
+ * performed afterwards.
+ *
  * @param player \e GtkVlcPlayer instance
  * @param time   New position in media (milliseconds)
  */
 void
 gtk_vlc_player_seek(GtkVlcPlayer *player, gint64 time)
 {
-	libvlc_media_player_set_time(player->priv->media_player,
-				     (libvlc_time_t)time);
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	seek->requested++;
+
+	/* the playback clock continues from the new position */
+	clock_sync(player, time);
+	player->priv->clock.time = time;
+
+	if (seek->in_flight) {
+		seek->pending = TRUE;
+		seek->pending_target = time;
+		return;
+	}
+
+	seek_issue(player, time);
+}
+
+/**
+ * @brief Get statistics of seeks
+ *
+ * Can be used to measure the effect of coalescing seeks and the
+ * latency of seeking, e.g. while dragging a scale.
+ * All values are accumulated since the widget was created.
+ *
+ * @sa gtk_vlc_player_seek
+ *
+ * @param player    \e GtkVlcPlayer instance
+ * @param requested Location to store the number of seeks requested
+ *                  or \c NULL
+ * @param issued    Location to store the number of seeks passed to VLC
+ *                  or \c NULL
+ * @param timed_out Location to store the number of seeks VLC did not
+ *                  report done within 500 milliseconds (e.g. because
+ *                  no media is playing) or \c NULL
+ * @param latency   Location to store the mean time from passing a seek
+ *                  to VLC until VLC reported the new time, in
+ *                  microseconds, or \c NULL.
+ *                  Seeks that timed out are not included.
+ */
+void
+gtk_vlc_player_get_seek_stats(GtkVlcPlayer *player,
+			      guint *requested, guint *issued,
+			      guint *timed_out, gint64 *latency)
+{
+	struct _GtkVlcPlayerSeek *seek = &player->priv->seek;
+
+	if (requested != NULL)
+		*requested = seek->requested;
+	if (issued != NULL)
+		*issued = seek->issued;
+	if (timed_out != NULL)
+		*timed_out = seek->timed_out;
+	if (latency != NULL)
+		*latency = seek->landed ? seek->latency/seek->landed : 0;
 }
 
 /**
@@ -729,6 +1811,55 @@ gtk_vlc_player_get_length(GtkVlcPlayer *player)
 	return (gint64)libvlc_media_player_get_length(player->priv->media_player);
 }
 
+/**
+ * @brief Set update rate of the playback clock
+ *
+ * VLC reports the playback time only a few times per second.
+ * During playback, the widget interpolates the time between VLC's
+ * reports using a monotonic clock and the playback rate, and publishes
+ * it (emits "time-changed" and updates the time-adjustment) \e rate
+ * times per second, so that widgets following the playback
+ * (e.g. transcripts) move smoothly.
+ * The clock is synchronized on every VLC time report, on seeks and
+ * whenever playback starts, pauses or stops.
+ * The rate defaults to \ref DEFAULT_CLOCK_RATE Hz.
+ * A rate of 0 disables interpolation, i.e. only VLC's reports are
+ * published.
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @param rate   Updates per second
+ */
+void
+gtk_vlc_player_set_clock_rate(GtkVlcPlayer *player, guint rate)
+{
+	struct _GtkVlcPlayerClock *clock = &player->priv->clock;
+
+	clock->rate = rate;
+
+	if (clock->timeout_id != 0) {
+		g_source_remove(clock->timeout_id);
+		clock->timeout_id = 0;
+	}
+	if (clock->playing) {
+		clock_sync(player, clock->time);
+		clock_start(player);
+	}
+}
+
+/**
+ * @brief Get update rate of the playback clock
+ *
+ * @sa gtk_vlc_player_set_clock_rate
+ *
+ * @param player \e GtkVlcPlayer instance
+ * @return Updates per second, 0 if interpolation is disabled
+ */
+guint
+gtk_vlc_player_get_clock_rate(GtkVlcPlayer *player)
+{
+	return player->priv->clock.rate;
+}
+
 /**
  * @brief Get time-adjustment currently used by \e GtkVlcPlayer
  *
@@ -83,6 +83,14 @@ typedef struct _GtkVlcPlayerClass {
 	 * @param new_length New (current) length of media loaded into player (milliseconds)
 	 */
 	void (*length_changed)	(GtkVlcPlayer *self, gint64 new_length);
+
+	/**
+	 * Callback function to invoke when emitting the "load-finished"
+	 * signal, i.e. when media loaded asynchronously has been parsed.
+	 *
+	 * @param self \e GtkVlcPlayer widget that emitted the signal
+	 */
+	void (*load_finished)	(GtkVlcPlayer *self);
 } GtkVlcPlayerClass;
 
 /** @private */
@@ -92,9 +100,18 @@ GType gtk_vlc_player_get_type(void);
  * API
  */
 GtkWidget *gtk_vlc_player_new(void);
+GtkWidget *gtk_vlc_player_new_with_args(const gchar *const *args);
 
 gboolean gtk_vlc_player_load_filename(GtkVlcPlayer *player, const gchar *file);
 gboolean gtk_vlc_player_load_uri(GtkVlcPlayer *player, const gchar *uri);
+gboolean gtk_vlc_player_load_filename_async(GtkVlcPlayer *player,
+					    const gchar *file);
+gboolean gtk_vlc_player_load_uri_async(GtkVlcPlayer *player, const gchar *uri);
+
+gboolean gtk_vlc_player_preload_filename(GtkVlcPlayer *player,
+					 const gchar *file);
+void gtk_vlc_player_set_preload_limit(GtkVlcPlayer *player, guint limit);
+guint gtk_vlc_player_get_preload_limit(GtkVlcPlayer *player);
 
 void gtk_vlc_player_play(GtkVlcPlayer *player);
 void gtk_vlc_player_pause(GtkVlcPlayer *player);
@@ -102,10 +119,16 @@ gboolean gtk_vlc_player_toggle(GtkVlcPlayer *player);
 void gtk_vlc_player_stop(GtkVlcPlayer *player);
 
 void gtk_vlc_player_seek(GtkVlcPlayer *player, gint64 time);
+void gtk_vlc_player_get_seek_stats(GtkVlcPlayer *player,
+				   guint *requested, guint *issued,
+				   guint *timed_out, gint64 *latency);
 void gtk_vlc_player_set_volume(GtkVlcPlayer *player, gdouble volume);
 
 gint64 gtk_vlc_player_get_length(GtkVlcPlayer *player);
 
+void gtk_vlc_player_set_clock_rate(GtkVlcPlayer *player, guint rate);
+guint gtk_vlc_player_get_clock_rate(GtkVlcPlayer *player);
+
 GtkAdjustment *gtk_vlc_player_get_time_adjustment(GtkVlcPlayer *player);
 void gtk_vlc_player_set_time_adjustment(GtkVlcPlayer *player, GtkAdjustment *adj);
 
@@ -0,0 +1,436 @@
+/**
+ * @file
+ * Benchmark of seeking while dragging.
+ *
+ * Plays a media file and drags through it by script, i.e. requests a
+ * number of seeks at a fixed interval like a scale dragged with the
+ * mouse. The drag is performed with a \e GtkVlcPlayer, which coalesces
+ * seeks, and with a plain libVLC media player that gets every seek
+ * passed directly (like \e GtkVlcPlayer used to).
+ * The latency of a drag is the time from its last seek until VLC
+ * reports a time close to the drag's target, i.e. until the final
+ * position is displayed.
+ * Requires a display. Results are written as tab-separated values,
+ * one line per drag.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <gtk/gtk.h>
+#include <gdk/gdk.h>
+#ifdef G_OS_WIN32
+#include <gdk/gdkwin32.h>
+#else
+#include <gdk/gdkx.h>
+#endif
+
+#include <vlc/vlc.h>
+
+#include "gtk-vlc-player.h"
+
+/** Maximum distance of a reported time from the drag's target (milliseconds) */
+#define SETTLE_TOLERANCE	1000
+/** Time to wait for the final position of a drag (milliseconds) */
+#define SETTLE_TIMEOUT		10000
+/** Time to let playback run before dragging (milliseconds) */
+#define WARMUP_TIME		1000
+
+static gint opt_steps = 60;
+static gint opt_interval = 16;
+static gint opt_repeat = 3;
+static gchar *opt_output = NULL;
+
+static GOptionEntry entries[] = {
+	{"steps", 's', 0, G_OPTION_ARG_INT, &opt_steps,
+	 "Number of seeks per drag (default: 60)", "N"},
+	{"interval", 'i', 0, G_OPTION_ARG_INT, &opt_interval,
+	 "Interval between seeks (default: 16)", "MS"},
+	{"repeat", 'r', 0, G_OPTION_ARG_INT, &opt_repeat,
+	 "Number of drags per player (default: 3)", "N"},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	 "Write results to FILE instead of standard output", "FILE"},
+	{NULL}
+};
+
+/** State of a scripted drag */
+typedef struct _Drag Drag;
+struct _Drag {
+	/** Seek function of the player under test */
+	void		(*seek)(Drag *drag, gint64 time);
+	gpointer	player;		/**< Player under test */
+
+	gint64		from;		/**< Start of drag (milliseconds) */
+	gint64		to;		/**< Target of drag (milliseconds) */
+	gint		step;		/**< Number of seeks requested so far */
+
+	gint64		released_at;	/**< Monotonic time of last seek or 0 */
+	gint64		settled_at;	/**< Monotonic time target was reported or 0 */
+	guint		timeout_id;	/**< Source Id of settle timeout or 0 */
+};
+
+/** Time event of the plain libVLC player, dispatched in the main thread */
+typedef struct {
+	Drag	*drag;
+	gint64	time;
+} DirectTime;
+
+static gboolean quit_cb(gpointer user_data);
+static void wait_ms(guint ms);
+static void drag_on_time(Drag *drag, gint64 time);
+static gboolean drag_timeout_cb(gpointer user_data);
+static gboolean drag_step_cb(gpointer user_data);
+static gboolean run_drag(Drag *drag);
+
+static gboolean
+quit_cb(gpointer user_data __attribute__((unused)))
+{
+	gtk_main_quit();
+	return FALSE;
+}
+
+/** Run the main loop for \e ms milliseconds */
+static void
+wait_ms(guint ms)
+{
+	gdk_threads_add_timeout(ms, quit_cb, NULL);
+	gtk_main();
+}
+
+/** Note time reported by the player under test */
+static void
+drag_on_time(Drag *drag, gint64 time)
+{
+	if (!drag->released_at || drag->settled_at ||
+	    ABS(time - drag->to) > SETTLE_TOLERANCE)
+		return;
+
+	drag->settled_at = g_get_monotonic_time();
+	g_source_remove(drag->timeout_id);
+	drag->timeout_id = 0;
+	gtk_main_quit();
+}
+
+static gboolean
+drag_timeout_cb(gpointer user_data)
+{
+	Drag *drag = user_data;
+
+	drag->timeout_id = 0;
+	gtk_main_quit();
+	return FALSE;
+}
+
+static gboolean
+drag_step_cb(gpointer user_data)
+{
+	Drag *drag = user_data;
+
+	drag->step++;
+	drag->seek(drag, drag->from +
+			 (drag->to - drag->from)*drag->step/opt_steps);
+	if (drag->step < opt_steps)
+		return TRUE;
+
+	drag->released_at = g_get_monotonic_time();
+	drag->timeout_id = gdk_threads_add_timeout(SETTLE_TIMEOUT,
+						   drag_timeout_cb, drag);
+	return FALSE;
+}
+
+/**
+ * Perform a drag from \e drag->from to \e drag->to.
+ *
+ * @return \c TRUE if the target was reported, else \c FALSE
+ */
+static gboolean
+run_drag(Drag *drag)
+{
+	drag->seek(drag, drag->from);
+	wait_ms(WARMUP_TIME);
+
+	drag->step = 0;
+	drag->released_at = drag->settled_at = 0;
+	gdk_threads_add_timeout(opt_interval, drag_step_cb, drag);
+	gtk_main();
+
+	return drag->settled_at > 0;
+}
+
+/*
+ * GtkVlcPlayer
+ */
+
+static void
+widget_seek(Drag *drag, gint64 time)
+{
+	gtk_vlc_player_seek(GTK_VLC_PLAYER(drag->player), time);
+}
+
+static void
+widget_on_time_changed(GtkVlcPlayer *player __attribute__((unused)),
+		       gint64 new_time, gpointer user_data)
+{
+	drag_on_time((Drag *)user_data, new_time);
+}
+
+/*
+ * plain libVLC player
+ */
+
+static void
+direct_seek(Drag *drag, gint64 time)
+{
+	libvlc_media_player_set_time((libvlc_media_player_t *)drag->player,
+				     (libvlc_time_t)time);
+}
+
+static gboolean
+direct_time_cb(gpointer user_data)
+{
+	DirectTime *event = user_data;
+
+	drag_on_time(event->drag, event->time);
+	g_free(event);
+	return FALSE;
+}
+
+/** Called from VLC threads */
+static void
+direct_on_time_changed(const struct libvlc_event_t *event, void *user_data)
+{
+	DirectTime *time = g_new(DirectTime, 1);
+
+	time->drag = user_data;
+	time->time = event->u.media_player_time_changed.new_time;
+	gdk_threads_add_idle(direct_time_cb, time);
+}
+
+/*
+ * Benchmark
+ */
+
+static void
+report(FILE *out, const gchar *name, gint run, Drag *drag,
+       guint requested, guint issued, guint timed_out, gint64 latency)
+{
+	fprintf(out, "%s\t%d\t%d\t%u\t%u\t%u\t%" G_GINT64_FORMAT "\t",
+		name, run, opt_steps, requested, issued, timed_out, latency);
+	if (drag->settled_at)
+		fprintf(out, "%.1f\n",
+			(drag->settled_at - drag->released_at)/1000.);
+	else
+		fputs("NA\n", out);
+	fflush(out);
+}
+
+/**
+ * Show a window for a player's video
+ *
+ * @param window Location to store the window
+ * @param child  Widget to display video in or \c NULL for a drawing area
+ * @return Widget displaying the video
+ */
+static GtkWidget *
+create_window(GtkWidget **window, GtkWidget *child)
+{
+	GtkWidget *area = child != NULL ? child : gtk_drawing_area_new();
+
+	*window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_default_size(GTK_WINDOW(*window), 640, 480);
+	gtk_container_add(GTK_CONTAINER(*window), area);
+	gtk_widget_show_all(*window);
+
+	return area;
+}
+
+/** Range of a drag, alternating its direction */
+static void
+drag_init(Drag *drag, gint run, gint64 length)
+{
+	drag->from = run % 2 ? length*3/4 : length/4;
+	drag->to = run % 2 ? length/4 : length*3/4;
+}
+
+static void
+benchmark_widget(FILE *out, const gchar *file)
+{
+	for (gint run = 0; run < opt_repeat; run++) {
+		GtkWidget *window, *widget = gtk_vlc_player_new();
+		GtkVlcPlayer *player = GTK_VLC_PLAYER(widget);
+		Drag drag;
+		guint requested, issued, timed_out;
+		gint64 latency;
+
+		create_window(&window, widget);
+		if (!gtk_vlc_player_load_filename(player, file)) {
+			g_printerr("Cannot load \"%s\"\n", file);
+			exit(EXIT_FAILURE);
+		}
+		gtk_vlc_player_set_volume(player, 0.);
+		gtk_vlc_player_play(player);
+		wait_ms(WARMUP_TIME);
+
+		drag.seek = widget_seek;
+		drag.player = player;
+		drag_init(&drag, run, gtk_vlc_player_get_length(player));
+		g_signal_connect(G_OBJECT(player), "time-changed",
+				 G_CALLBACK(widget_on_time_changed), &drag);
+
+		run_drag(&drag);
+
+		gtk_vlc_player_get_seek_stats(player, &requested, &issued,
+					      &timed_out, &latency);
+		report(out, "GtkVlcPlayer", run, &drag,
+		       requested, issued, timed_out, latency);
+
+		gtk_vlc_player_stop(player);
+		gtk_widget_destroy(window);
+	}
+}
+
+static void
+benchmark_direct(FILE *out, const gchar *file)
+{
+	libvlc_instance_t *inst = libvlc_new(0, NULL);
+
+	for (gint run = 0; run < opt_repeat; run++) {
+		GtkWidget *window, *area;
+		libvlc_media_player_t *media_player;
+		libvlc_media_t *media;
+		Drag drag;
+
+		area = create_window(&window, NULL);
+		media_player = libvlc_media_player_new(inst);
+#ifdef G_OS_WIN32
+		libvlc_media_player_set_hwnd(media_player,
+					     GDK_WINDOW_HWND(gtk_widget_get_window(area)));
+#else
+		libvlc_media_player_set_xwindow(media_player,
+						GDK_WINDOW_XID(gtk_widget_get_window(area)));
+#endif
+
+		media = libvlc_media_new_path(inst, file);
+		if (media == NULL) {
+			g_printerr("Cannot load \"%s\"\n", file);
+			exit(EXIT_FAILURE);
+		}
+		libvlc_media_parse(media);
+		libvlc_media_player_set_media(media_player, media);
+		libvlc_media_release(media);
+
+		drag.seek = direct_seek;
+		drag.player = media_player;
+		drag.released_at = 0;
+		libvlc_event_attach(libvlc_media_player_event_manager(media_player),
+				    libvlc_MediaPlayerTimeChanged,
+				    direct_on_time_changed, &drag);
+
+		libvlc_media_player_play(media_player);
+		libvlc_audio_set_volume(media_player, 0);
+		wait_ms(WARMUP_TIME);
+
+		drag_init(&drag, run,
+			  libvlc_media_player_get_length(media_player));
+		run_drag(&drag);
+
+		/* every seek is passed to VLC, none is timed */
+		report(out, "libVLC", run, &drag, opt_steps + 1, opt_steps + 1,
+		       0, 0);
+
+		libvlc_event_detach(libvlc_media_player_event_manager(media_player),
+				    libvlc_MediaPlayerTimeChanged,
+				    direct_on_time_changed, &drag);
+		libvlc_media_player_stop(media_player);
+		libvlc_media_player_release(media_player);
+		gtk_widget_destroy(window);
+
+		/* drop time events still queued for this drag */
+		while (gtk_events_pending())
+			gtk_main_iteration();
+	}
+
+	libvlc_release(inst);
+}
+
+/** @private */
+int
+main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	FILE *out = stdout;
+
+	g_thread_init(NULL);
+	gdk_threads_init();
+
+	context = g_option_context_new("FILE - benchmark seeking while dragging");
+	g_option_context_add_main_entries(context, entries, NULL);
+	g_option_context_add_group(context, gtk_get_option_group(FALSE));
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	if (argc != 2) {
+		g_printerr("No media file specified\n");
+		return EXIT_FAILURE;
+	}
+	opt_steps = MAX(opt_steps, 1);
+	opt_interval = MAX(opt_interval, 1);
+	opt_repeat = MAX(opt_repeat, 1);
+
+	if (!gtk_init_check(&argc, &argv)) {
+		g_printerr("Cannot open display\n");
+		return EXIT_FAILURE;
+	}
+
+	if (opt_output != NULL) {
+		out = g_fopen(opt_output, "w");
+		if (out == NULL) {
+			g_printerr("Cannot open \"%s\"\n", opt_output);
+			return EXIT_FAILURE;
+		}
+	}
+
+#ifdef PACKAGE_STRING
+	fprintf(out, "# %s\n", PACKAGE_STRING);
+#endif
+	fprintf(out, "# %d seeks every %d ms\n", opt_steps, opt_interval);
+	fputs("player\trun\tsteps\trequested\tissued\ttimed_out\t"
+	      "seek_latency_us\tsettle_ms\n", out);
+
+	gdk_threads_enter();
+	benchmark_direct(out, argv[1]);
+	benchmark_widget(out, argv[1]);
+	gdk_threads_leave();
+
+	if (out != stdout)
+		fclose(out);
+
+	return EXIT_SUCCESS;
+}
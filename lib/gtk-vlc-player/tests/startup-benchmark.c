@@ -0,0 +1,184 @@
+/**
+ * @file
+ * Benchmark of constructing player widgets.
+ *
+ * Constructs a number of \e GtkVlcPlayer widgets one after another,
+ * realizing them in a window and optionally loading a media file into
+ * each of them. After every widget, the elapsed time and the resident
+ * set size of the process are reported.
+ * By default, the widgets share one libVLC instance. With
+ * \c --separate, every widget gets its own libVLC instance (like every
+ * \e GtkVlcPlayer used to), so both can be compared. Since memory is not
+ * necessarily returned to the system, each mode should be measured in a
+ * new process.
+ * Requires a display. Results are written as tab-separated values,
+ * one line per widget.
+ */
+
+/*
+ * Copyright (C) 2012-2013 Otto-von-Guericke-Universität Magdeburg
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <gtk/gtk.h>
+
+#include "gtk-vlc-player.h"
+
+static gint opt_players = 4;
+static gboolean opt_separate = FALSE;
+static gchar *opt_output = NULL;
+
+static GOptionEntry entries[] = {
+	{"players", 'n', 0, G_OPTION_ARG_INT, &opt_players,
+	 "Number of player widgets (default: 4)", "N"},
+	{"separate", 's', 0, G_OPTION_ARG_NONE, &opt_separate,
+	 "Give every player widget its own libVLC instance", NULL},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+	 "Write results to FILE instead of standard output", "FILE"},
+	{NULL}
+};
+
+/**
+ * Get resident set size of the process
+ *
+ * @return Resident set size in KiB or -1 if it cannot be determined
+ */
+static glong
+get_rss(void)
+{
+	FILE *file = g_fopen("/proc/self/statm", "r");
+	glong size, resident;
+
+	if (file == NULL)
+		return -1;
+	if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+		resident = -1;
+	fclose(file);
+
+	return resident < 0 ? -1 : resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+/** Process all pending events, e.g. realizing widgets */
+static void
+flush_events(void)
+{
+	while (gtk_events_pending())
+		gtk_main_iteration();
+}
+
+/** @private */
+int
+main(int argc, char **argv)
+{
+	/* any option makes the widget create its own libVLC instance */
+	static const gchar *const separate_args[] = {
+		"--no-video-title-show", NULL
+	};
+
+	GOptionContext *context;
+	GError *error = NULL;
+	FILE *out = stdout;
+
+	GtkWidget *window, *box;
+	GTimer *timer;
+
+	g_thread_init(NULL);
+	gdk_threads_init();
+
+	context = g_option_context_new("[FILE] - benchmark constructing players");
+	g_option_context_add_main_entries(context, entries, NULL);
+	g_option_context_add_group(context, gtk_get_option_group(FALSE));
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	opt_players = MAX(opt_players, 1);
+
+	if (!gtk_init_check(&argc, &argv)) {
+		g_printerr("Cannot open display\n");
+		return EXIT_FAILURE;
+	}
+
+	if (opt_output != NULL) {
+		out = g_fopen(opt_output, "w");
+		if (out == NULL) {
+			g_printerr("Cannot open \"%s\"\n", opt_output);
+			return EXIT_FAILURE;
+		}
+	}
+
+#ifdef PACKAGE_STRING
+	fprintf(out, "# %s\n", PACKAGE_STRING);
+#endif
+	fputs("instances\tplayers\tseconds\trss_kib\n", out);
+
+	gdk_threads_enter();
+
+	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	box = gtk_hbox_new(TRUE, 0);
+	gtk_container_add(GTK_CONTAINER(window), box);
+	gtk_widget_show_all(window);
+	flush_events();
+
+	fprintf(out, "%s\t0\t0\t%ld\n",
+		opt_separate ? "separate" : "shared", get_rss());
+
+	timer = g_timer_new();
+
+	for (gint i = 1; i <= opt_players; i++) {
+		GtkWidget *player;
+
+		player = opt_separate ? gtk_vlc_player_new_with_args(separate_args)
+				      : gtk_vlc_player_new();
+		gtk_widget_set_size_request(player, 160, 120);
+		gtk_box_pack_start(GTK_BOX(box), player, TRUE, TRUE, 0);
+		gtk_widget_show(player);
+
+		if (argc > 1 &&
+		    !gtk_vlc_player_load_filename(GTK_VLC_PLAYER(player),
+						  argv[1])) {
+			g_printerr("Cannot load \"%s\"\n", argv[1]);
+			return EXIT_FAILURE;
+		}
+		flush_events();
+
+		fprintf(out, "%s\t%d\t%.6f\t%ld\n",
+			opt_separate ? "separate" : "shared", i,
+			g_timer_elapsed(timer, NULL), get_rss());
+		fflush(out);
+	}
+
+	g_timer_destroy(timer);
+	gtk_widget_destroy(window);
+
+	gdk_threads_leave();
+
+	if (out != stdout)
+		fclose(out);
+
+	return EXIT_SUCCESS;
+}
@@ -38,6 +38,8 @@ static inline void set_default_string(const gchar *group_name, const gchar *key,
 				      const gchar *string);
 static inline void set_default_boolean(const gchar *group_name, const gchar *key,
 				       gboolean boolean);
+static inline void set_default_integer(const gchar *group_name, const gchar *key,
+				       gint integer);
 
 static const gchar *get_group_by_actor(const gchar *actor);
 static const gchar *get_group_by_window(const gchar *window);
@@ -62,6 +64,7 @@ config_init_key_file(void)
 	set_default_boolean("Global", "Save-Window-Properties", TRUE);
 
 	set_default_string("Directories", "Quick-Open", DEFAULT_QUICKOPEN_DIR);
+	set_default_integer("Global", "Quick-Open-Preload", DEFAULT_QUICKOPEN_PRELOAD);
 	set_default_string("Directories", "Formats", DEFAULT_FORMATS_DIR);
 
 #ifdef DEFAULT_INTERACTIVE_FORMAT_FONT
@@ -100,6 +103,14 @@ set_default_boolean(const gchar *group_name, const gchar *key,
 		g_key_file_set_boolean(keyfile, group_name, key, boolean);
 }
 
+static inline void
+set_default_integer(const gchar *group_name, const gchar *key,
+		    gint integer)
+{
+	if (!g_key_file_has_key(keyfile, group_name, key, NULL))
+		g_key_file_set_integer(keyfile, group_name, key, integer);
+}
+
 void
 config_set_save_window_properties(gboolean enabled)
 {
@@ -163,6 +174,13 @@ config_get_quickopen_directory(void)
 	return g_key_file_get_string(keyfile, "Directories", "Quick-Open", NULL);
 }
 
+gint
+config_get_quickopen_preload(void)
+{
+	return MAX(g_key_file_get_integer(keyfile, "Global",
+					  "Quick-Open-Preload", NULL), 0);
+}
+
 void
 config_set_formats_directory(const gchar *dir)
 {
@@ -300,6 +318,57 @@ config_get_transcript_alignment(const gchar *actor)
 	return (PangoAlignment)alignment;
 }
 
+/* returns size in KiB or -1 if it is not configured */
+gint
+config_get_transcript_layout_cache_size(const gchar *actor)
+{
+	GError	*error = NULL;
+	gint	size;
+
+	size = g_key_file_get_integer(keyfile, get_group_by_actor(actor),
+				      "Widget-Layout-Cache-Size", &error);
+	if (error != NULL) {
+		g_error_free(error);
+		return -1;
+	}
+
+	return MAX(size, 0);
+}
+
+/* returns updates per second or -1 if it is not configured */
+gint
+config_get_transcript_redraw_rate(const gchar *actor)
+{
+	GError	*error = NULL;
+	gint	rate;
+
+	rate = g_key_file_get_integer(keyfile, get_group_by_actor(actor),
+				      "Widget-Redraw-Rate", &error);
+	if (error != NULL) {
+		g_error_free(error);
+		return -1;
+	}
+
+	return MAX(rate, 0);
+}
+
+/* drawing with GDK unless cairo is enabled explicitly */
+gboolean
+config_get_transcript_use_cairo(const gchar *actor)
+{
+	GError		*error = NULL;
+	gboolean	use;
+
+	use = g_key_file_get_boolean(keyfile, get_group_by_actor(actor),
+				     "Widget-Use-Cairo", &error);
+	if (error != NULL) {
+		g_error_free(error);
+		return FALSE;
+	}
+
+	return use;
+}
+
 void
 config_save_key_file(void)
 {
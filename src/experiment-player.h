@@ -30,6 +30,8 @@
 
 #include <gtk/gtk.h>
 
+#include <experiment-reader.h>
+
 /** Main program error domain */
 #define EXPERIMENT_PLAYER_ERROR \
 	(experiment_player_error_quark())
@@ -46,7 +48,9 @@ typedef enum {
 GQuark experiment_player_error_quark(void);
 
 gboolean load_media_file(const gchar *file);
-gboolean load_transcript_file(const gchar *file);
+void load_transcript_file(const gchar *file);
+void load_transcript_reader(ExperimentReader *reader);
+void load_transcript_adopt(GCancellable *cancellable);
 
 void show_message_dialog_gerror(GError *err);
 
@@ -89,6 +93,7 @@ GdkWindowState config_get_window_state(const gchar *window);
 
 void config_set_quickopen_directory(const gchar *dir);
 gchar *config_get_quickopen_directory(void);
+gint config_get_quickopen_preload(void);
 void config_set_formats_directory(const gchar *dir);
 gchar *config_get_formats_directory(void);
 
@@ -202,6 +207,10 @@ void config_set_transcript_alignment(const gchar *actor,
 				     PangoAlignment alignment);
 PangoAlignment config_get_transcript_alignment(const gchar *actor);
 
+gint config_get_transcript_layout_cache_size(const gchar *actor);
+gint config_get_transcript_redraw_rate(const gchar *actor);
+gboolean config_get_transcript_use_cairo(const gchar *actor);
+
 void config_save_key_file(void);
 
 /*
@@ -34,6 +34,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
 
 #include <gdk/gdk.h>
 
@@ -48,6 +49,9 @@
 
 static inline void button_image_set_from_stock(GtkButton *widget,
 					       const gchar *name);
+static void load_transcript_file_ready_cb(GObject *source,
+					  GAsyncResult *result,
+					  gpointer user_data);
 
 GtkWidget *player_window,
 	  *info_window,
@@ -71,6 +75,9 @@ GtkWidget *navigator_scrolledwindow,
 
 gchar *current_filename = NULL;
 
+/** Cancels the transcript load in flight */
+static GCancellable *transcript_load_cancellable = NULL;
+
 #define TOOLTIP_PLAY	"Start video playback"
 #define TOOLTIP_PAUSE	"Pause video playback"
 
@@ -112,8 +119,14 @@ void
 player_widget_time_changed_cb(GtkWidget *widget, gint64 new_time,
 			      gpointer data __attribute__((unused)))
 {
-	gtk_label_set_text(GTK_LABEL(widget),
-			   format_timepoint("Time: ", new_time));
+	const gchar *text = format_timepoint("Time: ", new_time);
+
+	/*
+	 * the time changes at the player's clock rate, but the label
+	 * only every second
+	 */
+	if (g_strcmp0(gtk_label_get_text(GTK_LABEL(widget)), text))
+		gtk_label_set_text(GTK_LABEL(widget), text);
 }
 
 /** @private */
@@ -188,9 +201,7 @@ file_menu_opentranscript_item_activate_cb(GtkWidget *widget,
 
 		file = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
 
-		if (!load_transcript_file(file)) {
-			/* TODO */
-		}
+		load_transcript_file(file);
 		refresh_quickopen_menu(GTK_MENU(quickopen_menu));
 
 		g_free(file);
@@ -244,6 +255,19 @@ navigator_widget_time_selected_cb(GtkWidget *widget, gint64 selected_time,
 	gtk_vlc_player_seek(GTK_VLC_PLAYER(widget), selected_time);
 }
 
+/**
+ * @private
+ * Keep the scales of both transcripts in sync, so that contributions
+ * at the same time are displayed side by side
+ */
+void
+transcript_widget_scale_changed_cb(GtkWidget *widget, guint scale,
+				   gpointer user_data __attribute__((unused)))
+{
+	gtk_experiment_transcript_set_scale(GTK_EXPERIMENT_TRANSCRIPT(widget),
+					    scale);
+}
+
 /** @private */
 void
 navigator_widget_section_activated_cb(GtkWidget *widget __attribute__((unused)),
@@ -300,7 +324,9 @@ button_image_set_from_stock(GtkButton *widget, const gchar *name)
 gboolean
 load_media_file(const gchar *file)
 {
-	if (!gtk_vlc_player_load_filename(GTK_VLC_PLAYER(player_widget), file))
+	/* the length is updated when the media has been parsed */
+	if (!gtk_vlc_player_load_filename_async(GTK_VLC_PLAYER(player_widget),
+						file))
 		return FALSE;
 
 	g_free(current_filename);
@@ -315,43 +341,116 @@ load_media_file(const gchar *file)
 	return TRUE;
 }
 
-gboolean
-load_transcript_file(const gchar *file)
+static void
+load_transcript_file_ready_cb(GObject *source __attribute__((unused)),
+			      GAsyncResult *result,
+			      gpointer user_data __attribute__((unused)))
 {
 	ExperimentReader *reader;
-	gboolean res;
+	GError *error = NULL;
 
-	reader = experiment_reader_new(file);
-	if (reader == NULL)
-		return FALSE;
+	/* GLib idle callbacks are invoked without the GDK lock */
+	gdk_threads_enter();
 
-	res = gtk_experiment_transcript_load(GTK_EXPERIMENT_TRANSCRIPT(transcript_wizard_widget),
-					     reader);
-	if (!res) {
-		g_object_unref(G_OBJECT(reader));
-		return FALSE;
+	reader = experiment_reader_new_finish(result, &error);
+	if (reader == NULL) {
+		/* a newer load was started */
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			show_message_dialog_gerror(error);
+		g_error_free(error);
+		gdk_threads_leave();
+		return;
 	}
 
-	res = gtk_experiment_transcript_load(GTK_EXPERIMENT_TRANSCRIPT(transcript_proband_widget),
-					     reader);
-	if (!res) {
-		g_object_unref(G_OBJECT(reader));
-		return FALSE;
+	load_transcript_reader(reader);
+	g_object_unref(reader);
+
+	gdk_threads_leave();
+}
+
+/**
+ * @brief Load session into the transcript and navigator widgets
+ *
+ * Cancels the transcript load in flight, e.g. when loading a
+ * preloaded session.
+ *
+ * @param reader Session of transcript file
+ */
+void
+load_transcript_reader(ExperimentReader *reader)
+{
+	GHashTable *contrib_tables;
+	gboolean res;
+
+	if (transcript_load_cancellable != NULL) {
+		g_cancellable_cancel(transcript_load_cancellable);
+		g_object_unref(transcript_load_cancellable);
+		transcript_load_cancellable = NULL;
 	}
 
-	res = gtk_experiment_navigator_load(GTK_EXPERIMENT_NAVIGATOR(navigator_widget),
+	/* extract contributions of all speakers at once */
+	contrib_tables = experiment_reader_get_contrib_tables(reader);
+
+	res = gtk_experiment_transcript_load_tables(GTK_EXPERIMENT_TRANSCRIPT(transcript_wizard_widget),
+						    contrib_tables) &&
+	      gtk_experiment_transcript_load_tables(GTK_EXPERIMENT_TRANSCRIPT(transcript_proband_widget),
+						    contrib_tables);
+	g_hash_table_unref(contrib_tables);
+
+	res = res &&
+	      gtk_experiment_navigator_load(GTK_EXPERIMENT_NAVIGATOR(navigator_widget),
 					    reader);
-	if (!res) {
-		g_object_unref(G_OBJECT(reader));
-		return FALSE;
+
+	if (res) {
+		gtk_widget_set_sensitive(transcript_table, TRUE);
+		gtk_widget_set_sensitive(navigator_scrolledwindow, TRUE);
 	}
+}
 
-	g_object_unref(reader);
+/**
+ * @brief Load transcript file into the transcript and navigator widgets
+ *
+ * The file is loaded asynchronously, so this returns immediately
+ * and the widgets are updated when the session is ready.
+ * Loading another transcript file cancels the load in flight.
+ *
+ * @param file Filename of transcript file
+ */
+void
+load_transcript_file(const gchar *file)
+{
+	if (transcript_load_cancellable != NULL) {
+		g_cancellable_cancel(transcript_load_cancellable);
+		g_object_unref(transcript_load_cancellable);
+	}
+	transcript_load_cancellable = g_cancellable_new();
 
-	gtk_widget_set_sensitive(transcript_table, TRUE);
-	gtk_widget_set_sensitive(navigator_scrolledwindow, TRUE);
+	experiment_reader_new_async(file, EXPERIMENT_READER_FLAG_CACHE,
+				    transcript_load_cancellable,
+				    load_transcript_file_ready_cb, NULL);
+}
 
-	return TRUE;
+/**
+ * @brief Take over a transcript load started elsewhere
+ *
+ * The load becomes the one in flight, i.e. loading another transcript
+ * cancels it. The caller loads the session with
+ * \ref load_transcript_reader when it is ready, unless \e cancellable
+ * has been cancelled by then.
+ *
+ * @param cancellable \e GCancellable of the load
+ */
+void
+load_transcript_adopt(GCancellable *cancellable)
+{
+	if (transcript_load_cancellable == cancellable)
+		return;
+
+	if (transcript_load_cancellable != NULL) {
+		g_cancellable_cancel(transcript_load_cancellable);
+		g_object_unref(transcript_load_cancellable);
+	}
+	transcript_load_cancellable = g_object_ref(cancellable);
 }
 
 void
@@ -431,6 +530,7 @@ main(int argc, char *argv[])
 	PangoFontDescription *font_desc;
 	gboolean reverse;
 	PangoAlignment alignment;
+	gint cache_size, redraw_rate;
 	GdkColor color;
 	GtkRcStyle *modified_style;
 
@@ -531,6 +631,19 @@ main(int argc, char *argv[])
 	alignment = config_get_transcript_alignment(SPEAKER_WIZARD);
 	gtk_experiment_transcript_set_alignment(transcript_wizard, alignment);
 
+	cache_size = config_get_transcript_layout_cache_size(SPEAKER_WIZARD);
+	if (cache_size >= 0)
+		gtk_experiment_transcript_set_layout_cache_size(transcript_wizard,
+								(gsize)cache_size*1024);
+
+	redraw_rate = config_get_transcript_redraw_rate(SPEAKER_WIZARD);
+	if (redraw_rate >= 0)
+		gtk_experiment_transcript_set_redraw_rate(transcript_wizard,
+							  (guint)redraw_rate);
+
+	gtk_experiment_transcript_set_use_cairo(transcript_wizard,
+						config_get_transcript_use_cairo(SPEAKER_WIZARD));
+
 	transcript_wizard->interactive_format.default_font =
 			config_get_transcript_default_format_font(SPEAKER_WIZARD);
 	if (config_get_transcript_default_format_text_color(SPEAKER_WIZARD, &color))
@@ -557,6 +670,19 @@ main(int argc, char *argv[])
 	alignment = config_get_transcript_alignment(SPEAKER_PROBAND);
 	gtk_experiment_transcript_set_alignment(transcript_proband, alignment);
 
+	cache_size = config_get_transcript_layout_cache_size(SPEAKER_PROBAND);
+	if (cache_size >= 0)
+		gtk_experiment_transcript_set_layout_cache_size(transcript_proband,
+								(gsize)cache_size*1024);
+
+	redraw_rate = config_get_transcript_redraw_rate(SPEAKER_PROBAND);
+	if (redraw_rate >= 0)
+		gtk_experiment_transcript_set_redraw_rate(transcript_proband,
+							  (guint)redraw_rate);
+
+	gtk_experiment_transcript_set_use_cairo(transcript_proband,
+						config_get_transcript_use_cairo(SPEAKER_PROBAND));
+
 	transcript_proband->interactive_format.default_font =
 			config_get_transcript_default_format_font(SPEAKER_PROBAND);
 	if (config_get_transcript_default_format_text_color(SPEAKER_PROBAND, &color))
@@ -566,6 +692,10 @@ main(int argc, char *argv[])
 
 	format_selection_init();
 
+	/* media of sessions following a quick-opened one are preloaded */
+	gtk_vlc_player_set_preload_limit(GTK_VLC_PLAYER(player_widget),
+					 (guint)config_get_quickopen_preload());
+
 	refresh_quickopen_menu(GTK_MENU(quickopen_menu));
 
 	/* configure windows */
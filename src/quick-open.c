@@ -34,10 +34,35 @@
 
 #include <gtk/gtk.h>
 
+#include <gtk-vlc-player.h>
+#include <experiment-reader.h>
+
 #include "experiment-player.h"
 
+/** @private Delay before preloading the experiments following a quick-opened one */
+#define PRELOAD_DELAY	2 /* seconds */
+
+/**
+ * @private
+ * Transcript of an experiment preloaded after quick-opening another one
+ */
+typedef struct {
+	gchar			*trans_name;	/**< Filename of transcript */
+	GCancellable		*cancellable;	/**< Cancels loading the transcript */
+	ExperimentReader	*reader;	/**< Session or \c NULL if not (yet) loaded */
+} PreloadedSession;
+
 static inline gboolean quickopen_filter(const gchar *name);
 static gint quickopen_item_cmp(gconstpointer a, gconstpointer b);
+static gint quickopen_filename_cmp(gconstpointer a, gconstpointer b);
+static gchar *get_transcript_filename(const gchar *filename);
+
+static PreloadedSession *preloaded_session_take(const gchar *trans_name);
+static void preloaded_session_free(PreloadedSession *session);
+static void preload_transcript_ready_cb(GObject *source, GAsyncResult *result,
+					gpointer user_data);
+static gboolean preload_timeout_cb(gpointer user_data);
+static void schedule_preload(const gchar *filename);
 
 static void reconfigure_all_check_menu_items_cb(GtkWidget *widget, gpointer user_data);
 static void quickopen_item_on_activate(GtkWidget *widget, gpointer user_data);
@@ -45,6 +70,21 @@ static void quickopen_item_on_activate(GtkWidget *widget, gpointer user_data);
 GtkWidget *quickopen_menu,
 	  *quickopen_menu_empty_item;
 
+/** @private Filenames of movies in the quick-open menu */
+static gchar **fullnames = NULL;
+
+/** @private Preloaded transcripts, see \ref PreloadedSession */
+static GList *preloaded_sessions = NULL;
+/**
+ * @private
+ * Quick-opened session whose transcript was still being preloaded,
+ * it is loaded when ready
+ */
+static PreloadedSession *activated_session = NULL;
+/** @private Movie filename to preload the following experiments of */
+static gchar *preload_filename = NULL;
+static guint preload_timeout_id = 0;
+
 /*
  * GtkBuilder signal callbacks
  * NOTE: for some strange reason the parameters are switched
@@ -149,10 +189,15 @@ quickopen_item_cmp(gconstpointer a, gconstpointer b)
 			  gtk_menu_item_get_label(*(GtkMenuItem **)b));
 }
 
+static gint
+quickopen_filename_cmp(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0(*(const gchar **)a, *(const gchar **)b);
+}
+
 void
 refresh_quickopen_menu(GtkMenu *menu)
 {
-	static gchar		**fullnames = NULL;
 	static GPtrArray	*items = NULL;
 
 	int fullnames_n;
@@ -233,32 +278,254 @@ reconfigure_all_check_menu_items_cb(GtkWidget *widget, gpointer user_data)
 					  quickopen_item_on_activate, NULL);
 }
 
+/**
+ * @private
+ * Get filename of an experiment's transcript from its movie filename.
+ *
+ * @param filename Movie filename
+ * @return Newly allocated transcript filename or \c NULL
+ */
+static gchar *
+get_transcript_filename(const gchar *filename)
+{
+	gchar *trans_name, *p;
+
+	trans_name = g_strdup(filename);
+	trans_name = g_realloc(trans_name, strlen(trans_name) +
+					   sizeof(EXPERIMENT_TRANSCRIPT_EXT));
+	if ((p = g_strrstr(trans_name, ".")) == NULL) {
+		g_free(trans_name);
+		return NULL;
+	}
+	g_stpcpy(++p, EXPERIMENT_TRANSCRIPT_EXT);
+
+	return trans_name;
+}
+
 static void
 quickopen_item_on_activate(GtkWidget *widget, gpointer user_data)
 {
 	const gchar *filename = (const gchar *)user_data;
-	gchar *trans_name, *p;
+	gchar *trans_name;
+	PreloadedSession *session;
 
 	gtk_container_foreach(GTK_CONTAINER(quickopen_menu),
 			      reconfigure_all_check_menu_items_cb, widget);
 
+	/* the movie may have been preloaded by the player widget */
 	if (!load_media_file(filename)) {
 		/* FIXME */
 	}
 
-	trans_name = g_strdup(filename);
-	trans_name = g_realloc(trans_name, strlen(trans_name) +
-					   sizeof(EXPERIMENT_TRANSCRIPT_EXT));
-	if ((p = g_strrstr(trans_name, ".")) == NULL) {
-		g_free(trans_name);
+	trans_name = get_transcript_filename(filename);
+	if (trans_name == NULL) {
 		/* FIXME */
 		return;
 	}
-	g_stpcpy(++p, EXPERIMENT_TRANSCRIPT_EXT);
 
-	if (!load_transcript_file(trans_name)) {
-		/* FIXME */
+	session = preloaded_session_take(trans_name);
+	if (session == NULL && activated_session != NULL &&
+	    !g_strcmp0(activated_session->trans_name, trans_name)) {
+		/* activated again while still loading */
+		session = activated_session;
+		activated_session = NULL;
+	}
+
+	/* a session activated before may still be loading */
+	preloaded_session_free(activated_session);
+	activated_session = NULL;
+
+	if (session == NULL) {
+		load_transcript_file(trans_name);
+	} else if (session->reader != NULL) {
+		load_transcript_reader(session->reader);
+		preloaded_session_free(session);
+	} else {
+		/* finish the load in flight, see preload_transcript_ready_cb() */
+		load_transcript_adopt(session->cancellable);
+		activated_session = session;
 	}
 
 	g_free(trans_name);
+
+	schedule_preload(filename);
+}
+
+/*
+ * Preloading of the experiments following a quick-opened one,
+ * so switching to them is almost instant.
+ * Movies are parsed by the player widget, transcripts are loaded
+ * in the background. Their number is limited by configuration.
+ */
+
+/**
+ * @private
+ * Remove a transcript from the preloaded ones.
+ *
+ * @param trans_name Filename of transcript
+ * @return Preloaded session (ownership is passed) or \c NULL
+ */
+static PreloadedSession *
+preloaded_session_take(const gchar *trans_name)
+{
+	for (GList *cur = preloaded_sessions; cur != NULL; cur = cur->next) {
+		PreloadedSession *session = cur->data;
+
+		if (!g_strcmp0(session->trans_name, trans_name)) {
+			preloaded_sessions = g_list_delete_link(preloaded_sessions,
+								cur);
+			return session;
+		}
+	}
+
+	return NULL;
+}
+
+/** @private Free preloaded session, cancelling its load in flight */
+static void
+preloaded_session_free(PreloadedSession *session)
+{
+	if (session == NULL)
+		return;
+
+	g_cancellable_cancel(session->cancellable);
+	g_object_unref(session->cancellable);
+	if (session->reader != NULL)
+		g_object_unref(session->reader);
+	g_free(session->trans_name);
+	g_free(session);
+}
+
+/**
+ * @private
+ * The session is identified by its cancellable, since it may have been
+ * freed already.
+ * If the session has been quick-opened in the meantime, it is loaded
+ * into the widgets. Otherwise errors are ignored, they are reported
+ * when the experiment is opened.
+ */
+static void
+preload_transcript_ready_cb(GObject *source __attribute__((unused)),
+			    GAsyncResult *result, gpointer user_data)
+{
+	GCancellable *cancellable = G_CANCELLABLE(user_data);
+	ExperimentReader *reader;
+	GError *error = NULL;
+
+	reader = experiment_reader_new_finish(result, &error);
+
+	if (activated_session != NULL &&
+	    activated_session->cancellable == cancellable) {
+		/* GLib idle callbacks are invoked without the GDK lock */
+		gdk_threads_enter();
+
+		/* cancelled if another transcript was loaded meanwhile */
+		if (reader != NULL)
+			load_transcript_reader(reader);
+		else if (!g_error_matches(error, G_IO_ERROR,
+					  G_IO_ERROR_CANCELLED))
+			show_message_dialog_gerror(error);
+
+		preloaded_session_free(activated_session);
+		activated_session = NULL;
+
+		gdk_threads_leave();
+	} else {
+		for (GList *cur = preloaded_sessions; cur != NULL; cur = cur->next) {
+			PreloadedSession *session = cur->data;
+
+			if (session->cancellable == cancellable) {
+				session->reader = reader;
+				reader = NULL;
+				break;
+			}
+		}
+	}
+
+	if (reader != NULL)
+		g_object_unref(reader);
+	if (error != NULL)
+		g_error_free(error);
+	g_object_unref(cancellable);
+}
+
+/**
+ * @private
+ * Preload the experiments following \ref preload_filename in
+ * alphabetical order, releasing all others that were preloaded.
+ */
+static gboolean
+preload_timeout_cb(gpointer user_data __attribute__((unused)))
+{
+	GList *sessions = NULL;
+	GPtrArray *sorted;
+	guint n, i;
+
+	preload_timeout_id = 0;
+
+	sorted = g_ptr_array_new();
+	for (gchar **name = fullnames; name != NULL && *name != NULL; name++)
+		g_ptr_array_add(sorted, *name);
+	g_ptr_array_sort(sorted, quickopen_filename_cmp);
+
+	for (i = 0; i < sorted->len; i++)
+		if (!g_strcmp0(g_ptr_array_index(sorted, i), preload_filename))
+			break;
+
+	n = (guint)config_get_quickopen_preload();
+	for (i++; i < sorted->len && n > 0; i++, n--) {
+		const gchar *filename = g_ptr_array_index(sorted, i);
+		gchar *trans_name = get_transcript_filename(filename);
+		PreloadedSession *session;
+
+		if (trans_name == NULL)
+			continue;
+
+		gtk_vlc_player_preload_filename(GTK_VLC_PLAYER(player_widget),
+						filename);
+
+		session = preloaded_session_take(trans_name);
+		if (session == NULL) {
+			session = g_new0(PreloadedSession, 1);
+			session->trans_name = g_strdup(trans_name);
+			session->cancellable = g_cancellable_new();
+
+			experiment_reader_new_async(trans_name,
+						    EXPERIMENT_READER_FLAG_CACHE,
+						    session->cancellable,
+						    preload_transcript_ready_cb,
+						    g_object_ref(session->cancellable));
+		}
+		sessions = g_list_prepend(sessions, session);
+
+		g_free(trans_name);
+	}
+
+	g_ptr_array_free(sorted, TRUE);
+
+	g_list_free_full(preloaded_sessions,
+			 (GDestroyNotify)preloaded_session_free);
+	preloaded_sessions = sessions;
+
+	return FALSE;
+}
+
+/**
+ * @private
+ * Preload the experiments following a quick-opened one after
+ * \ref PRELOAD_DELAY, so preloading does not compete with opening it.
+ *
+ * @param filename Movie filename of quick-opened experiment
+ */
+static void
+schedule_preload(const gchar *filename)
+{
+	g_free(preload_filename);
+	preload_filename = g_strdup(filename);
+
+	if (preload_timeout_id != 0)
+		g_source_remove(preload_timeout_id);
+	preload_timeout_id = gdk_threads_add_timeout_seconds(PRELOAD_DELAY,
+							     preload_timeout_cb,
+							     NULL);
 }